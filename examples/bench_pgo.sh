@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+# examples/bench_pgo.sh — time a program built with plain -O2 against the
+# same program built with its own profile (--profile-use).
+#
+# Usage:
+#   ./examples/bench_pgo.sh [PROGRAM.cyp] [RUNS]
+#
+# Defaults: examples/collatz_branches.cyp, 6 runs of each build. Prints the
+# best and median wall time of each. CYPLANG overrides the compiler
+# (default build/bin/cyplang).
+
+set -eu
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+REPO_ROOT="$(cd "$SCRIPT_DIR/.." && pwd)"
+CYPLANG="${CYPLANG:-$REPO_ROOT/build/bin/cyplang}"
+PROGRAM="${1:-$SCRIPT_DIR/collatz_branches.cyp}"
+RUNS="${2:-6}"
+
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+"$CYPLANG" compile "$PROGRAM" --emit=exe -O2 -o "$work/plain"
+"$CYPLANG" compile "$PROGRAM" --emit=exe -O2 --profile-generate="$work/profile" -o "$work/train"
+"$work/train" > /dev/null
+"$CYPLANG" compile "$PROGRAM" --emit=exe -O2 --profile-use="$work/profile" -o "$work/fast"
+
+# Best and median of RUNS wall times of `$1`, in seconds.
+time_runs() {
+    local times=()
+    for _ in $(seq "$RUNS"); do
+        local start end
+        start=$(date +%s.%N)
+        "$1" > /dev/null
+        end=$(date +%s.%N)
+        times+=("$(awk -v s="$start" -v e="$end" 'BEGIN { print e - s }')")
+    done
+    printf '%s\n' "${times[@]}" | sort -n | awk '{ t[NR] = $1 } END { printf "best %.3f s, median %.3f s\n", t[1], t[int((NR + 1) / 2)] }'
+}
+
+echo "-O2:               $(time_runs "$work/plain")"
+echo "-O2 --profile-use: $(time_runs "$work/fast")"
@@ -0,0 +1,593 @@
+#include "bytecode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../middle/ir_analysis.h"
+
+
+static const char* const op_names[] = {
+#define BC_NAME(name) #name,
+    BC_OPCODES(BC_NAME)
+#undef BC_NAME
+};
+
+const char* bc_op_name(BcOp op) {
+    return op < BC_OP_COUNT ? op_names[op] : "?";
+}
+
+// ---------- builder state for one body ----------
+
+typedef struct {
+    int at;             // code offset of the operand to patch
+    const char* label;
+} Fixup;
+
+typedef struct {
+    BcProgram* program;
+    IrNameMap function_index;   // IR function name -> index in program->functions
+    const char* body;           // for messages
+    int errors;
+
+    int32_t* code;
+    int code_len, code_cap;
+
+    IrNameMap defs;             // IR name -> number of definitions
+    IrNameMap uses;             // IR name -> number of reads
+    IrNameMap regs;             // IR name -> register
+    IrNameMap consts;           // literal text -> constant register
+    VmValue* init;
+    IrType* types;
+    int reg_count, reg_cap;
+
+    IrNameMap labels;           // label -> code offset
+    Fixup* fixups;
+    int fixup_count, fixup_cap;
+
+    // Registers passed by the IR_PARAMs not yet consumed by an IR_CALL.
+    int pending[BC_MAX_CALL_ARGS];
+    int pending_count;
+} Builder;
+
+static void emit(Builder* b, int32_t word) {
+    if (b->code_len == b->code_cap) {
+        b->code_cap = b->code_cap ? b->code_cap * 2 : 64;
+        b->code = realloc(b->code, sizeof(int32_t) * (size_t)b->code_cap);
+    }
+    b->code[b->code_len++] = word;
+}
+
+static void compile_error(Builder* b, const IrInstruction* inst, const char* message, const char* detail) {
+    if (inst && inst->line > 0) {
+        fprintf(stderr, "erreur (%s, ligne %d): %s%s%s\n", b->body, inst->line, message,
+                detail ? " " : "", detail ? detail : "");
+    } else {
+        fprintf(stderr, "erreur (%s): %s%s%s\n", b->body, message, detail ? " " : "", detail ? detail : "");
+    }
+    b->errors++;
+}
+
+static int new_reg(Builder* b, IrType type) {
+    if (b->reg_count == b->reg_cap) {
+        b->reg_cap = b->reg_cap ? b->reg_cap * 2 : 32;
+        b->init = realloc(b->init, sizeof(VmValue) * (size_t)b->reg_cap);
+        b->types = realloc(b->types, sizeof(IrType) * (size_t)b->reg_cap);
+    }
+    memset(&b->init[b->reg_count], 0, sizeof(VmValue));
+    b->types[b->reg_count] = type;
+    return b->reg_count++;
+}
+
+// Register of an IR name, created (with `type`) on first sight.
+static int name_reg(Builder* b, const char* name, IrType type) {
+    int reg = ir_name_map_get(&b->regs, name, -1);
+    if (reg < 0) {
+        reg = new_reg(b, type);
+        ir_name_map_set(&b->regs, name, reg);
+    } else if (b->types[reg] == IR_TYPE_UNKNOWN) {
+        b->types[reg] = type;
+    }
+    return reg;
+}
+
+static IrType literal_type(const char* literal) {
+    if (literal[0] == '"') return IR_TYPE_CHAINE;
+    if (strcmp(literal, "true") == 0 || strcmp(literal, "false") == 0) return IR_TYPE_BOOLEEN;
+    if (literal[0] == '\'') return IR_TYPE_ENTIER;
+    return strchr(literal, '.') ? IR_TYPE_REEL : IR_TYPE_ENTIER;
+}
+
+static int const_reg(Builder* b, const char* literal) {
+    int reg = ir_name_map_get(&b->consts, literal, -1);
+    if (reg >= 0) return reg;
+
+    IrType type = literal_type(literal);
+    reg = new_reg(b, type);
+    ir_name_map_set(&b->consts, literal, reg);
+    VmValue* v = &b->init[reg];
+    switch (type) {
+        case IR_TYPE_CHAINE: {
+            size_t len = strlen(literal);
+            char* text = malloc(len);
+            memcpy(text, literal + 1, len - 2);
+            text[len - 2] = '\0';
+            BcProgram* p = b->program;
+            p->strings = realloc(p->strings, sizeof(char*) * (size_t)(p->string_count + 1));
+            p->strings[p->string_count++] = text;
+            v->s = text;
+            break;
+        }
+        case IR_TYPE_BOOLEEN: v->i = literal[0] == 't'; break;
+        case IR_TYPE_REEL:    v->f = strtod(literal, NULL); break;
+        default:              v->i = literal[0] == '\'' ? (unsigned char)literal[1]
+                                                        : (int32_t)strtol(literal, NULL, 10); break;
+    }
+    return reg;
+}
+
+// Register holding an operand (name or literal).
+static int operand(Builder* b, const char* arg) {
+    if (!arg) return const_reg(b, "0");
+    if (ir_is_literal(arg)) return const_reg(b, arg);
+    return name_reg(b, arg, IR_TYPE_UNKNOWN);
+}
+
+// Register written by `inst`. A register still waiting in `pending` keeps
+// the value it had at its IR_PARAM: it is copied aside before the write.
+static int dest(Builder* b, const IrInstruction* inst) {
+    int reg = name_reg(b, inst->result, inst->type);
+    for (int i = 0; i < b->pending_count; i++) {
+        if (b->pending[i] != reg) continue;
+        int saved = new_reg(b, b->types[reg]);
+        emit(b, BC_MOV);
+        emit(b, saved);
+        emit(b, reg);
+        for (int j = i; j < b->pending_count; j++) {
+            if (b->pending[j] == reg) b->pending[j] = saved;
+        }
+        break;
+    }
+    return reg;
+}
+
+static void emit_jump_target(Builder* b, const char* label) {
+    if (b->fixup_count == b->fixup_cap) {
+        b->fixup_cap = b->fixup_cap ? b->fixup_cap * 2 : 16;
+        b->fixups = realloc(b->fixups, sizeof(Fixup) * (size_t)b->fixup_cap);
+    }
+    b->fixups[b->fixup_count].at = b->code_len;
+    b->fixups[b->fixup_count].label = label;
+    b->fixup_count++;
+    emit(b, -1);
+}
+
+// ---------- instruction selection ----------
+
+// `name` is written once and read once: its value can go straight to its
+// only reader.
+static int single_use_temp(Builder* b, const char* name) {
+    return name && !ir_is_literal(name) && ir_name_map_get(&b->defs, name, 0) == 1 &&
+           ir_name_map_get(&b->uses, name, 0) == 1;
+}
+
+// `next` is `z = t` for the `t` that `inst` computes, with the same type:
+// `inst` can write z itself.
+static const IrInstruction* coalesced_copy(Builder* b, const IrInstruction* inst) {
+    const IrInstruction* next = inst->next;
+    if (!next || next->op != IR_ASSIGN || !inst->result || !next->arg1) return NULL;
+    if (strcmp(next->arg1, inst->result) != 0 || next->type != inst->type) return NULL;
+    return single_use_temp(b, inst->result) ? next : NULL;
+}
+
+static int is_reel(Builder* b, int reg) {
+    return b->types[reg] == IR_TYPE_REEL;
+}
+
+static BcOp arith_op(IrOpType op, int reel) {
+    switch (op) {
+        case IR_ADD: return reel ? BC_ADD_F : BC_ADD_I;
+        case IR_SUB: return reel ? BC_SUB_F : BC_SUB_I;
+        case IR_MUL: return reel ? BC_MUL_F : BC_MUL_I;
+        case IR_DIV: return reel ? BC_DIV_F : BC_DIV_I;
+        default:     return reel ? BC_MOD_F : BC_MOD_I;
+    }
+}
+
+static BcOp compare_op(IrOpType op, IrType type) {
+    int base;
+    switch (op) {
+        case IR_EQ:  base = 0; break;
+        case IR_NEQ: base = 1; break;
+        case IR_LT:  base = 2; break;
+        case IR_LE:  base = 3; break;
+        case IR_GT:  base = 4; break;
+        default:     base = 5; break;
+    }
+    if (type == IR_TYPE_CHAINE) return base == 0 ? BC_EQ_S : base == 1 ? BC_NE_S : BC_OP_COUNT;
+    return (BcOp)((type == IR_TYPE_REEL ? BC_EQ_F : BC_EQ_I) + base);
+}
+
+// `copy`, if not NULL, is the `z = t` that receives the call's result.
+static void compile_call(Builder* b, const IrInstruction* inst, const IrInstruction* copy) {
+    const IrInstruction* target = copy ? copy : inst;
+    int argc = inst->arg2 ? atoi(inst->arg2) : b->pending_count;
+    if (argc > b->pending_count) argc = b->pending_count;
+    int first = b->pending_count - argc;
+    int args[BC_MAX_CALL_ARGS];
+    memcpy(args, b->pending + first, sizeof(int) * (size_t)argc);
+    b->pending_count = first;
+
+    if (strcmp(inst->arg1, "afficher") == 0) {
+        int result = inst->result ? dest(b, target) : new_reg(b, IR_TYPE_ENTIER);
+        emit(b, BC_PRINT);
+        emit(b, result);
+        emit(b, argc);
+        for (int i = 0; i < argc; i++) {
+            emit(b, args[i]);
+            emit(b, b->types[args[i]]);
+        }
+        return;
+    }
+
+    int index = ir_name_map_get(&b->function_index, inst->arg1, -1);
+    if (index < 0) {
+        compile_error(b, inst, "fonction inconnue", inst->arg1);
+        return;
+    }
+    if (b->program->functions[index].param_count != argc) {
+        compile_error(b, inst, "nombre d'arguments incorrect pour", inst->arg1);
+        return;
+    }
+    int result = inst->result ? dest(b, target) : new_reg(b, IR_TYPE_UNKNOWN);
+    emit(b, BC_CALL);
+    emit(b, result);
+    emit(b, index);
+    emit(b, argc);
+    for (int i = 0; i < argc; i++) emit(b, args[i]);
+}
+
+// Compiles `inst` and returns the last IR instruction it consumed (`inst`,
+// or the following one when the pair was folded).
+static const IrInstruction* compile_inst(Builder* b, const IrInstruction* inst) {
+    const IrInstruction* copy = NULL;
+    switch (inst->op) {
+        case IR_ASSIGN: {
+            // Names bound to their literal (see compile_body) need no code.
+            if (ir_is_literal(inst->arg1) && ir_name_map_get(&b->regs, inst->result, -1) ==
+                                             ir_name_map_get(&b->consts, inst->arg1, -2)) {
+                break;
+            }
+            int src = operand(b, inst->arg1);
+            int dst = dest(b, inst);
+            if (dst != src) {
+                emit(b, BC_MOV); emit(b, dst); emit(b, src);
+            }
+            break;
+        }
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_MOD: {
+            int l = operand(b, inst->arg1);
+            int r = operand(b, inst->arg2);
+            copy = coalesced_copy(b, inst);
+            int dst = dest(b, copy ? copy : inst);
+            emit(b, arith_op(inst->op, inst->type == IR_TYPE_REEL)); emit(b, dst); emit(b, l); emit(b, r);
+            break;
+        }
+        case IR_NEG:
+        case IR_NOT:
+        case IR_ITOF:
+        case IR_FTOI: {
+            int src = operand(b, inst->arg1);
+            copy = coalesced_copy(b, inst);
+            int dst = dest(b, copy ? copy : inst);
+            BcOp op = inst->op == IR_NOT ? BC_NOT : inst->op == IR_ITOF ? BC_ITOF : inst->op == IR_FTOI ? BC_FTOI
+                    : inst->type == IR_TYPE_REEL ? BC_NEG_F : BC_NEG_I;
+            emit(b, op); emit(b, dst); emit(b, src);
+            break;
+        }
+        case IR_AND:
+        case IR_OR: {
+            int l = operand(b, inst->arg1);
+            int r = operand(b, inst->arg2);
+            copy = coalesced_copy(b, inst);
+            int dst = dest(b, copy ? copy : inst);
+            emit(b, inst->op == IR_AND ? BC_AND : BC_OR); emit(b, dst); emit(b, l); emit(b, r);
+            break;
+        }
+        case IR_EQ:
+        case IR_NEQ:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE: {
+            int l = operand(b, inst->arg1);
+            int r = operand(b, inst->arg2);
+            IrType type = is_reel(b, l) || is_reel(b, r) ? IR_TYPE_REEL : b->types[l];
+            BcOp op = compare_op(inst->op, type);
+            if (op == BC_OP_COUNT) {
+                compile_error(b, inst, "seules = et != comparent des chaines", NULL);
+                break;
+            }
+            const IrInstruction* branch = inst->next;
+            if (op <= BC_GE_F && branch && branch->op == IR_IF_GOTO && branch->arg1 &&
+                strcmp(branch->arg1, inst->result) == 0 && single_use_temp(b, inst->result)) {
+                emit(b, BC_JF_EQ_I + (op - BC_EQ_I)); emit(b, l); emit(b, r);
+                emit_jump_target(b, branch->label);
+                return branch;
+            }
+            copy = coalesced_copy(b, inst);
+            int dst = dest(b, copy ? copy : inst);
+            emit(b, op); emit(b, dst); emit(b, l); emit(b, r);
+            break;
+        }
+        case IR_LABEL:
+            ir_name_map_set(&b->labels, inst->label, b->code_len);
+            break;
+        case IR_GOTO:
+            // A label already placed is behind us: the jump closes a loop.
+            emit(b, ir_name_map_get(&b->labels, inst->label, -1) >= 0 ? BC_LOOP : BC_JMP);
+            emit_jump_target(b, inst->label);
+            break;
+        case IR_IF_GOTO: {
+            int cond = operand(b, inst->arg1);
+            emit(b, BC_JMP_IF_NOT); emit(b, cond);
+            emit_jump_target(b, inst->label);
+            break;
+        }
+        case IR_PARAM:
+            if (b->pending_count == BC_MAX_CALL_ARGS) {
+                compile_error(b, inst, "trop d'arguments", NULL);
+                break;
+            }
+            b->pending[b->pending_count++] = operand(b, inst->arg1);
+            break;
+        case IR_CALL:
+            copy = coalesced_copy(b, inst);
+            compile_call(b, inst, copy);
+            break;
+        case IR_RETURN:
+            if (inst->arg1) {
+                int src = operand(b, inst->arg1);
+                emit(b, BC_RET); emit(b, src);
+            } else {
+                emit(b, BC_RET0);
+            }
+            break;
+        case IR_FUNC_BEGIN:
+        case IR_FUNC_END:
+            break;
+        case IR_ARRAY_ACCESS:
+        case IR_ARRAY_ASSIGN:
+            compile_error(b, inst, "les tableaux ne sont pas pris en charge par la VM", NULL);
+            break;
+    }
+    return copy ? copy : inst;
+}
+
+// Compiles one body into `out`. `func` is NULL for the global code.
+static void compile_body(Builder* b, BcFunction* out, const IrFunction* func, IrInstruction* list,
+                         const IrDecl* decls) {
+    b->body = func ? func->name : "global";
+    b->code = NULL;
+    b->code_len = b->code_cap = 0;
+    b->init = NULL;
+    b->types = NULL;
+    b->reg_count = b->reg_cap = 0;
+    b->fixups = NULL;
+    b->fixup_count = b->fixup_cap = 0;
+    b->pending_count = 0;
+    ir_name_map_init(&b->defs, 64);
+    ir_name_map_init(&b->uses, 64);
+    ir_name_map_init(&b->regs, 64);
+    ir_name_map_init(&b->consts, 16);
+    ir_name_map_init(&b->labels, 16);
+
+    int formals = func ? func->param_count : 0;
+    ir_count_defs(list, formals, &b->defs);
+    int formals_left = formals;
+    for (IrInstruction* inst = list; inst; inst = inst->next) {
+        if (inst->op == IR_FUNC_BEGIN) continue;
+        if (inst->op == IR_PARAM && formals_left > 0) {
+            formals_left--;
+            continue;
+        }
+        formals_left = 0;
+        const char* used[3];
+        int n = ir_inst_uses(inst, used);
+        for (int i = 0; i < n; i++) (*ir_name_map_slot(&b->uses, used[i]))++;
+    }
+
+    // Formals first, then every declared or defined name with its type, so
+    // operand types are known wherever the name is first read. A name whose
+    // only definition is a literal of its own type shares the constant's
+    // register.
+    for (int i = 0; i < formals; i++) {
+        name_reg(b, func->params[i], func->param_types ? func->param_types[i] : IR_TYPE_ENTIER);
+    }
+    for (const IrDecl* d = decls; d; d = d->next) name_reg(b, d->name, d->type);
+    for (IrInstruction* inst = list; inst; inst = inst->next) {
+        const char* def = ir_inst_def(inst);
+        if (!def) continue;
+        if (inst->op == IR_ASSIGN && ir_is_literal(inst->arg1) && ir_name_map_get(&b->defs, def, 0) == 1 &&
+            ir_name_map_get(&b->regs, def, -1) < 0 && literal_type(inst->arg1) == inst->type) {
+            ir_name_map_set(&b->regs, def, const_reg(b, inst->arg1));
+            continue;
+        }
+        name_reg(b, def, inst->type);
+    }
+
+    formals_left = formals;
+    for (const IrInstruction* inst = list; inst; inst = inst->next) {
+        if (inst->op == IR_FUNC_BEGIN) continue;
+        if (inst->op == IR_PARAM && formals_left > 0) {
+            formals_left--;
+            continue;
+        }
+        formals_left = 0;
+        inst = compile_inst(b, inst);
+    }
+    emit(b, BC_RET0);
+
+    for (int i = 0; i < b->fixup_count; i++) {
+        int target = ir_name_map_get(&b->labels, b->fixups[i].label, -1);
+        if (target < 0) {
+            compile_error(b, NULL, "etiquette inconnue", b->fixups[i].label);
+            target = b->code_len - 1; // the trailing RET0
+        }
+        b->code[b->fixups[i].at] = target;
+    }
+
+    for (int r = 0; r < b->reg_count; r++) {
+        if (b->types[r] == IR_TYPE_UNKNOWN) b->types[r] = IR_TYPE_ENTIER;
+    }
+    out->param_count = formals;
+    out->reg_count = b->reg_count;
+    out->init = b->init;
+    out->reg_types = b->types;
+    out->code = b->code;
+    out->code_len = b->code_len;
+
+    free(b->fixups);
+    ir_name_map_free(&b->defs);
+    ir_name_map_free(&b->uses);
+    ir_name_map_free(&b->regs);
+    ir_name_map_free(&b->consts);
+    ir_name_map_free(&b->labels);
+}
+
+BcProgram* bc_compile(const IRProgram* ir) {
+    int count = 0;
+    for (IrFunction* f = ir->functions; f; f = f->next) count++;
+
+    BcProgram* program = calloc(1, sizeof(BcProgram));
+    program->function_count = count + 1;
+    program->main_index = count;
+    program->functions = calloc((size_t)program->function_count, sizeof(BcFunction));
+
+    Builder b;
+    memset(&b, 0, sizeof(b));
+    b.program = program;
+    ir_name_map_init(&b.function_index, count + 1);
+
+    // Signatures first: calls check their argument count against them.
+    int index = 0;
+    for (IrFunction* f = ir->functions; f; f = f->next, index++) {
+        program->functions[index].name = strdup(f->name);
+        program->functions[index].param_count = f->param_count;
+        ir_name_map_set(&b.function_index, f->name, index);
+    }
+    program->functions[count].name = strdup("main");
+
+    index = 0;
+    for (IrFunction* f = ir->functions; f; f = f->next, index++) {
+        compile_body(&b, &program->functions[index], f, f->instructions, f->decls);
+    }
+    compile_body(&b, &program->functions[count], NULL, ir->global_instructions, ir->global_decls);
+    ir_name_map_free(&b.function_index);
+
+    if (b.errors > 0) {
+        bc_free(program);
+        return NULL;
+    }
+    return program;
+}
+
+void bc_free(BcProgram* program) {
+    if (!program) return;
+    for (int i = 0; i < program->function_count; i++) {
+        BcFunction* f = &program->functions[i];
+        free(f->name);
+        free(f->init);
+        free(f->reg_types);
+        free(f->code);
+    }
+    free(program->functions);
+    for (int i = 0; i < program->string_count; i++) free(program->strings[i]);
+    free(program->strings);
+    free(program);
+}
+
+// ---------- disassembly ----------
+
+// Operand count of the fixed-size instructions; CALL and PRINT are variable.
+static int operand_count(BcOp op) {
+    switch (op) {
+        case BC_JMP:
+        case BC_LOOP:
+        case BC_RET:
+            return 1;
+        case BC_MOV:
+        case BC_NEG_I:
+        case BC_NEG_F:
+        case BC_NOT:
+        case BC_ITOF:
+        case BC_FTOI:
+        case BC_JMP_IF_NOT:
+            return 2;
+        case BC_RET0:
+            return 0;
+        default:
+            return 3;
+    }
+}
+
+static void print_register(int reg, FILE* out) {
+    fprintf(out, " r%d", reg);
+}
+
+void bc_print(const BcProgram* program, FILE* out) {
+    for (int i = 0; i < program->function_count; i++) {
+        const BcFunction* f = &program->functions[i];
+        fprintf(out, "function %s: %d params, %d registers\n", f->name, f->param_count, f->reg_count);
+        // Preset (constant) registers; zero ones are left out.
+        for (int r = 0; r < f->reg_count; r++) {
+            const VmValue* v = &f->init[r];
+            if (f->reg_types[r] == IR_TYPE_REEL && v->f != 0.0) {
+                fprintf(out, "    r%d = %g\n", r, v->f);
+            } else if (f->reg_types[r] == IR_TYPE_CHAINE && v->s) {
+                fprintf(out, "    r%d = \"%s\"\n", r, v->s);
+            } else if (f->reg_types[r] != IR_TYPE_REEL && f->reg_types[r] != IR_TYPE_CHAINE && v->i != 0) {
+                fprintf(out, "    r%d = %d\n", r, v->i);
+            }
+        }
+        int pc = 0;
+        while (pc < f->code_len) {
+            BcOp op = (BcOp)f->code[pc];
+            fprintf(out, "  %4d  %-10s", pc, bc_op_name(op));
+            pc++;
+            if (op == BC_CALL) {
+                int argc = f->code[pc + 2];
+                print_register(f->code[pc], out);
+                fprintf(out, " %s", program->functions[f->code[pc + 1]].name);
+                for (int a = 0; a < argc; a++) print_register(f->code[pc + 3 + a], out);
+                pc += 3 + argc;
+            } else if (op == BC_PRINT) {
+                int argc = f->code[pc + 1];
+                print_register(f->code[pc], out);
+                for (int a = 0; a < argc; a++) print_register(f->code[pc + 2 + 2 * a], out);
+                pc += 2 + 2 * argc;
+            } else if (op == BC_JMP || op == BC_LOOP) {
+                fprintf(out, " @%d", f->code[pc]);
+                pc++;
+            } else if (op == BC_JMP_IF_NOT) {
+                print_register(f->code[pc], out);
+                fprintf(out, " @%d", f->code[pc + 1]);
+                pc += 2;
+            } else if (op >= BC_JF_EQ_I && op <= BC_JF_GE_F) {
+                print_register(f->code[pc], out);
+                print_register(f->code[pc + 1], out);
+                fprintf(out, " @%d", f->code[pc + 2]);
+                pc += 3;
+            } else {
+                int n = operand_count(op);
+                for (int k = 0; k < n; k++) print_register(f->code[pc + k], out);
+                pc += n;
+            }
+            fprintf(out, "\n");
+        }
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../middle/ir_generator.h"
+
+// Register bytecode for the in-process interpreter (vm.h), compiled from a
+// typed IRProgram (ir_infer_types must have run).
+//
+// Every IR name and literal of a body gets a register of its frame; formals
+// are registers 0..param_count-1 and literals are constant registers whose
+// value is preset on entry. Operations are specialised on the operand type
+// (ADD_I / ADD_F, ...), so the VM never inspects types at run time.
+//
+// A few IR idioms are folded while compiling: a name assigned a literal once
+// reads the constant register directly, `t = x op y; z = t` computes into z,
+// and a comparison feeding only the next `if !t goto` becomes a JF_* branch.
+//
+// Code is an int32_t stream: an opcode followed by its operands.
+//   a, b, c     registers (a is the destination)
+//   target      code offset in the same function
+//   func        index into BcProgram.functions
+//   n, args...  argument count, then the argument registers
+//               (PRINT: register and IrType pairs)
+
+#define BC_OPCODES(X)                                                         \
+    X(MOV)          /* a b        a = b                                    */ \
+    X(ADD_I) X(SUB_I) X(MUL_I) X(DIV_I) X(MOD_I)    /* a b c  a = b op c   */ \
+    X(ADD_F) X(SUB_F) X(MUL_F) X(DIV_F) X(MOD_F)                              \
+    X(NEG_I) X(NEG_F) X(NOT)                        /* a b    a = op b     */ \
+    X(AND) X(OR)                                                              \
+    X(EQ_I) X(NE_I) X(LT_I) X(LE_I) X(GT_I) X(GE_I)                           \
+    X(EQ_F) X(NE_F) X(LT_F) X(LE_F) X(GT_F) X(GE_F)                           \
+    X(EQ_S) X(NE_S)                                                           \
+    X(ITOF) X(FTOI)                                                           \
+    X(JMP)          /* target                                              */ \
+    X(LOOP)         /* target     backward JMP, counted as a loop back-edge    */ \
+    X(JMP_IF_NOT)   /* a target   jump unless a                            */ \
+    /* compare-and-branch: b c target, jump unless `b op c` (same order as EQ_I..GE_F) */ \
+    X(JF_EQ_I) X(JF_NE_I) X(JF_LT_I) X(JF_LE_I) X(JF_GT_I) X(JF_GE_I)         \
+    X(JF_EQ_F) X(JF_NE_F) X(JF_LT_F) X(JF_LE_F) X(JF_GT_F) X(JF_GE_F)         \
+    X(CALL)         /* a func n args...                                    */ \
+    X(PRINT)        /* a n (reg type)...   afficher, a = chars written     */ \
+    X(RET)          /* a                                                   */ \
+    X(RET0)         /* return a zero value                                 */
+
+#define BC_ENUM(name) BC_##name,
+typedef enum { BC_OPCODES(BC_ENUM) BC_OP_COUNT } BcOp;
+#undef BC_ENUM
+
+// Most arguments a CALL or PRINT can take.
+#define BC_MAX_CALL_ARGS 64
+
+// One register. The bytecode fixes which member is live.
+typedef union {
+    int32_t i;          // entier, booleen (0 / 1), caractere
+    double f;           // reel
+    const char* s;      // chaine (points into BcProgram.strings)
+} VmValue;
+
+typedef struct {
+    char* name;
+    int param_count;
+    int reg_count;
+    VmValue* init;          // reg_count values: constants set, everything else zero
+    IrType* reg_types;
+    int32_t* code;
+    int code_len;
+} BcFunction;
+
+typedef struct {
+    BcFunction* functions;  // user functions in source order, then the global code
+    int function_count;
+    int main_index;
+    char** strings;         // string literals, unquoted
+    int string_count;
+} BcProgram;
+
+// Returns NULL and reports on stderr when the program uses something the VM
+// does not support (arrays, unknown functions, ...).
+BcProgram* bc_compile(const IRProgram* program);
+void bc_free(BcProgram* program);
+// Disassembly, one instruction per line.
+void bc_print(const BcProgram* program, FILE* out);
+const char* bc_op_name(BcOp op);
+
+#endif // BYTECODE_H
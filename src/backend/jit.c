@@ -0,0 +1,133 @@
+#include "jit.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Orc.h>
+#include <llvm-c/Target.h>
+
+struct JitSession {
+    LLVMOrcLLJITRef jit;
+    LLVMOrcJITDylibRef dylib;   // the JIT's main dylib, searched by lookups
+};
+
+// Reports `err` (consumed) with `what` as context. Returns 1.
+static int report(const char* what, LLVMErrorRef err) {
+    char* message = LLVMGetErrorMessage(err);
+    fprintf(stderr, "JIT: %s: %s\n", what, message);
+    LLVMDisposeErrorMessage(message);
+    return 1;
+}
+
+JitSession* jit_session_create(void) {
+    if (LLVMInitializeNativeTarget() != 0 || LLVMInitializeNativeAsmPrinter() != 0) {
+        fprintf(stderr, "JIT: native target unavailable\n");
+        return NULL;
+    }
+
+    JitSession* session = calloc(1, sizeof(JitSession));
+    LLVMErrorRef err = LLVMOrcCreateLLJIT(&session->jit, NULL);
+    if (err) {
+        report("cannot create LLJIT", err);
+        free(session);
+        return NULL;
+    }
+    session->dylib = LLVMOrcLLJITGetMainJITDylib(session->jit);
+
+    // printf and the rest of libc come from the running process.
+    LLVMOrcDefinitionGeneratorRef process = NULL;
+    err = LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(
+        &process, LLVMOrcLLJITGetGlobalPrefix(session->jit), NULL, NULL);
+    if (err) {
+        report("cannot search the host process", err);
+        jit_session_dispose(session);
+        return NULL;
+    }
+    LLVMOrcJITDylibAddGenerator(session->dylib, process);
+    return session;
+}
+
+void jit_session_dispose(JitSession* session) {
+    if (!session) return;
+    LLVMErrorRef err = LLVMOrcDisposeLLJIT(session->jit);
+    if (err) report("cannot shut down", err);
+    free(session);
+}
+
+int jit_run(JitSession* session, IRProgram* program, const EmitOptions* options, int* exit_code) {
+    LLVMOrcThreadSafeContextRef tsc = LLVMOrcCreateNewThreadSafeContext();
+    LLVMModuleRef module =
+        emit_llvm_module(program, "cyplang_module", LLVMOrcThreadSafeContextGetContext(tsc), options);
+    if (!module || emit_llvm_optimize(module, options) != 0) {
+        if (module) LLVMDisposeModule(module);
+        LLVMOrcDisposeThreadSafeContext(tsc);
+        return 1;
+    }
+    // The module now owns a reference to the context.
+    LLVMOrcThreadSafeModuleRef tsm = LLVMOrcCreateNewThreadSafeModule(module, tsc);
+    LLVMOrcDisposeThreadSafeContext(tsc);
+
+    // Every program defines `main`: give this one its own tracker so its
+    // symbols can be dropped before the next program is added.
+    LLVMOrcResourceTrackerRef tracker = LLVMOrcJITDylibCreateResourceTracker(session->dylib);
+    int rc = 0;
+    LLVMErrorRef err = LLVMOrcLLJITAddLLVMIRModuleWithRT(session->jit, tracker, tsm);
+    if (err) {
+        LLVMOrcDisposeThreadSafeModule(tsm);
+        rc = report("cannot add module", err);
+    }
+
+    LLVMOrcExecutorAddress entry = 0;
+    if (rc == 0 && (err = LLVMOrcLLJITLookup(session->jit, &entry, "main"))) {
+        rc = report("cannot compile main", err);
+    }
+    if (rc == 0) {
+        int (*main_fn)(void) = (int (*)(void))(uintptr_t)entry;
+        *exit_code = main_fn();
+        fflush(stdout);
+    }
+
+    err = LLVMOrcResourceTrackerRemove(tracker);
+    if (err) rc = report("cannot release module", err);
+    LLVMOrcReleaseResourceTracker(tracker);
+    return rc;
+}
+
+JitEntry jit_compile_entry(JitSession* session, IRProgram* program, IrFunction* func,
+                           const EmitOptions* options) {
+    size_t len = strlen("cyp_entry_") + strlen(func->name) + 1;
+    char* entry_name = malloc(len);
+    snprintf(entry_name, len, "cyp_entry_%s", func->name);
+
+    LLVMOrcThreadSafeContextRef tsc = LLVMOrcCreateNewThreadSafeContext();
+    LLVMModuleRef module =
+        emit_llvm_entry_module(program, func, entry_name, LLVMOrcThreadSafeContextGetContext(tsc));
+    if (emit_llvm_optimize(module, options) != 0) {
+        LLVMDisposeModule(module);
+        LLVMOrcDisposeThreadSafeContext(tsc);
+        free(entry_name);
+        return NULL;
+    }
+    LLVMOrcThreadSafeModuleRef tsm = LLVMOrcCreateNewThreadSafeModule(module, tsc);
+    LLVMOrcDisposeThreadSafeContext(tsc);
+
+    // Entries live as long as the session: no tracker of their own.
+    JitEntry entry = NULL;
+    LLVMOrcExecutorAddress address = 0;
+    LLVMErrorRef err = LLVMOrcLLJITAddLLVMIRModule(session->jit, session->dylib, tsm);
+    if (err) {
+        LLVMOrcDisposeThreadSafeModule(tsm);
+        report("cannot add module", err);
+    } else if ((err = LLVMOrcLLJITLookup(session->jit, &address, entry_name))) {
+        report("cannot compile function", err);
+    } else {
+        entry = (JitEntry)(uintptr_t)address;
+    }
+    free(entry_name);
+    return entry;
+}
@@ -0,0 +1,35 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "llvm_emitter.h"
+
+// In-process execution of the LLVM module built by emit_llvm_module(),
+// through LLVM's ORC LLJIT. Undefined symbols (printf, ...) resolve to the
+// host process.
+//
+// A session outlives the programs it runs: each one is added under its own
+// resource tracker and removed after `main` returns, so a server can keep
+// the JIT (target setup, process symbol table) warm between programs.
+typedef struct JitSession JitSession;
+
+// Returns NULL and reports on stderr if the host target cannot be set up.
+JitSession* jit_session_create(void);
+void jit_session_dispose(JitSession* session);
+
+// Compiles `program`, optimised per `options`, and calls its `main`. Returns 0 and stores main's
+// result in `exit_code`, or non-zero after reporting an error on stderr.
+int jit_run(JitSession* session, IRProgram* program, const EmitOptions* options, int* exit_code);
+
+// Native code for one function, called through the slot convention of
+// emit_llvm_entry_module(): `args` holds one 8-byte slot per parameter.
+typedef void (*JitEntry)(const void* args, void* result);
+
+// Compiles `func` (and private copies of its callees), optimised per
+// `options`, into the session and returns its entry, which stays valid
+// until the session is disposed.
+// Returns NULL after reporting an error. Safe to call from a thread other
+// than the one that created the session.
+JitEntry jit_compile_entry(JitSession* session, IRProgram* program, IrFunction* func,
+                           const EmitOptions* options);
+
+#endif // JIT_H
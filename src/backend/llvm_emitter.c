@@ -1,35 +1,115 @@
 #include "llvm_emitter.h"
 
 #include <ctype.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
 
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
 #include <llvm-c/Core.h>
+#include <llvm-c/DebugInfo.h>
+#include <llvm-c/IRReader.h>
+#include <llvm-c/Linker.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
 
-// ---------- symbol table: maps an IR name ("t0", "x", ...) to its alloca + type ----------
+#include "../middle/ir_analysis.h"
+#include "../middle/work_pool.h"
+#include "llvm_runtime.h"
+#include "native_link.h"
+
+// ---------- symbol table: maps an IR name ("t0", "x", ...) to its storage + type ----------
+
+// One table per function scope: open addressing over Symbol pointers, keyed
+// by the name's hash (kept in the Symbol, so probes rarely call strcmp). The
+// Symbols come from an arena of blocks that sym_reset() rewinds, keeping the
+// blocks for the next function.
+//
+// A name defined once, where that definition dominates every use, is an SSA
+// symbol: it maps straight to the LLVMValueRef computed for it. Any other
+// name lives in an alloca, which LLVM's mem2reg promotes later.
 
 typedef struct Symbol {
-    char* name;
-    LLVMValueRef alloca;
-    LLVMTypeRef type;   // i32 or double (Phase 2.4)
-    struct Symbol* next;
+    const char* name;   // borrowed from the IR, which outlives emission
+    unsigned int hash;
+    LLVMValueRef alloca;    // NULL for an SSA symbol
+    LLVMValueRef value;     // SSA symbol: its value, NULL until defined
+    LLVMTypeRef type;   // i32, double, i1 or ptr (SSA: set when defined)
 } Symbol;
 
+#define SYMBOL_BLOCK_SIZE 256
+
+typedef struct SymbolBlock {
+    struct SymbolBlock* next;
+    int used;
+    Symbol items[SYMBOL_BLOCK_SIZE];
+} SymbolBlock;
+
+typedef struct {
+    Symbol** slots;         // capacity entries (a power of two), NULL = free
+    int capacity;
+    int count;
+    SymbolBlock* blocks;    // arena, first block first
+    SymbolBlock* current;   // block being filled
+} SymbolTable;
+
 #define MAX_PENDING_ARGS 16
 
 typedef struct {
+    IRProgram* program;     // the one being emitted
+    IRProgram* const* programs;     // every program of the build, for the signatures of called functions
+    int program_count;
     LLVMContextRef ctx;
     LLVMModuleRef module;
     LLVMBuilderRef builder;
     LLVMTypeRef i32_type;
     LLVMTypeRef double_type;
-    LLVMTypeRef ptr_type;   // i8* / opaque ptr — for strings and printf
+    LLVMTypeRef bool_type;  // i1, for booleen
+    LLVMTypeRef ptr_type;   // i8* / opaque ptr — for strings
+    int owns_ctx;           // ctx was created by emitter_init
     LLVMValueRef current_function;
-    Symbol* symbols;
+    SymbolTable symbols;    // the current function's names
+    // String constant pool: contents -> index in string_values, one private
+    // unnamed_addr global per distinct string of the module.
+    IrNameMap strings;
+    LLVMValueRef* string_values;    // pointer to each string's first char
+    int string_count;
+    // Labels of the current body: label -> index + 1 in label_blocks.
+    IrNameMap labels;
+    LLVMBasicBlockRef* label_blocks;
+    int label_count;
+    // Profile-guided optimisation (EmitOptions.profile_*).
+    int instrument;                 // count into `counters`
+    const Profile* profile;
+    LLVMValueRef counters;          // current body: [1 + 2 * branches] x i64, entries first
+    const ProfileFunction* body_profile;    // current body's record, if it matches
+    int branch_index;               // `if !t goto`s emitted so far in the body
+    // Loop hints of the current body (ir_indvars), and the hint of the loop
+    // whose header block is being emitted, if any.
+    const IrLoopHint* loop_hints;
+    const IrLoopHint* header_hint;
+    // Debug info (EmitOptions.debug_info): the unit's source file, and the
+    // subprogram of the body whose lines the builder stamps.
+    LLVMDIBuilderRef di_builder;
+    LLVMMetadataRef di_file;
+    LLVMMetadataRef di_scope;
+    int di_optimized;
+    // EmitOptions.cpu / features, stamped on every defined function (NULL: not asked for).
+    const char* target_cpu;
+    const char* target_features;
     // Args accumulated by IR_PARAM, consumed by the next IR_CALL.
     LLVMValueRef pending_args[MAX_PENDING_ARGS];
     int pending_arg_count;
+    // Text of the constant afficher calls not written yet (emit_print).
+    char* print_text;
+    size_t print_length;
+    size_t print_capacity;
 } EmitCtx;
 
 // Bundles a value with its LLVM type, used when resolving IR args.
@@ -38,18 +118,85 @@ typedef struct {
     LLVMTypeRef type;
 } TypedValue;
 
+// `t = call f` directly followed by `return t`.
+static int is_tail_position(const IrInstruction* call) {
+    const IrInstruction* ret = call->next;
+    return call->result && ret && ret->op == IR_RETURN && ret->arg1 &&
+           strcmp(ret->arg1, call->result) == 0;
+}
+
+static int has_pointer_arg(LLVMValueRef* args, int count) {
+    for (int i = 0; i < count; i++) {
+        if (LLVMGetTypeKind(LLVMTypeOf(args[i])) == LLVMPointerTypeKind) return 1;
+    }
+    return 0;
+}
+
+static int sym_find_slot(const SymbolTable* table, const char* name, unsigned int hash) {
+    unsigned int mask = (unsigned int)table->capacity - 1;
+    unsigned int i = hash & mask;
+    for (Symbol* s; (s = table->slots[i]); i = (i + 1) & mask) {
+        if (s->hash == hash && strcmp(s->name, name) == 0) break;
+    }
+    return (int)i;
+}
+
 static Symbol* sym_lookup(EmitCtx* ec, const char* name) {
-    for (Symbol* s = ec->symbols; s; s = s->next) {
-        if (strcmp(s->name, name) == 0) return s;
+    SymbolTable* table = &ec->symbols;
+    if (table->count == 0) return NULL;
+    return table->slots[sym_find_slot(table, name, ir_name_hash(name))];
+}
+
+static void sym_grow(SymbolTable* table) {
+    Symbol** old = table->slots;
+    int old_capacity = table->capacity;
+    table->capacity = old_capacity ? old_capacity * 2 : 64;
+    table->slots = calloc((size_t)table->capacity, sizeof(Symbol*));
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i]) table->slots[sym_find_slot(table, old[i]->name, old[i]->hash)] = old[i];
     }
-    return NULL;
+    free(old);
+}
+
+static Symbol* sym_alloc(SymbolTable* table) {
+    if (!table->current || table->current->used == SYMBOL_BLOCK_SIZE) {
+        SymbolBlock* next = table->current ? table->current->next : table->blocks;
+        if (!next) {
+            next = malloc(sizeof(SymbolBlock));
+            next->next = NULL;
+            if (table->current) {
+                table->current->next = next;
+            } else {
+                table->blocks = next;
+            }
+        }
+        next->used = 0;
+        table->current = next;
+    }
+    return &table->current->items[table->current->used++];
+}
+
+// Adds `name` to the table, at `slot` found for `hash`.
+static Symbol* sym_insert(SymbolTable* table, int slot, const char* name, unsigned int hash) {
+    Symbol* s = sym_alloc(table);
+    s->name = name;
+    s->hash = hash;
+    s->alloca = NULL;
+    s->value = NULL;
+    s->type = NULL;
+    table->slots[slot] = s;
+    table->count++;
+    return s;
 }
 
 // Get-or-create the alloca for `name`. On creation, uses `type` (i32 or double).
 // On lookup of an existing symbol, `type` is ignored (alloca is already typed).
 static Symbol* sym_get_or_create(EmitCtx* ec, const char* name, LLVMTypeRef type) {
-    Symbol* s = sym_lookup(ec, name);
-    if (s) return s;
+    SymbolTable* table = &ec->symbols;
+    if ((table->count + 1) * 2 > table->capacity) sym_grow(table);
+    unsigned int hash = ir_name_hash(name);
+    int slot = sym_find_slot(table, name, hash);
+    if (table->slots[slot]) return table->slots[slot];
 
     // Place allocas in the entry block so mem2reg can promote them later.
     LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(ec->current_function);
@@ -63,24 +210,111 @@ static Symbol* sym_get_or_create(EmitCtx* ec, const char* name, LLVMTypeRef type
     LLVMValueRef alloca = LLVMBuildAlloca(tmp, type, name);
     LLVMDisposeBuilder(tmp);
 
-    s = malloc(sizeof(Symbol));
-    s->name = strdup(name);
+    Symbol* s = sym_insert(table, slot, name, hash);
     s->alloca = alloca;
     s->type = type;
-    s->next = ec->symbols;
-    ec->symbols = s;
     return s;
 }
 
+static LLVMValueRef coerce_value(EmitCtx* ec, LLVMValueRef value, LLVMTypeRef to);
+
+// Gives `name` the value `value`, converted to `type` (an alloca's own type
+// wins once it exists): an SSA symbol takes the value itself, any other
+// name gets a store.
+static void sym_define(EmitCtx* ec, const char* name, LLVMTypeRef type, LLVMValueRef value) {
+    Symbol* s = sym_lookup(ec, name);
+    if (s && !s->alloca) {
+        s->type = type;
+        s->value = coerce_value(ec, value, type);
+        return;
+    }
+    s = sym_get_or_create(ec, name, type);
+    LLVMBuildStore(ec->builder, coerce_value(ec, value, s->type), s->alloca);
+}
+
+// Enters the SSA symbols of a body into the (empty) table: names defined
+// once whose definition comes before, and dominates, each of their uses.
+static void sym_plan_ssa(EmitCtx* ec, IrInstruction* list, int formal_count) {
+    IrCfg* cfg = ir_cfg_build(list, formal_count);
+    if (!cfg) return;
+    IrDefInfo info;
+    ir_def_info_build(&info, cfg);
+
+    IrNameMap rejected;
+    ir_name_map_init(&rejected, 16);
+    for (int i = cfg->formal_end; i < cfg->inst_count; i++) {
+        const char* uses[3];
+        int n = ir_inst_uses(cfg->insts[i], uses);
+        for (int u = 0; u < n; u++) {
+            if (ir_name_map_get(&info.defs, uses[u], 0) != 1) continue;
+            int site = ir_name_map_get(&info.def_site, uses[u], -1);
+            if (site >= i || !ir_cfg_dominates(cfg, cfg->block_of[site], cfg->block_of[i])) {
+                ir_name_map_set(&rejected, uses[u], 1);
+            }
+        }
+    }
+
+    SymbolTable* table = &ec->symbols;
+    for (int k = 0; k < info.defs.capacity; k++) {
+        const char* name = info.defs.keys[k];
+        if (!name || info.defs.values[k] != 1 || ir_name_map_get(&rejected, name, 0)) continue;
+        if ((table->count + 1) * 2 > table->capacity) sym_grow(table);
+        unsigned int hash = ir_name_hash(name);
+        int slot = sym_find_slot(table, name, hash);
+        if (!table->slots[slot]) sym_insert(table, slot, name, hash);
+    }
+
+    ir_name_map_free(&rejected);
+    ir_def_info_free(&info);
+    ir_cfg_free(cfg);
+}
+
+// Ends the current scope: empties the table and rewinds the arena.
+static void sym_reset(EmitCtx* ec) {
+    SymbolTable* table = &ec->symbols;
+    if (table->count > 0) memset(table->slots, 0, sizeof(Symbol*) * (size_t)table->capacity);
+    table->count = 0;
+    table->current = NULL;
+}
+
 static void sym_free_all(EmitCtx* ec) {
-    Symbol* s = ec->symbols;
-    while (s) {
-        Symbol* next = s->next;
-        free(s->name);
-        free(s);
-        s = next;
+    SymbolTable* table = &ec->symbols;
+    while (table->blocks) {
+        SymbolBlock* next = table->blocks->next;
+        free(table->blocks);
+        table->blocks = next;
     }
-    ec->symbols = NULL;
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+// ---------- types ----------
+
+// LLVM type of a CypLang type; `fallback` for untyped IR.
+static LLVMTypeRef llvm_type_of(EmitCtx* ec, IrType type, LLVMTypeRef fallback) {
+    switch (type) {
+        case IR_TYPE_ENTIER:  return ec->i32_type;
+        case IR_TYPE_REEL:    return ec->double_type;
+        case IR_TYPE_BOOLEEN: return ec->bool_type;
+        case IR_TYPE_CHAINE:  return ec->ptr_type;
+        default:              return fallback;
+    }
+}
+
+// Converts a scalar to `to`. The type pass makes numeric conversions explicit
+// (IR_ITOF / IR_FTOI); this covers what remains: literals such as the `0` of
+// an implicit return, booleen widening, and IR built without types.
+static LLVMValueRef coerce_value(EmitCtx* ec, LLVMValueRef value, LLVMTypeRef to) {
+    LLVMTypeRef from = LLVMTypeOf(value);
+    if (from == to) return value;
+    if (from == ec->i32_type && to == ec->double_type) return LLVMBuildSIToFP(ec->builder, value, to, "conv");
+    if (from == ec->double_type && to == ec->i32_type) return LLVMBuildFPToSI(ec->builder, value, to, "conv");
+    if (from == ec->bool_type && to == ec->i32_type) return LLVMBuildZExt(ec->builder, value, to, "conv");
+    if (from == ec->bool_type && to == ec->double_type) return LLVMBuildUIToFP(ec->builder, value, to, "conv");
+    if (from == ec->i32_type && to == ec->bool_type) {
+        return LLVMBuildICmp(ec->builder, LLVMIntNE, value, LLVMConstInt(from, 0, 0), "conv");
+    }
+    return value;
 }
 
 // ---------- arg resolution: literal or loaded variable ----------
@@ -116,9 +350,91 @@ static int is_float_literal(const char* s) {
     return has_digit && has_dot;
 }
 
+// ---------- string constant pool ----------
+
+// Pointer to the pooled constant C string holding `text` (`length` bytes),
+// creating it on first use. The globals are private, constant and
+// unnamed_addr with byte alignment, so the code generator places them in
+// mergeable string sections.
+static LLVMValueRef text_constant(EmitCtx* ec, const char* text, size_t length) {
+    char* key = malloc(length + 1);
+    memcpy(key, text, length);
+    key[length] = '\0';
+    int index = ir_name_map_get(&ec->strings, key, 0);
+    free(key);
+    if (index > 0) return ec->string_values[index - 1];
+
+    LLVMValueRef init = LLVMConstStringInContext(ec->ctx, text, (unsigned)length, /*DontNullTerminate=*/0);
+    LLVMValueRef global = LLVMAddGlobal(ec->module, LLVMTypeOf(init), "str");
+    LLVMSetInitializer(global, init);
+    LLVMSetLinkage(global, LLVMPrivateLinkage);
+    LLVMSetGlobalConstant(global, 1);
+    LLVMSetUnnamedAddress(global, LLVMGlobalUnnamedAddr);
+    LLVMSetAlignment(global, 1);
+
+    LLVMValueRef zero = LLVMConstInt(ec->i32_type, 0, 0);
+    LLVMValueRef indices[2] = { zero, zero };
+    LLVMValueRef ptr = LLVMConstInBoundsGEP2(LLVMTypeOf(init), global, indices, 2);
+
+    if ((ec->string_count & (ec->string_count - 1)) == 0) {
+        size_t capacity = ec->string_count ? (size_t)ec->string_count * 2 : 8;
+        ec->string_values = realloc(ec->string_values, capacity * sizeof(LLVMValueRef));
+    }
+    ec->string_values[ec->string_count++] = ptr;
+    // Keyed by the initializer's own bytes, which live as long as the context.
+    size_t size = 0;
+    ir_name_map_set(&ec->strings, LLVMGetAsString(init, &size), ec->string_count);   // 0 means absent
+    return ptr;
+}
+
+// The quoted IR literal `quoted`.
+static LLVMValueRef string_constant(EmitCtx* ec, const char* quoted) {
+    return text_constant(ec, quoted + 1, strlen(quoted) - 2);
+}
+
+// Functions are emitted into separate modules, each with its own pool; once
+// they are linked, folds every pooled string into the first global with the
+// same contents.
+static void merge_string_pool(LLVMModuleRef module) {
+    IrNameMap seen;     // contents -> kept global, keys point into the initializers
+    ir_name_map_init(&seen, 16);
+    LLVMValueRef* kept = NULL;
+    int kept_count = 0;
+
+    LLVMValueRef next = NULL;
+    for (LLVMValueRef g = LLVMGetFirstGlobal(module); g; g = next) {
+        next = LLVMGetNextGlobal(g);
+        LLVMValueRef init = LLVMGetInitializer(g);
+        size_t name_len = 0;
+        const char* name = LLVMGetValueName2(g, &name_len);
+        if (!init || LLVMGetLinkage(g) != LLVMPrivateLinkage || strncmp(name, "str", 3) != 0 ||
+            !LLVMIsAConstantDataSequential(init) || !LLVMIsConstantString(init)) {
+            continue;
+        }
+        size_t len = 0;
+        const char* contents = LLVMGetAsString(init, &len);
+        if (len == 0 || contents[len - 1] != '\0' || memchr(contents, '\0', len - 1)) continue;
+
+        int* slot = ir_name_map_slot(&seen, contents);
+        if (*slot == 0) {
+            if ((kept_count & (kept_count - 1)) == 0) {
+                kept = realloc(kept, (kept_count ? (size_t)kept_count * 2 : 8) * sizeof(LLVMValueRef));
+            }
+            kept[kept_count++] = g;
+            *slot = kept_count;
+            continue;
+        }
+        LLVMReplaceAllUsesWith(g, kept[*slot - 1]);
+        LLVMDeleteGlobal(g);
+    }
+    free(kept);
+    ir_name_map_free(&seen);
+}
+
 // Resolve an IR arg into a typed LLVM value.
 // - "3"          → i32 constant
 // - "3.14"       → double constant
+// - "true"       → i1 constant, "'a'" → i32 character code
 // - "\"Hello\""  → ptr to a global string (quotes are stripped)
 // - "t0", "x"    → load from the symbol's alloca, returning its declared type
 static TypedValue arg_to_typed(EmitCtx* ec, const char* arg) {
@@ -133,54 +449,876 @@ static TypedValue arg_to_typed(EmitCtx* ec, const char* arg) {
         tv.value = LLVMConstReal(tv.type, strtod(arg, NULL));
         return tv;
     }
+    if (arg && (strcmp(arg, "true") == 0 || strcmp(arg, "false") == 0)) {
+        tv.type = ec->bool_type;
+        tv.value = LLVMConstInt(tv.type, arg[0] == 't', 0);
+        return tv;
+    }
+    if (arg && arg[0] == '\'' && arg[1] && arg[2] == '\'') {
+        tv.type = ec->i32_type;
+        tv.value = LLVMConstInt(tv.type, (unsigned char)arg[1], 0);
+        return tv;
+    }
     // String literal: IR-generator emits these wrapped in double quotes.
     if (arg && arg[0] == '"') {
         size_t len = strlen(arg);
         if (len >= 2 && arg[len - 1] == '"') {
-            char* stripped = malloc(len - 1);
-            memcpy(stripped, arg + 1, len - 2);
-            stripped[len - 2] = '\0';
-            tv.value = LLVMBuildGlobalStringPtr(ec->builder, stripped, "str");
+            tv.value = string_constant(ec, arg);
             tv.type = ec->ptr_type;
-            free(stripped);
             return tv;
         }
     }
-    // Symbol: must exist by now (IR is generated top-down).
+    // Symbol: must exist by now (IR is generated top-down). An SSA symbol
+    // has no value yet when its definition was skipped (an operation the
+    // emitter does not lower).
     Symbol* s = sym_lookup(ec, arg);
-    if (!s) {
+    if (!s || (!s->alloca && !s->value)) {
         // Defensive fallback — should not happen for valid IR.
         fprintf(stderr, "warning: unknown IR symbol '%s' — defaulting to i32 0\n", arg);
         tv.type = ec->i32_type;
         tv.value = LLVMConstInt(tv.type, 0, 0);
         return tv;
     }
+    if (!s->alloca) {
+        tv.type = s->type;
+        tv.value = s->value;
+        return tv;
+    }
     tv.type = s->type;
     tv.value = LLVMBuildLoad2(ec->builder, s->type, s->alloca, arg);
     return tv;
 }
 
+// ---------- function declarations ----------
+
+// Adds the prototype of `func`, typed from the type pass (entier when untyped).
+static LLVMValueRef declare_function(EmitCtx* ec, IrFunction* func) {
+    LLVMTypeRef* param_types = NULL;
+    if (func->param_count > 0) {
+        param_types = malloc(func->param_count * sizeof(LLVMTypeRef));
+        for (int i = 0; i < func->param_count; i++) {
+            param_types[i] = llvm_type_of(ec, func->param_types ? func->param_types[i] : IR_TYPE_UNKNOWN,
+                                          ec->i32_type);
+        }
+    }
+    LLVMTypeRef func_type = LLVMFunctionType(llvm_type_of(ec, func->return_type, ec->i32_type), param_types,
+                                             (unsigned)func->param_count, /*IsVarArg=*/0);
+    free(param_types);
+    return LLVMAddFunction(ec->module, func->name, func_type);
+}
+
+// Every unit is emitted into a module of its own, so callees are declared on
+// first use from their IrFunction rather than all up front. They may belong
+// to another source file of the build.
+static LLVMValueRef lookup_callee(EmitCtx* ec, const char* name) {
+    LLVMValueRef callee = LLVMGetNamedFunction(ec->module, name);
+    if (callee) return callee;
+    for (int p = 0; p < ec->program_count; p++) {
+        for (IrFunction* f = ec->programs[p] ? ec->programs[p]->functions : NULL; f; f = f->next) {
+            if (strcmp(f->name, name) == 0) return declare_function(ec, f);
+        }
+    }
+    return NULL;
+}
+
+// ---------- target selection ----------
+
+// The CPU to generate code for ("generic" by default); "native" is the
+// host's. The caller disposes the result (LLVMDisposeMessage).
+static char* target_cpu(const EmitOptions* options) {
+    const char* cpu = options ? options->cpu : NULL;
+    if (cpu && strcmp(cpu, "native") == 0) return LLVMGetHostCPUName();
+    return LLVMCreateMessage(cpu ? cpu : "generic");
+}
+
+// Its features: `options->features`, after the host's for "native".
+static char* target_features(const EmitOptions* options) {
+    const char* features = options && options->features ? options->features : "";
+    if (!options || !options->cpu || strcmp(options->cpu, "native") != 0) return LLVMCreateMessage(features);
+    char* host = LLVMGetHostCPUFeatures();
+    if (features[0] == '\0') return host;
+    size_t size = strlen(host) + strlen(features) + 2;
+    char* both = malloc(size);
+    snprintf(both, size, "%s,%s", host, features);
+    LLVMDisposeMessage(host);
+    char* result = LLVMCreateMessage(both);
+    free(both);
+    return result;
+}
+
+// Whether a CPU or features were asked for (-mcpu, -march, --mattr). Only
+// then do functions carry them: the target machine's own default is generic.
+static int tunes_functions(const EmitOptions* options) {
+    return options && (options->cpu || options->features);
+}
+
+// "target-cpu" / "target-features", which the inliner and code generation
+// read per function, so they hold for code linked in from elsewhere too.
+static void add_target_attributes(EmitCtx* ec, LLVMValueRef function) {
+    if (ec->target_cpu) {
+        LLVMAttributeRef cpu = LLVMCreateStringAttribute(ec->ctx, "target-cpu", 10, ec->target_cpu,
+                                                         (unsigned)strlen(ec->target_cpu));
+        LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex, cpu);
+    }
+    if (ec->target_features && ec->target_features[0] != '\0') {
+        LLVMAttributeRef features = LLVMCreateStringAttribute(ec->ctx, "target-features", 15, ec->target_features,
+                                                              (unsigned)strlen(ec->target_features));
+        LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex, features);
+    }
+}
+
+// ---------- profiles ----------
+
+#define PROFILE_WRITER "__cyp_profile_write"
+
+// `if !t goto`s of a body: the branches a profile counts.
+static int count_branches(const IrInstruction* list) {
+    int count = 0;
+    for (const IrInstruction* inst = list; inst; inst = inst->next) {
+        if (inst->op == IR_IF_GOTO && inst->label) count++;
+    }
+    return count;
+}
+
+static void counters_name(const char* body, char* out, size_t size) {
+    snprintf(out, size, "__cyp_profile.%s", body);
+}
+
+static LLVMMetadataRef md_int(LLVMTypeRef type, unsigned long long value) {
+    return LLVMValueAsMetadata(LLVMConstInt(type, value, 0));
+}
+
+// `!{!"key", values...}`
+static LLVMMetadataRef md_tuple(EmitCtx* ec, const char* key, LLVMMetadataRef* values, int count) {
+    LLVMMetadataRef ops[4];
+    ops[0] = LLVMMDStringInContext2(ec->ctx, key, strlen(key));
+    for (int i = 0; i < count; i++) ops[i + 1] = values[i];
+    return LLVMMDNodeInContext2(ec->ctx, ops, (size_t)count + 1);
+}
+
+static void counter_add(EmitCtx* ec, int index, LLVMValueRef amount) {
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ec->ctx);
+    LLVMValueRef indices[2] = { LLVMConstInt(ec->i32_type, 0, 0), LLVMConstInt(ec->i32_type, (unsigned)index, 0) };
+    LLVMValueRef slot = LLVMConstInBoundsGEP2(LLVMGlobalGetValueType(ec->counters), ec->counters, indices, 2);
+    LLVMValueRef count = LLVMBuildLoad2(ec->builder, i64, slot, "prof");
+    LLVMBuildStore(ec->builder, LLVMBuildAdd(ec->builder, count, amount, "prof"), slot);
+}
+
+// At the entry of body `name`: its counters and entry count when
+// instrumenting, its profile record and `function_entry_count` when using a
+// profile. A record that does not match the body is ignored.
+static void begin_profile(EmitCtx* ec, const char* name, const IrInstruction* list) {
+    ec->counters = NULL;
+    ec->body_profile = NULL;
+    ec->branch_index = 0;
+    int branches = count_branches(list);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ec->ctx);
+
+    if (ec->instrument) {
+        char global_name[300];
+        counters_name(name, global_name, sizeof(global_name));
+        LLVMTypeRef type = LLVMArrayType(i64, (unsigned)(1 + 2 * branches));
+        ec->counters = LLVMAddGlobal(ec->module, type, global_name);
+        LLVMSetInitializer(ec->counters, LLVMConstNull(type));
+        LLVMSetLinkage(ec->counters, LLVMInternalLinkage);
+        counter_add(ec, 0, LLVMConstInt(i64, 1, 0));
+    }
+
+    const ProfileFunction* record = profile_find(ec->profile, name);
+    if (!record) return;
+    if (record->size != ir_count_instructions(list) || record->branch_count != branches) {
+        fprintf(stderr, "warning: profile for '%s' does not match this build (same -O / --passes needed), ignored\n",
+                name);
+        return;
+    }
+    ec->body_profile = record;
+    LLVMMetadataRef count = md_int(i64, (unsigned long long)record->entries);
+    LLVMGlobalSetMetadata(ec->current_function, LLVMGetMDKindIDInContext(ec->ctx, "prof", 4),
+                          md_tuple(ec, "function_entry_count", &count, 1));
+}
+
+// Counts both outcomes of the next branch, on `cond` (i1: fall through).
+static void count_branch(EmitCtx* ec, LLVMValueRef cond) {
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ec->ctx);
+    int k = ec->branch_index;
+    counter_add(ec, 1 + 2 * k, LLVMBuildZExt(ec->builder, cond, i64, "prof"));
+    counter_add(ec, 2 + 2 * k, LLVMBuildZExt(ec->builder, LLVMBuildNot(ec->builder, cond, "prof"), i64, "prof"));
+}
+
+// The hint of the loop whose header is `label`, if any.
+static const IrLoopHint* find_loop_hint(const EmitCtx* ec, const char* label) {
+    for (const IrLoopHint* hint = ec->loop_hints; hint; hint = hint->next) {
+        if (strcmp(hint->header, label) == 0) return hint;
+    }
+    return NULL;
+}
+
+// Attaches weights to the `br` just emitted for the branch: the profiled
+// ones, or, for the test of a loop header with a known trip count, that
+// count against the one exit.
+static void weigh_branch(EmitCtx* ec, LLVMValueRef br) {
+    int k = ec->branch_index++;
+    const IrLoopHint* hint = ec->header_hint;
+    ec->header_hint = NULL;
+    long long fall, jump;
+    if (ec->body_profile) {
+        fall = ec->body_profile->branches[k][0];
+        jump = ec->body_profile->branches[k][1];
+    } else if (hint && hint->trip_count >= 0) {
+        fall = hint->trip_count;
+        jump = 1;
+    } else {
+        return;
+    }
+    // Weights are 32-bit: scale both outcomes down together.
+    while (fall > 0xFFFFFFFFLL || jump > 0xFFFFFFFFLL) {
+        fall /= 2;
+        jump /= 2;
+    }
+    LLVMMetadataRef weights[2] = { md_int(ec->i32_type, (unsigned long long)fall),
+                                   md_int(ec->i32_type, (unsigned long long)jump) };
+    LLVMSetMetadata(br, LLVMGetMDKindIDInContext(ec->ctx, "prof", 4),
+                    LLVMMetadataAsValue(ec->ctx, md_tuple(ec, "branch_weights", weights, 2)));
+}
+
+// What the profile writer's body has set up: the open file and the formats.
+typedef struct {
+    LLVMValueRef file;
+    LLVMTypeRef fprintf_type;
+    LLVMValueRef fprintf_fn;
+    LLVMValueRef function_fmt;
+    LLVMValueRef branch_fmt;
+} ProfileWriter;
+
+// Writes the record of one body, if it was instrumented.
+static void write_body_counts(EmitCtx* ec, const ProfileWriter* w, const char* name, const IrInstruction* list) {
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ec->ctx);
+    char global_name[300];
+    counters_name(name, global_name, sizeof(global_name));
+    LLVMValueRef counters = LLVMGetNamedGlobal(ec->module, global_name);
+    if (!counters) return;
+    LLVMTypeRef type = LLVMGlobalGetValueType(counters);
+    int branches = count_branches(list);
+    LLVMValueRef values[3];
+    for (int i = 0; i < 1 + 2 * branches; i++) {
+        LLVMValueRef indices[2] = { LLVMConstInt(ec->i32_type, 0, 0), LLVMConstInt(ec->i32_type, (unsigned)i, 0) };
+        LLVMValueRef slot = LLVMConstInBoundsGEP2(type, counters, indices, 2);
+        values[i == 0 ? 0 : 2 - i % 2] = LLVMBuildLoad2(ec->builder, i64, slot, "count");
+        if (i == 0) {
+            LLVMValueRef args[6] = { w->file, w->function_fmt,
+                                     LLVMBuildGlobalStringPtr(ec->builder, name, "profile.name"),
+                                     LLVMConstInt(ec->i32_type, (unsigned)ir_count_instructions(list), 0),
+                                     values[0], LLVMConstInt(ec->i32_type, (unsigned)branches, 0) };
+            LLVMBuildCall2(ec->builder, w->fprintf_type, w->fprintf_fn, args, 6, "");
+        } else if (i % 2 == 0) {
+            LLVMValueRef args[4] = { w->file, w->branch_fmt, values[1], values[2] };
+            LLVMBuildCall2(ec->builder, w->fprintf_type, w->fprintf_fn, args, 4, "");
+        }
+    }
+}
+
+// Defines the writer `main` registered with atexit: it dumps the counters
+// of every instrumented body to `path` in the profile.h format.
+static void emit_profile_writer(EmitCtx* ec, const char* path) {
+    LLVMValueRef writer = LLVMGetNamedFunction(ec->module, PROFILE_WRITER);
+    if (!writer) return;
+    LLVMSetLinkage(writer, LLVMInternalLinkage);
+    add_target_attributes(ec, writer);
+
+    LLVMTypeRef fopen_params[2] = { ec->ptr_type, ec->ptr_type };
+    LLVMTypeRef fopen_type = LLVMFunctionType(ec->ptr_type, fopen_params, 2, 0);
+    LLVMValueRef fopen_fn = LLVMGetNamedFunction(ec->module, "fopen");
+    if (!fopen_fn) fopen_fn = LLVMAddFunction(ec->module, "fopen", fopen_type);
+    LLVMTypeRef fprintf_type = LLVMFunctionType(ec->i32_type, fopen_params, 2, /*IsVarArg=*/1);
+    LLVMValueRef fprintf_fn = LLVMGetNamedFunction(ec->module, "fprintf");
+    if (!fprintf_fn) fprintf_fn = LLVMAddFunction(ec->module, "fprintf", fprintf_type);
+    LLVMTypeRef fclose_type = LLVMFunctionType(ec->i32_type, &ec->ptr_type, 1, 0);
+    LLVMValueRef fclose_fn = LLVMGetNamedFunction(ec->module, "fclose");
+    if (!fclose_fn) fclose_fn = LLVMAddFunction(ec->module, "fclose", fclose_type);
+
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(ec->ctx, writer, "entry");
+    LLVMBasicBlockRef write = LLVMAppendBasicBlockInContext(ec->ctx, writer, "write");
+    LLVMBasicBlockRef done = LLVMAppendBasicBlockInContext(ec->ctx, writer, "done");
+    LLVMPositionBuilderAtEnd(ec->builder, entry);
+    LLVMValueRef open_args[2] = { LLVMBuildGlobalStringPtr(ec->builder, path, "profile.path"),
+                                  LLVMBuildGlobalStringPtr(ec->builder, "w", "profile.mode") };
+    LLVMValueRef file = LLVMBuildCall2(ec->builder, fopen_type, fopen_fn, open_args, 2, "file");
+    LLVMBuildCondBr(ec->builder, LLVMBuildIsNull(ec->builder, file, "failed"), done, write);
+
+    LLVMPositionBuilderAtEnd(ec->builder, write);
+    LLVMValueRef header[2] = { file, LLVMBuildGlobalStringPtr(ec->builder, "# cyplang profile\n", "profile.fmt") };
+    LLVMBuildCall2(ec->builder, fprintf_type, fprintf_fn, header, 2, "");
+    LLVMValueRef function_fmt = LLVMBuildGlobalStringPtr(ec->builder, "fonction %s %d %lld %d\n", "profile.fmt");
+    LLVMValueRef branch_fmt = LLVMBuildGlobalStringPtr(ec->builder, "%lld %lld\n", "profile.fmt");
+
+    ProfileWriter w = { file, fprintf_type, fprintf_fn, function_fmt, branch_fmt };
+    for (int p = 0; p < ec->program_count; p++) {
+        for (IrFunction* f = ec->programs[p] ? ec->programs[p]->functions : NULL; f; f = f->next) {
+            write_body_counts(ec, &w, f->name, f->instructions);
+        }
+    }
+    write_body_counts(ec, &w, "main", ec->program ? ec->program->global_instructions : NULL);
+    LLVMBuildCall2(ec->builder, fclose_type, fclose_fn, &file, 1, "");
+    LLVMBuildBr(ec->builder, done);
+    LLVMPositionBuilderAtEnd(ec->builder, done);
+    LLVMBuildRetVoid(ec->builder);
+}
+
+// The module's ProfileSummary, which tells LLVM what counts as hot or cold,
+// computed like LLVM's own from every count of the profile.
+static void add_profile_summary(EmitCtx* ec, const Profile* profile) {
+    static const unsigned cutoffs[] = { 10000, 100000, 200000, 300000, 400000, 500000, 600000, 700000,
+                                        800000, 900000, 950000, 990000, 999000, 999900, 999990, 999999 };
+    enum { CUTOFF_COUNT = sizeof(cutoffs) / sizeof(cutoffs[0]) };
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(ec->ctx);
+
+    int count_total = 0;
+    for (int i = 0; i < profile->function_count; i++) count_total += 1 + 2 * profile->functions[i].branch_count;
+    long long* counts = malloc(sizeof(long long) * (size_t)(count_total > 0 ? count_total : 1));
+    long long total = 0, max_count = 0, max_internal = 0, max_function = 0;
+    int n = 0;
+    for (int i = 0; i < profile->function_count; i++) {
+        const ProfileFunction* f = &profile->functions[i];
+        counts[n++] = f->entries;
+        if (f->entries > max_function) max_function = f->entries;
+        for (int b = 0; b < f->branch_count; b++) {
+            for (int side = 0; side < 2; side++) {
+                counts[n++] = f->branches[b][side];
+                if (f->branches[b][side] > max_internal) max_internal = f->branches[b][side];
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        total += counts[i];
+        if (counts[i] > max_count) max_count = counts[i];
+    }
+    // Descending, for the cumulative cutoffs.
+    for (int i = 1; i < n; i++) {
+        long long c = counts[i];
+        int j = i - 1;
+        for (; j >= 0 && counts[j] < c; j--) counts[j + 1] = counts[j];
+        counts[j + 1] = c;
+    }
+
+    LLVMMetadataRef detailed[CUTOFF_COUNT];
+    long long cumulative = 0;
+    int taken = 0;
+    for (int c = 0; c < CUTOFF_COUNT; c++) {
+        double needed = (double)total * cutoffs[c] / 1000000.0;
+        while (taken < n && (double)cumulative < needed) cumulative += counts[taken++];
+        LLVMMetadataRef entry[3] = { md_int(ec->i32_type, cutoffs[c]),
+                                     md_int(i64, (unsigned long long)(taken > 0 ? counts[taken - 1] : 0)),
+                                     md_int(ec->i32_type, (unsigned)taken) };
+        detailed[c] = LLVMMDNodeInContext2(ec->ctx, entry, 3);
+    }
+    free(counts);
+
+    LLVMMetadataRef format = LLVMMDStringInContext2(ec->ctx, "InstrProf", 9);
+    LLVMMetadataRef v[7] = { md_int(i64, (unsigned long long)total), md_int(i64, (unsigned long long)max_count),
+                             md_int(i64, (unsigned long long)max_internal),
+                             md_int(i64, (unsigned long long)max_function),
+                             md_int(i64, (unsigned long long)n), md_int(i64, (unsigned long long)profile->function_count) };
+    LLVMMetadataRef detailed_list = LLVMMDNodeInContext2(ec->ctx, detailed, CUTOFF_COUNT);
+    LLVMMetadataRef fields[8] = {
+        md_tuple(ec, "ProfileFormat", &format, 1),
+        md_tuple(ec, "TotalCount", &v[0], 1),
+        md_tuple(ec, "MaxCount", &v[1], 1),
+        md_tuple(ec, "MaxInternalCount", &v[2], 1),
+        md_tuple(ec, "MaxFunctionCount", &v[3], 1),
+        md_tuple(ec, "NumCounts", &v[4], 1),
+        md_tuple(ec, "NumFunctions", &v[5], 1),
+        md_tuple(ec, "DetailedSummary", &detailed_list, 1),
+    };
+    LLVMAddModuleFlag(ec->module, LLVMModuleFlagBehaviorError, "ProfileSummary", 14,
+                      LLVMMDNodeInContext2(ec->ctx, fields, 8));
+}
+
+// ---------- debug info ----------
+
+// The unit's compile unit, for its program's source file. Each unit is a
+// module of its own, so the linked module holds one per body, all for the
+// same file, as if each function had been compiled separately.
+static void begin_debug_info(EmitCtx* ec, int optimized) {
+    size_t length = 0;
+    const char* path = ec->program && ec->program->source_path ? ec->program->source_path
+                                                                : LLVMGetModuleIdentifier(ec->module, &length);
+    char dir[4096];
+    if (!getcwd(dir, sizeof(dir))) strcpy(dir, ".");
+    ec->di_builder = LLVMCreateDIBuilder(ec->module);
+    ec->di_file = LLVMDIBuilderCreateFile(ec->di_builder, path, strlen(path), dir, strlen(dir));
+    ec->di_optimized = optimized;
+    LLVMDIBuilderCreateCompileUnit(ec->di_builder, LLVMDWARFSourceLanguageC, ec->di_file, "cyplang", 7, optimized,
+                                   "", 0, 0, "", 0, LLVMDWARFEmissionFull, 0, 0, 0, "", 0, "", 0);
+    LLVMAddModuleFlag(ec->module, LLVMModuleFlagBehaviorWarning, "Debug Info Version", 18,
+                      LLVMValueAsMetadata(LLVMConstInt(ec->i32_type, LLVMDebugMetadataVersion(), 0)));
+    LLVMAddModuleFlag(ec->module, LLVMModuleFlagBehaviorWarning, "Dwarf Version", 13,
+                      LLVMValueAsMetadata(LLVMConstInt(ec->i32_type, 4, 0)));
+}
+
+// Instructions built from now on belong to source line `line` (0: unchanged).
+static void debug_line(EmitCtx* ec, int line) {
+    if (!ec->di_scope || line <= 0) return;
+    LLVMSetCurrentDebugLocation2(ec->builder,
+                                 LLVMDIBuilderCreateDebugLocation(ec->ctx, (unsigned)line, 0, ec->di_scope, NULL));
+}
+
+// Attaches a subprogram to `function`, declared at `line`, and starts
+// stamping its instructions.
+static void begin_debug_body(EmitCtx* ec, LLVMValueRef function, int line) {
+    if (!ec->di_builder) return;
+    size_t length = 0;
+    const char* name = LLVMGetValueName2(function, &length);
+    if (line <= 0) line = 1;
+    LLVMMetadataRef type = LLVMDIBuilderCreateSubroutineType(ec->di_builder, ec->di_file, NULL, 0, LLVMDIFlagZero);
+    ec->di_scope = LLVMDIBuilderCreateFunction(ec->di_builder, ec->di_file, name, length, "", 0, ec->di_file,
+                                               (unsigned)line, type, 0, 1, (unsigned)line, LLVMDIFlagPrototyped,
+                                               ec->di_optimized);
+    LLVMSetSubprogram(function, ec->di_scope);
+    debug_line(ec, line);
+}
+
+// ---------- control flow ----------
+
+// Basic block of an IR label in the current body, created (at the end of
+// the function) on first reference; emit_label() moves it into place.
+static LLVMBasicBlockRef label_block(EmitCtx* ec, const char* label) {
+    int* slot = ir_name_map_slot(&ec->labels, label);
+    if (*slot == 0) {
+        if ((ec->label_count & (ec->label_count - 1)) == 0) {
+            size_t capacity = ec->label_count ? (size_t)ec->label_count * 2 : 8;
+            ec->label_blocks = realloc(ec->label_blocks, capacity * sizeof(LLVMBasicBlockRef));
+        }
+        ec->label_blocks[ec->label_count++] = LLVMAppendBasicBlockInContext(ec->ctx, ec->current_function, label);
+        *slot = ec->label_count;    // 0 means absent
+    }
+    return ec->label_blocks[*slot - 1];
+}
+
+// Starts the block of `label`, falling through into it from an open block.
+static void emit_label(EmitCtx* ec, const char* label) {
+    LLVMBasicBlockRef block = label_block(ec, label);
+    LLVMBasicBlockRef current = LLVMGetInsertBlock(ec->builder);
+    if (current && !LLVMGetBasicBlockTerminator(current)) LLVMBuildBr(ec->builder, block);
+    LLVMMoveBasicBlockAfter(block, LLVMGetLastBasicBlock(ec->current_function));
+    LLVMPositionBuilderAtEnd(ec->builder, block);
+}
+
+// Ends the current body: every block still open (the last one, labels
+// never placed) returns `value`, and the label map is emptied.
+static void finish_blocks(EmitCtx* ec, LLVMValueRef value) {
+    for (LLVMBasicBlockRef b = LLVMGetFirstBasicBlock(ec->current_function); b; b = LLVMGetNextBasicBlock(b)) {
+        if (LLVMGetBasicBlockTerminator(b)) continue;
+        LLVMPositionBuilderAtEnd(ec->builder, b);
+        LLVMBuildRet(ec->builder, value);
+    }
+    ir_name_map_free(&ec->labels);
+    ir_name_map_init(&ec->labels, 16);
+    ec->label_count = 0;
+}
+
+static LLVMValueRef declare_strcmp(EmitCtx* ec) {
+    LLVMValueRef fn = LLVMGetNamedFunction(ec->module, "strcmp");
+    if (fn) return fn;
+    LLVMTypeRef params[2] = { ec->ptr_type, ec->ptr_type };
+    return LLVMAddFunction(ec->module, "strcmp", LLVMFunctionType(ec->i32_type, params, 2, /*IsVarArg=*/0));
+}
+
+// `l op r` as an i1. Numbers compare as reel if either side is one, chaines
+// through strcmp, everything else (entier, caractere, booleen) as signed
+// integers.
+static LLVMValueRef emit_compare(EmitCtx* ec, IrOpType op, TypedValue l, TypedValue r, const char* name) {
+    static const LLVMIntPredicate int_preds[] = { LLVMIntEQ, LLVMIntNE, LLVMIntSLT, LLVMIntSLE, LLVMIntSGT, LLVMIntSGE };
+    static const LLVMRealPredicate real_preds[] = { LLVMRealOEQ, LLVMRealUNE, LLVMRealOLT, LLVMRealOLE, LLVMRealOGT, LLVMRealOGE };
+    int k = op == IR_EQ ? 0 : op == IR_NEQ ? 1 : op == IR_LT ? 2 : op == IR_LE ? 3 : op == IR_GT ? 4 : 5;
+
+    if (l.type == ec->ptr_type || r.type == ec->ptr_type) {
+        LLVMValueRef fn = declare_strcmp(ec);
+        LLVMValueRef args[2] = { l.value, r.value };
+        LLVMValueRef diff = LLVMBuildCall2(ec->builder, LLVMGlobalGetValueType(fn), fn, args, 2, "cmp");
+        return LLVMBuildICmp(ec->builder, int_preds[k], diff, LLVMConstInt(ec->i32_type, 0, 0), name);
+    }
+    if (l.type == ec->double_type || r.type == ec->double_type) {
+        return LLVMBuildFCmp(ec->builder, real_preds[k], coerce_value(ec, l.value, ec->double_type),
+                             coerce_value(ec, r.value, ec->double_type), name);
+    }
+    LLVMTypeRef type = l.type == r.type ? l.type : ec->i32_type;
+    return LLVMBuildICmp(ec->builder, int_preds[k], coerce_value(ec, l.value, type),
+                         coerce_value(ec, r.value, type), name);
+}
+
+// ---------- afficher ----------
+
+// `afficher` prints through the runtime's buffer (llvm_runtime.h). A
+// constant format is read here, as the VM's vm_print reads it at run time:
+// its text becomes writes of known length, each conversion a call typed by
+// its argument. A call with nothing but constants is formatted here whole.
+
+static LLVMValueRef call_runtime(EmitCtx* ec, RuntimeFunction fn, LLVMValueRef* args, unsigned count) {
+    LLVMValueRef function = runtime_function(ec->module, fn);
+    return LLVMBuildCall2(ec->builder, LLVMGlobalGetValueType(function), function, args, count, "");
+}
+
+// Contents of the constant C string `value` points to, or NULL.
+static const char* constant_string(LLVMValueRef value) {
+    if (LLVMIsAConstantExpr(value)) value = LLVMGetOperand(value, 0);   // getelementptr @str, 0, 0
+    if (!LLVMIsAGlobalVariable(value) || !LLVMIsGlobalConstant(value)) return NULL;
+    LLVMValueRef init = LLVMGetInitializer(value);
+    if (!init || !LLVMIsAConstantDataSequential(init) || !LLVMIsConstantString(init)) return NULL;
+    size_t length = 0;
+    const char* contents = LLVMGetAsString(init, &length);
+    return length > 0 && contents[length - 1] == '\0' ? contents : NULL;
+}
+
+// Writes `length` bytes at `offset` in the format `format` points to.
+static LLVMValueRef print_slice(EmitCtx* ec, LLVMValueRef format, size_t offset, size_t length) {
+    LLVMValueRef at = LLVMConstInt(LLVMInt64TypeInContext(ec->ctx), offset, 0);
+    LLVMValueRef args[2] = { LLVMBuildInBoundsGEP2(ec->builder, LLVMInt8TypeInContext(ec->ctx), format, &at, 1, ""),
+                             LLVMConstInt(LLVMInt64TypeInContext(ec->ctx), length, 0) };
+    return call_runtime(ec, RUNTIME_WRITE, args, 2);
+}
+
+// A value printed without a conversion: entier (and booleen) as %d, reel as
+// %f, chaine as %s.
+static LLVMValueRef print_value(EmitCtx* ec, LLVMValueRef value) {
+    LLVMTypeRef type = LLVMTypeOf(value);
+    if (type == ec->double_type) return call_runtime(ec, RUNTIME_PRINT_REAL, &value, 1);
+    if (type == ec->ptr_type) return call_runtime(ec, RUNTIME_PRINT_STR, &value, 1);
+    value = coerce_value(ec, value, ec->i32_type);
+    return call_runtime(ec, RUNTIME_PRINT_INT, &value, 1);
+}
+
+typedef enum {
+    CONVERT_INT,
+    CONVERT_REAL,
+    CONVERT_STR,
+    CONVERT_VALUE,      // %s or %p of a non-string: printed as print_value does
+} Conversion;
+
+// What the conversion `spec` ("%d", "%5.2f", ...) takes `value` as, with the
+// spec to format it by in `plain` (NUL-terminated, at most 31 characters).
+static Conversion conversion_of(EmitCtx* ec, const char* spec, size_t length, LLVMValueRef value, char* plain) {
+    char conv = spec[length - 1];
+    Conversion kind = CONVERT_INT;
+    if (strchr("eEfFgGaA", conv)) kind = CONVERT_REAL;
+    else if (conv == 's' || conv == 'p') kind = LLVMTypeOf(value) == ec->ptr_type ? CONVERT_STR : CONVERT_VALUE;
+    size_t k = 0;
+    for (size_t j = 0; j < length; j++) {
+        // Length modifiers (%ld, %lld) would read past an int; drop them.
+        if (kind != CONVERT_INT || !strchr("lhjzt", spec[j])) plain[k++] = spec[j];
+    }
+    plain[k] = '\0';
+    return kind;
+}
+
+// `value` through the conversion `spec`, converted to what the conversion
+// expects.
+static LLVMValueRef print_conversion(EmitCtx* ec, const char* spec, size_t length, LLVMValueRef value) {
+    char plain[32];
+    RuntimeFunction fn;
+    switch (conversion_of(ec, spec, length, value, plain)) {
+        case CONVERT_VALUE:
+            return print_value(ec, value);
+        case CONVERT_REAL:
+            value = coerce_value(ec, value, ec->double_type);
+            if (strcmp(plain, "%f") == 0) return call_runtime(ec, RUNTIME_PRINT_REAL, &value, 1);
+            fn = RUNTIME_FORMAT_REAL;
+            break;
+        case CONVERT_STR:
+            if (strcmp(plain, "%s") == 0) return call_runtime(ec, RUNTIME_PRINT_STR, &value, 1);
+            fn = RUNTIME_FORMAT_STR;
+            break;
+        default:
+            value = coerce_value(ec, value, ec->i32_type);
+            if (strcmp(plain, "%d") == 0 || strcmp(plain, "%i") == 0) return call_runtime(ec, RUNTIME_PRINT_INT, &value, 1);
+            fn = RUNTIME_FORMAT_INT;
+            break;
+    }
+    LLVMValueRef args[2] = { text_constant(ec, plain, strlen(plain)), value };
+    return call_runtime(ec, fn, args, 2);
+}
+
+// An afficher whose arguments are all constants is rendered at compile time
+// into ec->print_text. The text waits there while the block goes on without
+// printing, so neighbouring constant prints come out as one write.
+
+// Room for `length` more bytes of rendered text.
+static char* reserve_print_text(EmitCtx* ec, size_t length) {
+    if (ec->print_length + length > ec->print_capacity) {
+        size_t capacity = ec->print_capacity ? ec->print_capacity : 64;
+        while (capacity < ec->print_length + length) capacity *= 2;
+        ec->print_text = realloc(ec->print_text, capacity);
+        ec->print_capacity = capacity;
+    }
+    return ec->print_text + ec->print_length;
+}
+
+static void append_print_text(EmitCtx* ec, const char* text, size_t length) {
+    if (length == 0) return;
+    memcpy(reserve_print_text(ec, length), text, length);
+    ec->print_length += length;
+}
+
+// Appends what printf(spec, ...) prints.
+static void render(EmitCtx* ec, const char* spec, ...) {
+    va_list values;
+    va_start(values, spec);
+    int length = vsnprintf(NULL, 0, spec, values);
+    va_end(values);
+    if (length <= 0) return;
+    char* at = reserve_print_text(ec, (size_t)length + 1);
+    va_start(values, spec);
+    vsnprintf(at, (size_t)length + 1, spec, values);
+    va_end(values);
+    ec->print_length += (size_t)length;
+}
+
+// The constant `value` as coerce_value converts it to an entier; 0 when it
+// is not a constant, or a reel fptosi would make poison of.
+static int constant_int(EmitCtx* ec, LLVMValueRef value, int* out) {
+    if (LLVMIsAConstantInt(value)) {
+        *out = LLVMTypeOf(value) == ec->bool_type ? (int)LLVMConstIntGetZExtValue(value)
+                                                   : (int)LLVMConstIntGetSExtValue(value);
+        return 1;
+    }
+    if (!LLVMIsAConstantFP(value)) return 0;
+    LLVMBool loses = 0;
+    double real = LLVMConstRealGetDouble(value, &loses);
+    if (!(real > -2147483649.0 && real < 2147483648.0)) return 0;
+    *out = (int)real;
+    return 1;
+}
+
+// The constant `value` as a reel; 0 when it is not a constant.
+static int constant_real(EmitCtx* ec, LLVMValueRef value, double* out) {
+    if (LLVMIsAConstantFP(value)) {
+        LLVMBool loses = 0;
+        *out = LLVMConstRealGetDouble(value, &loses);
+        return 1;
+    }
+    int integer = 0;
+    if (!LLVMIsAConstantInt(value) || !constant_int(ec, value, &integer)) return 0;
+    *out = integer;
+    return 1;
+}
+
+// print_value at compile time.
+static int render_value(EmitCtx* ec, LLVMValueRef value) {
+    LLVMTypeRef type = LLVMTypeOf(value);
+    if (type == ec->double_type) {
+        double real = 0;
+        if (!constant_real(ec, value, &real)) return 0;
+        render(ec, "%f", real);
+        return 1;
+    }
+    if (type == ec->ptr_type) {
+        const char* text = constant_string(value);
+        if (!text) return 0;
+        append_print_text(ec, text, strlen(text));
+        return 1;
+    }
+    int integer = 0;
+    if (!constant_int(ec, value, &integer)) return 0;
+    render(ec, "%d", integer);
+    return 1;
+}
+
+// print_conversion at compile time. %p of a string is left to run time, when
+// its address is known.
+static int render_conversion(EmitCtx* ec, const char* spec, size_t length, LLVMValueRef value) {
+    char plain[32];
+    switch (conversion_of(ec, spec, length, value, plain)) {
+        case CONVERT_VALUE:
+            return render_value(ec, value);
+        case CONVERT_REAL: {
+            double real = 0;
+            if (!constant_real(ec, value, &real)) return 0;
+            render(ec, plain, real);
+            return 1;
+        }
+        case CONVERT_STR: {
+            const char* text = spec[length - 1] == 's' ? constant_string(value) : NULL;
+            if (!text) return 0;
+            render(ec, plain, text);
+            return 1;
+        }
+        default: {
+            int integer = 0;
+            if (!constant_int(ec, value, &integer)) return 0;
+            render(ec, plain, integer);
+            return 1;
+        }
+    }
+}
+
+// Writes the text rendered so far, as one constant.
+static void flush_print_text(EmitCtx* ec) {
+    if (ec->print_length == 0) return;
+    LLVMValueRef args[2] = { text_constant(ec, ec->print_text, ec->print_length),
+                             LLVMConstInt(LLVMInt64TypeInContext(ec->ctx), ec->print_length, 0) };
+    ec->print_length = 0;
+    call_runtime(ec, RUNTIME_WRITE, args, 2);
+}
+
+static int body_prints(const IrInstruction* list) {
+    for (const IrInstruction* inst = list; inst; inst = inst->next) {
+        if (inst->op == IR_CALL && inst->arg1 && strcmp(inst->arg1, "afficher") == 0) return 1;
+    }
+    return 0;
+}
+
+// Whether any body of the build calls afficher.
+static int build_prints(const EmitCtx* ec) {
+    for (int p = 0; p < ec->program_count; p++) {
+        if (!ec->programs[p]) continue;
+        if (body_prints(ec->programs[p]->global_instructions)) return 1;
+        for (const IrFunction* f = ec->programs[p]->functions; f; f = f->next) {
+            if (body_prints(f->instructions)) return 1;
+        }
+    }
+    return 0;
+}
+
+// Adds `written` to `*total`, unless the count is not wanted (`total` NULL).
+static void add_written(EmitCtx* ec, LLVMValueRef* total, LLVMValueRef written) {
+    if (total) *total = *total ? LLVMBuildAdd(ec->builder, *total, written, "") : written;
+}
+
+// `length` bytes at `offset` in the format: rendered, or written from the
+// format constant `args[0]`.
+static void print_text(EmitCtx* ec, LLVMValueRef* args, const char* format, size_t offset, size_t length,
+                       int rendered, LLVMValueRef* total) {
+    if (length == 0) return;
+    if (rendered) append_print_text(ec, format + offset, length);
+    else add_written(ec, total, print_slice(ec, args[0], offset, length));
+}
+
+// The pieces of afficher(args...), whose format `format` is a constant or
+// NULL (no format: each value in turn), as vm_print reads them. Rendered into
+// ec->print_text when `rendered`, which stops with 0 at the first argument
+// that is not a constant; otherwise emitted, counting into `*total`.
+static int print_pieces(EmitCtx* ec, LLVMValueRef* args, int argc, const char* format, int rendered,
+                        LLVMValueRef* total) {
+    if (!format) {
+        for (int a = 0; a < argc; a++) {
+            if (!rendered) add_written(ec, total, print_value(ec, args[a]));
+            else if (!render_value(ec, args[a])) return 0;
+        }
+        return 1;
+    }
+    int next = 1;
+    size_t text = 0;    // start of the text not printed yet
+    const char* p = format;
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        print_text(ec, args, format, text, (size_t)(p - format) - text, rendered, total);
+        if (p[1] == '%') {
+            text = (size_t)(p + 1 - format);    // the second '%' starts the next text
+            p += 2;
+            continue;
+        }
+        // The conversion spec (flags, width, precision, length) up to its letter.
+        const char* spec = p++;
+        while (*p && !strchr("diouxXeEfFgGaAcsp", *p) && p - spec < 30) p++;
+        if (!*p || next >= argc) {
+            // Incomplete, or no argument left: printed as it is.
+            text = (size_t)(spec - format);
+            if (*p) p++;
+            continue;
+        }
+        p++;
+        if (!rendered) add_written(ec, total, print_conversion(ec, spec, (size_t)(p - spec), args[next++]));
+        else if (!render_conversion(ec, spec, (size_t)(p - spec), args[next++])) return 0;
+        text = (size_t)(p - format);
+    }
+    print_text(ec, args, format, text, (size_t)(p - format) - text, rendered, total);
+    return 1;
+}
+
+// afficher(args...), counting the characters printed into `*total` (NULL
+// when it is not used) if any.
+static void emit_print(EmitCtx* ec, LLVMValueRef* args, int argc, LLVMValueRef* total) {
+    if (argc == 0) return;
+    int formatted = LLVMTypeOf(args[0]) == ec->ptr_type;
+    const char* format = formatted ? constant_string(args[0]) : NULL;
+    if (!formatted || format) {
+        // All constants: the text joins the one rendered so far. A NUL in it
+        // (%c of 0) would end the pooled string early; that one is emitted.
+        size_t start = ec->print_length;
+        if (print_pieces(ec, args, argc, format, 1, NULL) &&
+            !(ec->print_length > start && memchr(ec->print_text + start, '\0', ec->print_length - start))) {
+            if (total) *total = LLVMConstInt(ec->i32_type, ec->print_length - start, 0);
+            return;
+        }
+        ec->print_length = start;
+    }
+    flush_print_text(ec);
+    if (formatted && !format) {
+        // A format only known at run time: printf's, after the buffer.
+        call_runtime(ec, RUNTIME_FLUSH, NULL, 0);
+        LLVMTypeRef printf_type = LLVMFunctionType(ec->i32_type, &ec->ptr_type, 1, /*IsVarArg=*/1);
+        LLVMValueRef printf_fn = LLVMGetNamedFunction(ec->module, "printf");
+        if (!printf_fn) printf_fn = LLVMAddFunction(ec->module, "printf", printf_type);
+        for (int a = 1; a < argc; a++) {
+            if (LLVMTypeOf(args[a]) == ec->bool_type) args[a] = coerce_value(ec, args[a], ec->i32_type);
+        }
+        add_written(ec, total, LLVMBuildCall2(ec->builder, printf_type, printf_fn, args, (unsigned)argc, ""));
+        return;
+    }
+    print_pieces(ec, args, argc, format, 0, total);
+}
+
 // ---------- per-instruction emission ----------
 
-// Emit a single IR instruction. Unknown ops are silently skipped (handled in later phases).
-// IR_RETURN is handled here only as a fallback; functions handle it in emit_function below.
+// Code after a `retourner` or a `goto` with no label in between (a return
+// in the middle of a block, code behind an unconditional jump) would follow
+// the block's terminator. It goes to a fresh, unreachable block instead, so
+// every block keeps a single terminator and the unit survives its bitcode
+// round trip.
+static void ensure_open_block(EmitCtx* ec) {
+    LLVMBasicBlockRef block = LLVMGetInsertBlock(ec->builder);
+    if (block && LLVMGetBasicBlockTerminator(block)) {
+        LLVMBasicBlockRef dead = LLVMAppendBasicBlockInContext(ec->ctx, ec->current_function, "dead");
+        LLVMPositionBuilderAtEnd(ec->builder, dead);
+    }
+}
+
+// Emit a single IR instruction. The array ops (IR_ARRAY_ACCESS /
+// IR_ARRAY_ASSIGN) are not lowered and are skipped; emit_function filters out
+// IR_FUNC_BEGIN / IR_FUNC_END and the formal IR_PARAMs before they get here.
 static void emit_one(EmitCtx* ec, IrInstruction* inst) {
+    // Rendered afficher text goes out before control leaves the block.
+    if (inst->op == IR_LABEL || inst->op == IR_GOTO || inst->op == IR_IF_GOTO || inst->op == IR_RETURN) {
+        flush_print_text(ec);
+    }
+    debug_line(ec, inst->line);
+    if (inst->op == IR_LABEL) {
+        if (inst->label) emit_label(ec, inst->label);
+        ec->header_hint = inst->label ? find_loop_hint(ec, inst->label) : NULL;
+        return;
+    }
+    ensure_open_block(ec);
     switch (inst->op) {
         case IR_ASSIGN: {
             TypedValue v = arg_to_typed(ec, inst->arg1);
-            Symbol* s = sym_get_or_create(ec, inst->result, v.type);
-            LLVMBuildStore(ec->builder, v.value, s->alloca);
+            sym_define(ec, inst->result, llvm_type_of(ec, inst->type, v.type), v.value);
             break;
         }
         case IR_ADD:
         case IR_SUB:
         case IR_MUL:
-        case IR_DIV: {
+        case IR_DIV:
+        case IR_MOD: {
             TypedValue l = arg_to_typed(ec, inst->arg1);
             TypedValue r = arg_to_typed(ec, inst->arg2);
-            // Mixed-type arithmetic (int+double) is not yet handled — Phase 2.4.1.
-            // We use l's type as the result type; if r differs, clang will reject.
-            int is_fp = (l.type == ec->double_type);
+            // Operand types agree once the type pass has run; untyped IR
+            // falls back to the left operand's type.
+            LLVMTypeRef type = llvm_type_of(ec, inst->type, l.type);
+            l.value = coerce_value(ec, l.value, type);
+            r.value = coerce_value(ec, r.value, type);
+            int is_fp = (type == ec->double_type);
             LLVMValueRef res;
             switch (inst->op) {
                 case IR_ADD: res = is_fp ? LLVMBuildFAdd(ec->builder, l.value, r.value, inst->result)
@@ -191,18 +1329,83 @@ static void emit_one(EmitCtx* ec, IrInstruction* inst) {
                                          : LLVMBuildMul (ec->builder, l.value, r.value, inst->result); break;
                 case IR_DIV: res = is_fp ? LLVMBuildFDiv(ec->builder, l.value, r.value, inst->result)
                                          : LLVMBuildSDiv(ec->builder, l.value, r.value, inst->result); break;
+                case IR_MOD: res = is_fp ? LLVMBuildFRem(ec->builder, l.value, r.value, inst->result)
+                                         : LLVMBuildSRem(ec->builder, l.value, r.value, inst->result); break;
                 default:     res = NULL; // unreachable
             }
-            Symbol* s = sym_get_or_create(ec, inst->result, l.type);
-            LLVMBuildStore(ec->builder, res, s->alloca);
+            sym_define(ec, inst->result, type, res);
+            break;
+        }
+        case IR_ITOF:
+        case IR_FTOI: {
+            TypedValue v = arg_to_typed(ec, inst->arg1);
+            LLVMTypeRef to = inst->op == IR_ITOF ? ec->double_type : ec->i32_type;
+            LLVMValueRef res = inst->op == IR_ITOF
+                ? LLVMBuildSIToFP(ec->builder, coerce_value(ec, v.value, ec->i32_type), to, inst->result)
+                : LLVMBuildFPToSI(ec->builder, coerce_value(ec, v.value, ec->double_type), to, inst->result);
+            sym_define(ec, inst->result, to, res);
+            break;
+        }
+        case IR_NEG: {
+            TypedValue v = arg_to_typed(ec, inst->arg1);
+            LLVMTypeRef type = llvm_type_of(ec, inst->type, v.type);
+            v.value = coerce_value(ec, v.value, type);
+            LLVMValueRef res = type == ec->double_type ? LLVMBuildFNeg(ec->builder, v.value, inst->result)
+                                                       : LLVMBuildNeg(ec->builder, v.value, inst->result);
+            sym_define(ec, inst->result, type, res);
+            break;
+        }
+        case IR_NOT: {
+            TypedValue v = arg_to_typed(ec, inst->arg1);
+            LLVMValueRef res = LLVMBuildNot(ec->builder, coerce_value(ec, v.value, ec->bool_type), inst->result);
+            sym_define(ec, inst->result, ec->bool_type, res);
+            break;
+        }
+        case IR_AND:
+        case IR_OR: {
+            // Both sides are already evaluated: the IR has no short circuit.
+            TypedValue l = arg_to_typed(ec, inst->arg1);
+            TypedValue r = arg_to_typed(ec, inst->arg2);
+            l.value = coerce_value(ec, l.value, ec->bool_type);
+            r.value = coerce_value(ec, r.value, ec->bool_type);
+            LLVMValueRef res = inst->op == IR_AND ? LLVMBuildAnd(ec->builder, l.value, r.value, inst->result)
+                                                  : LLVMBuildOr(ec->builder, l.value, r.value, inst->result);
+            sym_define(ec, inst->result, ec->bool_type, res);
+            break;
+        }
+        case IR_EQ:
+        case IR_NEQ:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE: {
+            TypedValue l = arg_to_typed(ec, inst->arg1);
+            TypedValue r = arg_to_typed(ec, inst->arg2);
+            sym_define(ec, inst->result, ec->bool_type, emit_compare(ec, inst->op, l, r, inst->result));
+            break;
+        }
+        case IR_GOTO:
+            if (inst->label) LLVMBuildBr(ec->builder, label_block(ec, inst->label));
+            ec->header_hint = NULL;
+            break;
+        case IR_IF_GOTO: {
+            // `if !cond goto label`, otherwise on to the next instruction.
+            if (!inst->label) break;
+            TypedValue cond = arg_to_typed(ec, inst->arg1);
+            LLVMValueRef value = coerce_value(ec, cond.value, ec->bool_type);
+            if (ec->counters) count_branch(ec, value);
+            LLVMBasicBlockRef next = LLVMAppendBasicBlockInContext(ec->ctx, ec->current_function, "suite");
+            weigh_branch(ec, LLVMBuildCondBr(ec->builder, value, next, label_block(ec, inst->label)));
+            LLVMPositionBuilderAtEnd(ec->builder, next);
             break;
         }
         case IR_RETURN: {
+            LLVMTypeRef ret_type = LLVMGetReturnType(LLVMGlobalGetValueType(ec->current_function));
             if (inst->arg1) {
                 TypedValue v = arg_to_typed(ec, inst->arg1);
-                LLVMBuildRet(ec->builder, v.value);
+                LLVMBuildRet(ec->builder, coerce_value(ec, v.value, ret_type));
             } else {
-                LLVMBuildRet(ec->builder, LLVMConstInt(ec->i32_type, 0, 0));
+                LLVMBuildRet(ec->builder, LLVMConstNull(ret_type));
             }
             break;
         }
@@ -220,72 +1423,92 @@ static void emit_one(EmitCtx* ec, IrInstruction* inst) {
         }
         case IR_CALL: {
             const char* fn_name = inst->arg1;
-            // Map the cyplang builtin `afficher` to libc `printf`.
-            if (fn_name && strcmp(fn_name, "afficher") == 0) fn_name = "printf";
+            // The call consumes the last `arg2` pending args (nested calls in
+            // argument position have already popped their own).
+            int argc = inst->arg2 ? atoi(inst->arg2) : ec->pending_arg_count;
+            if (argc > ec->pending_arg_count) argc = ec->pending_arg_count;
+            int first_arg = ec->pending_arg_count - argc;
+
+            if (fn_name && strcmp(fn_name, "afficher") == 0) {
+                LLVMValueRef written = NULL;
+                emit_print(ec, ec->pending_args + first_arg, argc, inst->result ? &written : NULL);
+                if (inst->result) {
+                    sym_define(ec, inst->result, ec->i32_type, written ? written : LLVMConstInt(ec->i32_type, 0, 0));
+                }
+                ec->pending_arg_count = first_arg;
+                break;
+            }
 
-            LLVMValueRef callee = LLVMGetNamedFunction(ec->module, fn_name);
+            flush_print_text(ec);   // the callee may print
+            LLVMValueRef callee = lookup_callee(ec, fn_name);
             if (!callee) {
                 fprintf(stderr, "warning: unknown function '%s' — call skipped\n", fn_name);
-                ec->pending_arg_count = 0;
+                ec->pending_arg_count = first_arg;
                 break;
             }
             LLVMTypeRef callee_type = LLVMGlobalGetValueType(callee);
+            // Arguments take the callee's declared types.
+            unsigned fixed = LLVMCountParamTypes(callee_type);
+            LLVMTypeRef* fixed_types = malloc(sizeof(LLVMTypeRef) * (fixed + 1));
+            LLVMGetParamTypes(callee_type, fixed_types);
+            for (int a = 0; a < argc && (unsigned)a < fixed; a++) {
+                LLVMValueRef* arg = &ec->pending_args[first_arg + a];
+                *arg = coerce_value(ec, *arg, fixed_types[a]);
+            }
+            free(fixed_types);
             LLVMValueRef call = LLVMBuildCall2(ec->builder, callee_type, callee,
-                                               ec->pending_args,
-                                               (unsigned)ec->pending_arg_count,
+                                               ec->pending_args + first_arg,
+                                               (unsigned)argc,
                                                inst->result ? inst->result : "calltmp");
+            if (is_tail_position(inst) && !has_pointer_arg(ec->pending_args + first_arg, argc)) {
+                // Returned right away and no caller stack slot escapes into
+                // the callee: the backend may reuse the frame (sibling call).
+                LLVMSetTailCall(call, 1);
+            }
             // Store the result if the callee returns a non-void value.
             if (inst->result) {
                 LLVMTypeRef ret_type = LLVMGetReturnType(callee_type);
                 if (LLVMGetTypeKind(ret_type) != LLVMVoidTypeKind) {
-                    Symbol* s = sym_get_or_create(ec, inst->result, ret_type);
-                    LLVMBuildStore(ec->builder, call, s->alloca);
+                    sym_define(ec, inst->result, llvm_type_of(ec, inst->type, ret_type), call);
                 }
             }
-            ec->pending_arg_count = 0;
+            ec->pending_arg_count = first_arg;
             break;
         }
         default:
-            // IR_NEG / IR_NOT / comparisons / control flow:
-            // not yet supported, will be added in later jalons.
+            // IR_ARRAY_ACCESS / IR_ARRAY_ASSIGN: not lowered.
             break;
     }
 }
 
 // ---------- function emission ----------
 
-// thread proper types from the AST/IR (cyplang IR is currently untyped).
 static void emit_function(EmitCtx* ec, IrFunction* func) {
-    // Build the signature: (i32, i32, ...) -> i32
-    LLVMTypeRef* param_types = NULL;
-    if (func->param_count > 0) {
-        param_types = malloc(func->param_count * sizeof(LLVMTypeRef));
-        for (int i = 0; i < func->param_count; i++) param_types[i] = ec->i32_type;
-    }
-    LLVMTypeRef func_type = LLVMFunctionType(ec->i32_type, param_types,
-                                             (unsigned)func->param_count, /*IsVarArg=*/0);
-    free(param_types);
-
-    LLVMValueRef llvm_func = LLVMAddFunction(ec->module, func->name, func_type);
+    LLVMValueRef llvm_func = lookup_callee(ec, func->name);
+    LLVMTypeRef ret_type = LLVMGetReturnType(LLVMGlobalGetValueType(llvm_func));
+    add_target_attributes(ec, llvm_func);
     LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(ec->ctx, llvm_func, "entry");
     LLVMPositionBuilderAtEnd(ec->builder, entry);
+    begin_debug_body(ec, llvm_func, func->instructions ? func->instructions->line : 0);
 
-    // Save outer scope (we're about to enter a fresh symbol table for this function).
-    Symbol* saved_symbols = ec->symbols;
+    // Save the outer state; the symbol table is empty between functions.
     LLVMValueRef saved_function = ec->current_function;
     int saved_pending = ec->pending_arg_count;
-    ec->symbols = NULL;
     ec->current_function = llvm_func;
     ec->pending_arg_count = 0;
 
-    // For each parameter: alloca + store the incoming LLVM param into it.
-    // This lets the body load/store params just like locals (mem2reg will clean it up).
+    // Each parameter the body never reassigns is used as is; the others get
+    // an alloca holding the incoming value, loaded and stored like locals
+    // (mem2reg will clean it up).
+    sym_plan_ssa(ec, func->instructions, func->param_count);
+    begin_profile(ec, func->name, func->instructions);
+    ec->loop_hints = func->loop_hints;
+    ec->header_hint = NULL;
     for (int i = 0; i < func->param_count; i++) {
         const char* pname = func->params[i];
-        Symbol* s = sym_get_or_create(ec, pname, ec->i32_type);
         LLVMValueRef param_val = LLVMGetParam(llvm_func, (unsigned)i);
+        sym_define(ec, pname, LLVMTypeOf(param_val), param_val);
         LLVMSetValueName2(param_val, pname, strlen(pname));
-        LLVMBuildStore(ec->builder, param_val, s->alloca);
     }
 
     // Walk the function's IR. The first `func->param_count` IR_PARAMs are formal-
@@ -303,73 +1526,804 @@ static void emit_function(EmitCtx* ec, IrFunction* func) {
     }
 
     // Fallback: every basic block must end with a terminator.
-    LLVMBasicBlockRef current_block = LLVMGetInsertBlock(ec->builder);
-    if (!LLVMGetBasicBlockTerminator(current_block)) {
-        LLVMBuildRet(ec->builder, LLVMConstInt(ec->i32_type, 0, 0));
-    }
+    flush_print_text(ec);
+    finish_blocks(ec, LLVMConstNull(ret_type));
 
-    // Restore the outer scope.
-    sym_free_all(ec);
-    ec->symbols = saved_symbols;
+    // Restore the outer state.
+    sym_reset(ec);
     ec->current_function = saved_function;
     ec->pending_arg_count = saved_pending;
 }
 
-// ---------- public entry point ----------
+// Wraps the global IR instructions in `main` (i32).
+// TODO(phase 2.5.1): rename this if the user defines their own `main`.
+static void emit_main(EmitCtx* ec) {
+    LLVMTypeRef main_type = LLVMFunctionType(ec->i32_type, NULL, 0, /*IsVarArg=*/0);
+    ec->current_function = LLVMAddFunction(ec->module, "main", main_type);
+    add_target_attributes(ec, ec->current_function);
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(ec->ctx, ec->current_function, "entry");
+    LLVMPositionBuilderAtEnd(ec->builder, entry);
+
+    IrInstruction* global = ec->program ? ec->program->global_instructions : NULL;
+    begin_debug_body(ec, ec->current_function, global ? global->line : 0);
+    if (global) sym_plan_ssa(ec, global, 0);
+    begin_profile(ec, "main", global);
+    ec->loop_hints = ec->program ? ec->program->global_loop_hints : NULL;
+    ec->header_hint = NULL;
+    if (ec->instrument) {
+        // The counters are written when the program exits, however it exits.
+        LLVMTypeRef writer_type = LLVMFunctionType(LLVMVoidTypeInContext(ec->ctx), NULL, 0, 0);
+        LLVMValueRef writer = LLVMAddFunction(ec->module, PROFILE_WRITER, writer_type);
+        LLVMTypeRef atexit_type = LLVMFunctionType(ec->i32_type, &ec->ptr_type, 1, 0);
+        LLVMValueRef atexit_fn = LLVMAddFunction(ec->module, "atexit", atexit_type);
+        LLVMValueRef handler = LLVMConstBitCast(writer, ec->ptr_type);     // typed pointers: void ()* -> i8*
+        LLVMBuildCall2(ec->builder, atexit_type, atexit_fn, &handler, 1, "");
+    }
+    for (IrInstruction* inst = global; inst; inst = inst->next) {
+        emit_one(ec, inst);
+    }
+
+    // Always terminate with `ret i32 0` so the module verifies.
+    flush_print_text(ec);
+    finish_blocks(ec, LLVMConstInt(ec->i32_type, 0, 0));
+    // What afficher left in the output buffer goes out before returning.
+    if (!build_prints(ec)) {
+        sym_reset(ec);
+        return;
+    }
+    if (ec->di_scope && !LLVMGetCurrentDebugLocation2(ec->builder)) debug_line(ec, global ? global->line : 1);
+    for (LLVMBasicBlockRef b = LLVMGetFirstBasicBlock(ec->current_function); b; b = LLVMGetNextBasicBlock(b)) {
+        LLVMValueRef ret = LLVMGetBasicBlockTerminator(b);
+        if (!ret || LLVMGetInstructionOpcode(ret) != LLVMRet) continue;
+        LLVMPositionBuilderBefore(ec->builder, ret);
+        call_runtime(ec, RUNTIME_FLUSH, NULL, 0);
+    }
+    sym_reset(ec);
+}
+
+// ---------- emission units ----------
 
-int emit_llvm(IRProgram* program, const char* module_name, const char* output_path) {
-    EmitCtx ec = {0};
-    ec.ctx = LLVMContextCreate();
-    ec.module = LLVMModuleCreateWithNameInContext(module_name, ec.ctx);
-    ec.builder = LLVMCreateBuilderInContext(ec.ctx);
-    ec.i32_type = LLVMInt32TypeInContext(ec.ctx);
-    ec.double_type = LLVMDoubleTypeInContext(ec.ctx);
-    ec.ptr_type = LLVMPointerType(LLVMInt8TypeInContext(ec.ctx), 0);
-    ec.pending_arg_count = 0;
+// Emits into `ctx`, or into a context of its own when `ctx` is NULL.
+static void emitter_init(EmitCtx* ec, IRProgram* program, const char* module_name, LLVMContextRef ctx) {
+    memset(ec, 0, sizeof(*ec));
+    ec->program = program;
+    ec->programs = &ec->program;
+    ec->program_count = 1;
+    ec->owns_ctx = ctx == NULL;
+    ec->ctx = ctx ? ctx : LLVMContextCreate();
+    ec->module = LLVMModuleCreateWithNameInContext(module_name, ec->ctx);
+    ec->builder = LLVMCreateBuilderInContext(ec->ctx);
+    ec->i32_type = LLVMInt32TypeInContext(ec->ctx);
+    ec->double_type = LLVMDoubleTypeInContext(ec->ctx);
+    ec->bool_type = LLVMInt1TypeInContext(ec->ctx);
+    ec->ptr_type = LLVMPointerType(LLVMInt8TypeInContext(ec->ctx), 0);
+    ec->pending_arg_count = 0;
+    ir_name_map_init(&ec->strings, 16);
+    ir_name_map_init(&ec->labels, 16);
+}
 
-    // Pre-declare `printf` so cyplang's `afficher(...)` can lower to it.
-    // Signature: i32 printf(i8*, ...) — varargs.
-    LLVMTypeRef printf_param_types[1] = { ec.ptr_type };
-    LLVMTypeRef printf_type = LLVMFunctionType(ec.i32_type, printf_param_types, 1, /*IsVarArg=*/1);
-    LLVMAddFunction(ec.module, "printf", printf_type);
+static void emitter_dispose(EmitCtx* ec) {
+    if (ec->di_builder) LLVMDisposeDIBuilder(ec->di_builder);
+    sym_free_all(ec);
+    ir_name_map_free(&ec->strings);
+    free(ec->string_values);
+    ir_name_map_free(&ec->labels);
+    free(ec->label_blocks);
+    free(ec->print_text);
+    LLVMDisposeBuilder(ec->builder);
+    if (ec->module) LLVMDisposeModule(ec->module);
+    if (ec->owns_ctx) LLVMContextDispose(ec->ctx);
+}
 
-    // Emit user-defined functions first, so global code in `main` can call them.
-    for (IrFunction* f = program ? program->functions : NULL; f; f = f->next) {
-        emit_function(&ec, f);
+// One user function, or the global code (`func` NULL), emitted in an LLVM
+// context of its own and handed back as bitcode: contexts are not shareable
+// between threads, modules can only be linked within one context.
+typedef struct {
+    IRProgram* program;
+    IrFunction* func;
+    LLVMMemoryBufferRef bitcode;
+} EmitUnit;
+
+typedef struct {
+    IRProgram* const* programs;     // the program, then EmitOptions.sources
+    int program_count;
+    const char* module_name;
+    const EmitOptions* options;     // may be NULL
+    EmitUnit* units;
+    char* target_cpu;               // resolved from `options` when functions carry it
+    char* target_features;
+} EmitBatch;
+
+static void emit_unit(void* data, int index) {
+    EmitBatch* batch = (EmitBatch*)data;
+    EmitUnit* unit = &batch->units[index];
+
+    EmitCtx ec;
+    emitter_init(&ec, unit->program, batch->module_name, NULL);
+    ec.programs = batch->programs;
+    ec.program_count = batch->program_count;
+    ec.target_cpu = batch->target_cpu;
+    ec.target_features = batch->target_features;
+    if (batch->options) {
+        ec.instrument = batch->options->profile_generate != NULL;
+        ec.profile = batch->options->profile_use;
+        if (batch->options->debug_info) begin_debug_info(&ec, batch->options->opt_level > 0);
+    }
+    if (unit->func) {
+        emit_function(&ec, unit->func);
+    } else {
+        emit_main(&ec);
     }
+    if (ec.di_builder) LLVMDIBuilderFinalize(ec.di_builder);
+    unit->bitcode = LLVMWriteBitcodeToMemoryBuffer(ec.module);
+    emitter_dispose(&ec);
+}
 
-    // Wrap global IR instructions in `main` (i32).
-    // TODO(phase 2.5.1): rename this if the user defines their own `main`.
-    LLVMTypeRef main_type = LLVMFunctionType(ec.i32_type, NULL, 0, /*IsVarArg=*/0);
-    ec.current_function = LLVMAddFunction(ec.module, "main", main_type);
-    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(ec.ctx, ec.current_function, "entry");
-    LLVMPositionBuilderAtEnd(ec.builder, entry);
+// Reports a linker diagnostic on stderr. LLVM's default handler would exit
+// the process on an error such as a symbol defined twice.
+static void link_diagnostic(LLVMDiagnosticInfoRef info, void* data) {
+    const char* path = data;
+    char* desc = LLVMGetDiagInfoDescription(info);
+    if (LLVMGetDiagInfoSeverity(info) == LLVMDSError) {
+        fprintf(stderr, "%s: %s\n", path, desc);
+    }
+    LLVMDisposeMessage(desc);
+}
 
-    for (IrInstruction* inst = program ? program->global_instructions : NULL; inst; inst = inst->next) {
-        emit_one(&ec, inst);
+// Links a precompiled module, bitcode or text IR, into `module`.
+static int link_input(LLVMModuleRef module, LLVMContextRef ctx, const char* path) {
+    LLVMMemoryBufferRef buffer = NULL;
+    char* err = NULL;
+    if (LLVMCreateMemoryBufferWithContentsOfFile(path, &buffer, &err) != 0) {
+        fprintf(stderr, "Failed to read %s: %s\n", path, err ? err : "(unknown error)");
+        LLVMDisposeMessage(err);
+        return 1;
+    }
+    LLVMModuleRef input = NULL;
+    if (LLVMParseIRInContext(ctx, buffer, &input, &err) != 0) { // consumes the buffer
+        fprintf(stderr, "Failed to parse module %s: %s\n", path, err ? err : "(unknown error)");
+        LLVMDisposeMessage(err);
+        return 1;
     }
+    LLVMDiagnosticHandler previous = LLVMContextGetDiagnosticHandler(ctx);
+    void* previous_data = LLVMContextGetDiagnosticContext(ctx);
+    LLVMContextSetDiagnosticHandler(ctx, link_diagnostic, (void*)path);
+    int failed = LLVMLinkModules2(module, input) != 0;
+    LLVMContextSetDiagnosticHandler(ctx, previous, previous_data);
+    if (failed) {
+        fprintf(stderr, "Failed to link module %s\n", path);
+        return 1;
+    }
+    return 0;
+}
 
-    // Always terminate with `ret i32 0` so the module verifies.
-    LLVMBuildRet(ec.builder, LLVMConstInt(ec.i32_type, 0, 0));
+// ---------- public entry points ----------
+
+LLVMModuleRef emit_llvm_module(IRProgram* program, const char* module_name, LLVMContextRef ctx,
+                               const EmitOptions* options) {
+    int program_count = 1 + (options ? options->source_count : 0);
+    IRProgram** programs = malloc(sizeof(IRProgram*) * (size_t)program_count);
+    programs[0] = program;
+    for (int p = 1; p < program_count; p++) programs[p] = options->sources[p - 1];
+
+    // Units of program p are first_unit[p] .. first_unit[p + 1] - 1: its
+    // functions, then main for the program itself only.
+    int* first_unit = malloc(sizeof(int) * (size_t)(program_count + 1));
+    int unit_count = 0;
+    for (int p = 0; p < program_count; p++) {
+        first_unit[p] = unit_count;
+        for (IrFunction* f = programs[p] ? programs[p]->functions : NULL; f; f = f->next) unit_count++;
+        if (p == 0) unit_count++;
+    }
+    first_unit[program_count] = unit_count;
+
+    EmitBatch batch = { programs, program_count, module_name, options,
+                        calloc((size_t)unit_count, sizeof(EmitUnit)), NULL, NULL };
+    if (tunes_functions(options)) {
+        batch.target_cpu = target_cpu(options);
+        batch.target_features = target_features(options);
+    }
+    int u = 0;
+    for (int p = 0; p < program_count; p++) {
+        for (IrFunction* f = programs[p] ? programs[p]->functions : NULL; f; f = f->next) {
+            batch.units[u].program = programs[p];
+            batch.units[u++].func = f;
+        }
+        if (p == 0) batch.units[u++].program = program; // main
+    }
+
+    // Units may finish in any order; they are read back and merged in a
+    // fixed order, so the module depends on the program only, not on jobs.
+    work_pool_run(unit_count, options ? options->jobs : 1, emit_unit, &batch);
 
+    EmitCtx ec;
+    emitter_init(&ec, program, module_name, ctx);
+    ec.programs = programs;
+    ec.program_count = program_count;
+    ec.target_cpu = batch.target_cpu;
+    ec.target_features = batch.target_features;
     int rc = 0;
-    if (output_path) {
+    LLVMModuleRef* modules = calloc((size_t)unit_count, sizeof(LLVMModuleRef));
+    for (u = 0; u < unit_count; u++) {
+        if (LLVMParseBitcodeInContext2(ec.ctx, batch.units[u].bitcode, &modules[u]) != 0) {
+            fprintf(stderr, "Failed to read back emitted function %s\n",
+                    batch.units[u].func ? batch.units[u].func->name : "main");
+            modules[u] = NULL;
+            rc = 1;
+        }
+        LLVMDisposeMemoryBuffer(batch.units[u].bitcode);
+    }
+    free(batch.units);
+
+    // Each link rescans the whole destination module, so neighbours are merged
+    // pairwise (log2(units) rounds) rather than one by one into a growing
+    // module. That gives one module per source file, which the linker then
+    // adds to the output module, resolving the calls between files.
+    // Linking consumes the source module.
+    int link_failed = 0;
+    for (int p = 0; rc == 0 && p < program_count; p++) {
+        int lo = first_unit[p], hi = first_unit[p + 1];
+        for (int width = 1; lo + width < hi; width *= 2) {
+            for (u = lo; u + width < hi; u += 2 * width) {
+                link_failed |= LLVMLinkModules2(modules[u], modules[u + width]) != 0;
+                modules[u + width] = NULL;
+            }
+        }
+        if (lo < hi) {
+            link_failed |= LLVMLinkModules2(ec.module, modules[lo]) != 0;
+            modules[lo] = NULL;
+        }
+    }
+    if (link_failed) {
+        fprintf(stderr, "Failed to link emitted functions\n");
+        rc = 1;
+    }
+    if (rc == 0 && unit_count > 1) merge_string_pool(ec.module);
+    if (rc == 0) runtime_define(ec.module);
+    if (rc == 0 && options && options->profile_generate) emit_profile_writer(&ec, options->profile_generate);
+    if (rc == 0 && options && options->profile_use) add_profile_summary(&ec, options->profile_use);
+    for (u = 0; u < unit_count; u++) {
+        if (modules[u]) LLVMDisposeModule(modules[u]);
+    }
+    free(modules);
+    free(first_unit);
+
+    for (int i = 0; rc == 0 && options && i < options->link_module_count; i++) {
+        rc = link_input(ec.module, ec.ctx, options->link_modules[i]);
+    }
+
+    LLVMModuleRef module = NULL;
+    if (rc == 0) {
+        module = ec.module;
+        ec.module = NULL;
+    }
+    emitter_dispose(&ec);
+    free(programs);
+    if (batch.target_cpu) LLVMDisposeMessage(batch.target_cpu);
+    if (batch.target_features) LLVMDisposeMessage(batch.target_features);
+    return module;
+}
+
+// ---------- LLVM optimisation ----------
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+// A whole program first drops the definitions `main` cannot reach.
+static void pipeline_name(const EmitOptions* options, int whole_program, char* out, size_t size) {
+    const char* prefix = whole_program ? "globaldce," : "";
+    if (options->optimize_size) {
+        snprintf(out, size, "%sdefault<Os>", prefix);
+    } else {
+        snprintf(out, size, "%sdefault<O%d>", prefix, options->opt_level > 3 ? 3 : options->opt_level);
+    }
+}
+
+// Target machine for `options`, or NULL after reporting why not.
+static LLVMTargetMachineRef create_target_machine(const EmitOptions* options) {
+    LLVMInitializeAllTargetInfos();
+    LLVMInitializeAllTargets();
+    LLVMInitializeAllTargetMCs();
+    LLVMInitializeAllAsmPrinters();
+
+    char* triple = options->target_triple ? LLVMCreateMessage(options->target_triple)
+                                          : LLVMGetDefaultTargetTriple();
+    LLVMTargetRef target = NULL;
+    char* err = NULL;
+    if (LLVMGetTargetFromTriple(triple, &target, &err) != 0) {
+        fprintf(stderr, "Unknown target '%s': %s\n", triple, err ? err : "(unknown error)");
+        LLVMDisposeMessage(err);
+        LLVMDisposeMessage(triple);
+        return NULL;
+    }
+    LLVMCodeGenOptLevel level = options->opt_level >= 3 ? LLVMCodeGenLevelAggressive
+                              : options->opt_level == 0 ? LLVMCodeGenLevelNone
+                              : LLVMCodeGenLevelDefault;
+    char* cpu = target_cpu(options);
+    char* features = target_features(options);
+    LLVMTargetMachineRef machine = LLVMCreateTargetMachine(target, triple, cpu, features, level, LLVMRelocPIC,
+                                                           LLVMCodeModelDefault);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+    LLVMDisposeMessage(triple);
+    return machine;
+}
+
+static int run_pipeline(LLVMModuleRef module, const EmitOptions* options, LLVMTargetMachineRef machine,
+                        int whole_program) {
+    char pipeline[32];
+    pipeline_name(options, whole_program, pipeline, sizeof(pipeline));
+    LLVMPassBuilderOptionsRef pass_options = LLVMCreatePassBuilderOptions();
+    LLVMErrorRef err = LLVMRunPasses(module, pipeline, machine, pass_options);
+    LLVMDisposePassBuilderOptions(pass_options);
+    if (err) {
+        char* message = LLVMGetErrorMessage(err);
+        fprintf(stderr, "LLVM pipeline %s failed: %s\n", pipeline, message);
+        LLVMDisposeErrorMessage(message);
+        return 1;
+    }
+    return 0;
+}
+
+// Link-time optimisation of a module holding the whole program: every
+// definition but `main` becomes internal, so the pipeline may inline it
+// across source files, drop the unused ones and change their signatures.
+static void internalize(LLVMModuleRef module) {
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f; f = LLVMGetNextFunction(f)) {
+        size_t length = 0;
+        const char* name = LLVMGetValueName2(f, &length);
+        if (LLVMIsDeclaration(f) || strcmp(name, "main") == 0) continue;
+        if (LLVMGetLinkage(f) == LLVMExternalLinkage) LLVMSetLinkage(f, LLVMInternalLinkage);
+    }
+    for (LLVMValueRef g = LLVMGetFirstGlobal(module); g; g = LLVMGetNextGlobal(g)) {
+        size_t length = 0;
+        const char* name = LLVMGetValueName2(g, &length);
+        if (LLVMIsDeclaration(g) || strncmp(name, "llvm.", 5) == 0) continue;
+        if (LLVMGetLinkage(g) == LLVMExternalLinkage) LLVMSetLinkage(g, LLVMInternalLinkage);
+    }
+}
+
+int emit_llvm_optimize(LLVMModuleRef module, const EmitOptions* options) {
+    if (!options || options->opt_level <= 0) return 0;
+    LLVMTargetMachineRef machine = create_target_machine(options);
+    if (!machine) return 1;
+    int rc = run_pipeline(module, options, machine, 0);
+    LLVMDisposeTargetMachine(machine);
+    return rc;
+}
+
+// ---------- native output ----------
+
+// Stamps the module with the machine's triple and data layout, which object
+// emission requires and which the passes then optimise for (type sizes,
+// alignment, legal integer widths for the vectorisers).
+static void set_target(LLVMModuleRef module, LLVMTargetMachineRef machine) {
+    char* triple = LLVMGetTargetMachineTriple(machine);
+    LLVMSetTarget(module, triple);
+    LLVMDisposeMessage(triple);
+    LLVMTargetDataRef layout = LLVMCreateTargetDataLayout(machine);
+    LLVMSetModuleDataLayout(module, layout);
+    LLVMDisposeTargetData(layout);
+}
+
+static int write_object(LLVMModuleRef module, LLVMTargetMachineRef machine, const char* path) {
+    char* err = NULL;
+    if (LLVMTargetMachineEmitToFile(machine, module, (char*)path, LLVMObjectFile, &err) != 0) {
+        fprintf(stderr, "Failed to write object file %s: %s\n", path, err ? err : "(unknown error)");
+        LLVMDisposeMessage(err);
+        return 1;
+    }
+    return 0;
+}
+
+// Streams the module's bitcode straight to the file descriptor; "-" is stdout.
+static int write_bitcode(LLVMModuleRef module, const char* path) {
+    int to_stdout = strcmp(path, "-") == 0;
+    if (to_stdout) fflush(stdout);
+    int fd = to_stdout ? STDOUT_FILENO : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: ", path);
+        perror(NULL);
+        return 1;
+    }
+    if (LLVMWriteBitcodeToFD(module, fd, /*ShouldClose=*/!to_stdout, /*Unbuffered=*/0) != 0) {
+        fprintf(stderr, "Failed to write bitcode to %s\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+// ---------- parallel code generation ----------
+
+// An executable's code generation split by function over -jN threads. Each
+// partition is the optimised module keeping only its share of the
+// definitions (the others become declarations), read into a context of its
+// own and compiled to an object; the system linker then joins the objects.
+// Partitions depend on the module and N only, so the output is
+// deterministic.
+
+typedef struct {
+    LLVMMemoryBufferRef bitcode;    // the whole optimised module
+    int* owner;                     // partition of each definition, in module order
+    LLVMTargetMachineRef* machines; // one per partition: machines are not shared between threads
+    char** objects;                 // object file of each partition
+    int* failed;
+} CodegenBatch;
+
+static int instruction_count(LLVMValueRef function) {
+    int count = 0;
+    for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+        for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) count++;
+    }
+    return count;
+}
+
+static int is_reserved_global(LLVMValueRef global) {
+    size_t length = 0;
+    return strncmp(LLVMGetValueName2(global, &length), "llvm.", 5) == 0;
+}
+
+// Definitions local to the module would be invisible to the other
+// partitions: they become hidden externals, still local to the executable.
+static void export_definitions(LLVMModuleRef module) {
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f; f = LLVMGetNextFunction(f)) {
+        LLVMLinkage linkage = LLVMGetLinkage(f);
+        if (LLVMIsDeclaration(f) || (linkage != LLVMInternalLinkage && linkage != LLVMPrivateLinkage)) continue;
+        LLVMSetLinkage(f, LLVMExternalLinkage);
+        LLVMSetVisibility(f, LLVMHiddenVisibility);
+    }
+    for (LLVMValueRef g = LLVMGetFirstGlobal(module); g; g = LLVMGetNextGlobal(g)) {
+        LLVMLinkage linkage = LLVMGetLinkage(g);
+        if (LLVMIsDeclaration(g) || is_reserved_global(g)) continue;
+        if (linkage != LLVMInternalLinkage && linkage != LLVMPrivateLinkage) continue;
+        LLVMSetLinkage(g, LLVMExternalLinkage);
+        LLVMSetVisibility(g, LLVMHiddenVisibility);
+    }
+}
+
+// Replaces the definition `value` by a declaration of the same name, value
+// type and pointer type (address space included, so uses, typed pointers
+// and all, read back from bitcode unchanged).
+static void keep_declaration(LLVMModuleRef module, LLVMValueRef value, int is_function) {
+    size_t length = 0;
+    char* name = strdup(LLVMGetValueName2(value, &length));
+    LLVMTypeRef type = LLVMGlobalGetValueType(value);
+    unsigned address_space = LLVMGetPointerAddressSpace(LLVMTypeOf(value));
+    LLVMValueRef declaration = is_function ? LLVMAddFunction(module, "", type)
+                                           : LLVMAddGlobalInAddressSpace(module, type, "", address_space);
+    if (is_function) {
+        LLVMSetFunctionCallConv(declaration, LLVMGetFunctionCallConv(value));
+    } else {
+        LLVMSetGlobalConstant(declaration, LLVMIsGlobalConstant(value));
+        LLVMSetAlignment(declaration, LLVMGetAlignment(value));
+        LLVMSetThreadLocalMode(declaration, LLVMGetThreadLocalMode(value));
+    }
+    LLVMSetVisibility(declaration, LLVMGetVisibility(value));
+    LLVMSetValueName2(value, "", 0);
+    LLVMSetValueName2(declaration, name, length);
+    free(name);
+    // A function lands in the module's program address space: cast back if
+    // the definition lived elsewhere.
+    LLVMValueRef replacement = declaration;
+    if (LLVMTypeOf(declaration) != LLVMTypeOf(value)) replacement = LLVMConstPointerCast(declaration, LLVMTypeOf(value));
+    LLVMReplaceAllUsesWith(value, replacement);
+    if (is_function) {
+        LLVMDeleteFunction(value);
+    } else {
+        LLVMDeleteGlobal(value);
+    }
+}
+
+// True if code or a global's initializer uses `value`, directly or through
+// constant expressions. Constants left over from deleted bodies (a
+// getelementptr on a global, with typed pointers) count as uses for
+// LLVMGetFirstUse but reach nothing.
+static int is_reached(LLVMValueRef value) {
+    for (LLVMUseRef use = LLVMGetFirstUse(value); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+        if (LLVMIsAInstruction(user) || LLVMIsAGlobalValue(user)) return 1;
+        if (LLVMIsAConstant(user) && is_reached(user)) return 1;
+    }
+    return 0;
+}
+
+// Deletes the hidden declarations nothing reaches: exported from another
+// partition but not used by this one's code. Left in, they reach the object
+// as undefined, untyped symbols, which the linker rejects for thread-local
+// variables.
+static void drop_unreached_declarations(LLVMModuleRef module) {
+    LLVMValueRef next;
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f; f = next) {
+        next = LLVMGetNextFunction(f);
+        if (!LLVMIsDeclaration(f) || LLVMGetVisibility(f) != LLVMHiddenVisibility || is_reached(f)) continue;
+        if (LLVMGetFirstUse(f)) LLVMReplaceAllUsesWith(f, LLVMGetUndef(LLVMTypeOf(f)));
+        LLVMDeleteFunction(f);
+    }
+    for (LLVMValueRef g = LLVMGetFirstGlobal(module); g; g = next) {
+        next = LLVMGetNextGlobal(g);
+        if (!LLVMIsDeclaration(g) || LLVMGetVisibility(g) != LLVMHiddenVisibility || is_reached(g)) continue;
+        if (LLVMGetFirstUse(g)) LLVMReplaceAllUsesWith(g, LLVMGetUndef(LLVMTypeOf(g)));
+        LLVMDeleteGlobal(g);
+    }
+}
+
+static void codegen_partition(void* data, int index) {
+    CodegenBatch* batch = (CodegenBatch*)data;
+    LLVMContextRef ctx = LLVMContextCreate();
+    LLVMModuleRef module = NULL;
+    if (LLVMParseBitcodeInContext2(ctx, batch->bitcode, &module) != 0) {
+        fprintf(stderr, "Failed to read back the module for code generation\n");
+        batch->failed[index] = 1;
+        LLVMContextDispose(ctx);
+        return;
+    }
+
+    // Collected first: replacing a definition appends to the lists walked.
+    int function_count = 0, global_count = 0;
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f; f = LLVMGetNextFunction(f)) function_count++;
+    for (LLVMValueRef g = LLVMGetFirstGlobal(module); g; g = LLVMGetNextGlobal(g)) global_count++;
+    LLVMValueRef* functions = malloc(sizeof(LLVMValueRef) * (size_t)(function_count + global_count + 1));
+    LLVMValueRef* globals = functions + function_count;
+    int n = 0;
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f; f = LLVMGetNextFunction(f)) functions[n++] = f;
+    n = 0;
+    for (LLVMValueRef g = LLVMGetFirstGlobal(module); g; g = LLVMGetNextGlobal(g)) globals[n++] = g;
+
+    int definition = 0;
+    for (int i = 0; i < function_count; i++) {
+        if (LLVMIsDeclaration(functions[i])) continue;
+        if (batch->owner[definition++] != index) keep_declaration(module, functions[i], 1);
+    }
+    // Variables and constants go with the first partition.
+    for (int i = 0; index > 0 && i < global_count; i++) {
+        if (LLVMIsDeclaration(globals[i])) continue;
+        if (is_reserved_global(globals[i])) {
+            LLVMDeleteGlobal(globals[i]); // llvm.global_ctors, ...: once per executable
+        } else {
+            keep_declaration(module, globals[i], 0);
+        }
+    }
+    free(functions);
+    drop_unreached_declarations(module);
+
+    batch->failed[index] = write_object(module, batch->machines[index], batch->objects[index]);
+    LLVMDisposeModule(module);
+    LLVMContextDispose(ctx);
+}
+
+// Splits the definitions of `module` into at most `jobs` partitions of
+// similar size (instructions), in module order. Returns the partition count.
+static int plan_partitions(LLVMModuleRef module, int jobs, int** owner) {
+    int count = 0;
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f; f = LLVMGetNextFunction(f)) {
+        if (!LLVMIsDeclaration(f)) count++;
+    }
+    int partitions = jobs < count ? jobs : count;
+    *owner = malloc(sizeof(int) * (size_t)(count + 1));
+    long* load = calloc((size_t)(partitions + 1), sizeof(long));
+    int i = 0;
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f; f = LLVMGetNextFunction(f)) {
+        if (LLVMIsDeclaration(f)) continue;
+        int lightest = 0;
+        for (int p = 1; p < partitions; p++) {
+            if (load[p] < load[lightest]) lightest = p;
+        }
+        (*owner)[i++] = lightest;
+        load[lightest] += instruction_count(f) + 1;
+    }
+    free(load);
+    return partitions;
+}
+
+// Objects in temporary files (one per partition), then the system link.
+static int write_executable(LLVMModuleRef module, LLVMTargetMachineRef machine, const char* path,
+                            const EmitOptions* options) {
+    int* owner = NULL;
+    int jobs = options ? options->jobs : 1;
+    int partitions = jobs > 1 ? plan_partitions(module, jobs, &owner) : 1;
+    if (partitions > 1) export_definitions(module);
+
+    CodegenBatch batch = { NULL, owner, calloc((size_t)partitions, sizeof(LLVMTargetMachineRef)),
+                           calloc((size_t)partitions, sizeof(char*)), calloc((size_t)partitions, sizeof(int)) };
+    int rc = 0;
+    for (int p = 0; rc == 0 && p < partitions; p++) {
+        batch.objects[p] = temp_object_path();
+        // Target registration is not thread-safe: the machines are made here.
+        batch.machines[p] = p == 0 ? machine : create_target_machine(options);
+        if (!batch.objects[p] || !batch.machines[p]) rc = 1;
+    }
+    if (rc == 0 && partitions == 1) {
+        rc = write_object(module, machine, batch.objects[0]);
+    } else if (rc == 0) {
+        batch.bitcode = LLVMWriteBitcodeToMemoryBuffer(module);
+        work_pool_run(partitions, jobs, codegen_partition, &batch);
+        LLVMDisposeMemoryBuffer(batch.bitcode);
+        for (int p = 0; p < partitions; p++) rc |= batch.failed[p];
+    }
+    if (rc == 0) rc = link_executable((const char* const*)batch.objects, partitions, path);
+
+    for (int p = 0; p < partitions; p++) {
+        if (batch.objects[p]) remove(batch.objects[p]);
+        free(batch.objects[p]);
+        if (p > 0 && batch.machines[p]) LLVMDisposeTargetMachine(batch.machines[p]);
+    }
+    free(batch.objects);
+    free(batch.machines);
+    free(batch.failed);
+    free(owner);
+    return rc;
+}
+
+// ---------- single-function modules ----------
+
+static IrFunction* find_function(const IRProgram* program, const char* name) {
+    for (IrFunction* f = program ? program->functions : NULL; f; f = f->next) {
+        if (strcmp(f->name, name) == 0) return f;
+    }
+    return NULL;
+}
+
+// Adds `func` and its callees to `closure` (sized for every function) once each.
+static void collect_callees(const IRProgram* program, IrFunction* func, IrFunction** closure, int* count) {
+    for (int i = 0; i < *count; i++) {
+        if (closure[i] == func) return;
+    }
+    closure[(*count)++] = func;
+    for (const IrInstruction* inst = func->instructions; inst; inst = inst->next) {
+        if (inst->op != IR_CALL || !inst->arg1) continue;
+        IrFunction* callee = find_function(program, inst->arg1);
+        if (callee) collect_callees(program, callee, closure, count);
+    }
+}
+
+static int count_functions(const IRProgram* program) {
+    int n = 0;
+    for (IrFunction* f = program ? program->functions : NULL; f; f = f->next) n++;
+    return n;
+}
+
+int emit_llvm_can_lower(const IRProgram* program, const IrFunction* func) {
+    IrFunction** closure = malloc(sizeof(IrFunction*) * (size_t)count_functions(program));
+    int count = 0;
+    collect_callees(program, (IrFunction*)func, closure, &count);
+
+    int ok = 1;
+    for (int i = 0; ok && i < count; i++) {
+        for (const IrInstruction* inst = closure[i]->instructions; ok && inst; inst = inst->next) {
+            switch (inst->op) {
+                case IR_ASSIGN: case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+                case IR_NEG: case IR_NOT: case IR_AND: case IR_OR:
+                case IR_EQ: case IR_NEQ: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+                case IR_LABEL: case IR_GOTO: case IR_IF_GOTO:
+                case IR_ITOF: case IR_FTOI: case IR_PARAM: case IR_RETURN:
+                case IR_FUNC_BEGIN: case IR_FUNC_END:
+                    break;
+                case IR_CALL:
+                    ok = inst->arg1 && (strcmp(inst->arg1, "afficher") == 0 || find_function(program, inst->arg1));
+                    break;
+                default:
+                    ok = 0;
+            }
+        }
+    }
+    free(closure);
+    return ok;
+}
+
+LLVMModuleRef emit_llvm_entry_module(IRProgram* program, IrFunction* func, const char* entry_name,
+                                     LLVMContextRef ctx) {
+    EmitCtx ec;
+    emitter_init(&ec, program, entry_name, ctx);
+
+    IrFunction** closure = malloc(sizeof(IrFunction*) * (size_t)count_functions(program));
+    int count = 0;
+    collect_callees(program, func, closure, &count);
+    for (int i = 0; i < count; i++) {
+        emit_function(&ec, closure[i]);
+        // Only the entry is visible, so several entry modules can share a JIT.
+        LLVMSetLinkage(LLVMGetNamedFunction(ec.module, closure[i]->name), LLVMInternalLinkage);
+    }
+    free(closure);
+
+    LLVMValueRef target = LLVMGetNamedFunction(ec.module, func->name);
+    LLVMTypeRef target_type = LLVMGlobalGetValueType(target);
+    LLVMTypeRef entry_params[2] = { ec.ptr_type, ec.ptr_type };
+    LLVMTypeRef entry_type = LLVMFunctionType(LLVMVoidTypeInContext(ec.ctx), entry_params, 2, /*IsVarArg=*/0);
+    LLVMValueRef entry = LLVMAddFunction(ec.module, entry_name, entry_type);
+    LLVMPositionBuilderAtEnd(ec.builder, LLVMAppendBasicBlockInContext(ec.ctx, entry, "entry"));
+
+    LLVMTypeRef i8_type = LLVMInt8TypeInContext(ec.ctx);
+    unsigned argc = LLVMCountParamTypes(target_type);
+    LLVMTypeRef* param_types = malloc(sizeof(LLVMTypeRef) * (argc + 1));
+    LLVMValueRef* args = malloc(sizeof(LLVMValueRef) * (argc + 1));
+    LLVMGetParamTypes(target_type, param_types);
+    for (unsigned a = 0; a < argc; a++) {
+        LLVMValueRef offset = LLVMConstInt(ec.i32_type, 8 * a, 0);
+        LLVMValueRef slot = LLVMBuildGEP2(ec.builder, i8_type, LLVMGetParam(entry, 0), &offset, 1, "slot");
+        LLVMTypeRef load_type = param_types[a] == ec.bool_type ? ec.i32_type : param_types[a];
+        slot = LLVMBuildBitCast(ec.builder, slot, LLVMPointerType(load_type, 0), "");
+        args[a] = coerce_value(&ec, LLVMBuildLoad2(ec.builder, load_type, slot, "arg"), param_types[a]);
+    }
+    LLVMValueRef result = LLVMBuildCall2(ec.builder, target_type, target, args, argc, "result");
+    LLVMTypeRef ret_type = LLVMGetReturnType(target_type);
+    LLVMTypeRef store_type = ret_type == ec.bool_type ? ec.i32_type : ret_type;
+    LLVMValueRef out = LLVMBuildBitCast(ec.builder, LLVMGetParam(entry, 1), LLVMPointerType(store_type, 0), "");
+    LLVMBuildStore(ec.builder, coerce_value(&ec, result, store_type), out);
+    // The caller prints too: the output buffer is emptied on the way back.
+    call_runtime(&ec, RUNTIME_FLUSH, NULL, 0);
+    LLVMBuildRetVoid(ec.builder);
+    free(param_types);
+    free(args);
+    runtime_define(ec.module);
+
+    LLVMModuleRef module = ec.module;
+    ec.module = NULL;
+    emitter_dispose(&ec);
+    return module;
+}
+
+int emit_llvm(IRProgram* program, const char* module_name, const char* output_path,
+              const EmitOptions* options) {
+    LLVMContextRef ctx = LLVMContextCreate();
+    double start = now_ms();
+    LLVMModuleRef module = emit_llvm_module(program, module_name, ctx, options);
+    int rc = module ? 0 : 1;
+    double emitted = now_ms();
+
+    // One target machine for the passes and, for native output, code generation.
+    EmitFileType file_type = options && output_path ? options->file_type : EMIT_FILE_LLVM_IR;
+    LLVMTargetMachineRef machine = NULL;
+    int native = file_type == EMIT_FILE_OBJECT || file_type == EMIT_FILE_EXECUTABLE;
+    int targeted = options && (options->opt_level > 0 || options->target_triple || tunes_functions(options));
+    if (rc == 0 && (native || targeted)) {
+        machine = create_target_machine(options);
+        rc = machine ? 0 : 1;
+    }
+    if (rc == 0 && machine) set_target(module, machine);
+    // An executable, or the sources of one compiled together, is the whole
+    // program; other output may be linked with more code later.
+    int whole_program = options && options->opt_level > 0 &&
+                        (file_type == EMIT_FILE_EXECUTABLE || options->source_count > 0);
+    if (rc == 0 && whole_program) internalize(module);
+    if (rc == 0 && options && options->opt_level > 0) rc = run_pipeline(module, options, machine, whole_program);
+    double optimized = now_ms();
+
+    if (rc == 0 && file_type == EMIT_FILE_BITCODE) {
+        rc = write_bitcode(module, output_path);
+    } else if (rc == 0 && file_type == EMIT_FILE_OBJECT) {
+        rc = write_object(module, machine, output_path);
+    } else if (rc == 0 && file_type == EMIT_FILE_EXECUTABLE) {
+        rc = write_executable(module, machine, output_path, options);
+    } else if (rc == 0 && output_path) {
         char* err = NULL;
-        if (LLVMPrintModuleToFile(ec.module, output_path, &err) != 0) {
+        if (LLVMPrintModuleToFile(module, output_path, &err) != 0) {
             fprintf(stderr, "Failed to write LLVM IR to %s: %s\n",
                     output_path, err ? err : "(unknown error)");
             if (err) LLVMDisposeMessage(err);
             rc = 1;
         }
-    } else {
-        char* ir_text = LLVMPrintModuleToString(ec.module);
+    } else if (rc == 0) {
+        char* ir_text = LLVMPrintModuleToString(module);
         printf("=== LLVM IR ===\n%s", ir_text);
         LLVMDisposeMessage(ir_text);
     }
 
-    sym_free_all(&ec);
-    LLVMDisposeBuilder(ec.builder);
-    LLVMDisposeModule(ec.module);
-    LLVMContextDispose(ec.ctx);
+    if (rc == 0 && options && options->time_report) {
+        char pipeline[32];
+        pipeline_name(options, whole_program, pipeline, sizeof(pipeline));
+        fprintf(stderr, "=== LLVM statistics ===\n");
+        fprintf(stderr, "%-16s %10s\n", "phase", "time (ms)");
+        fprintf(stderr, "%-16s %10.3f\n", "emit", emitted - start);
+        fprintf(stderr, "%-16s %10.3f\n", options->opt_level > 0 ? pipeline : "opt (none)", optimized - emitted);
+        static const char* const output_phases[] = { "output", "output", "codegen", "codegen+link" };
+        fprintf(stderr, "%-16s %10.3f\n", output_phases[file_type], now_ms() - optimized);
+    }
+
+    if (machine) LLVMDisposeTargetMachine(machine);
+    if (module) LLVMDisposeModule(module);
+    LLVMContextDispose(ctx);
     return rc;
 }
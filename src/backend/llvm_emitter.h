@@ -1,12 +1,94 @@
 #ifndef LLVM_EMITTER_H
 #define LLVM_EMITTER_H
 
+#include <llvm-c/Types.h>
+
 #include "../middle/ir_generator.h"
+#include "profile.h"
+
+// What emit_llvm() writes to its output path.
+typedef enum {
+    EMIT_FILE_LLVM_IR,          // textual .ll
+    EMIT_FILE_BITCODE,          // .bc, streamed to the file ("-": stdout)
+    EMIT_FILE_OBJECT,           // native .o for the target machine
+    EMIT_FILE_EXECUTABLE        // object linked by the system linker (native_link.h)
+} EmitFileType;
+
+typedef struct {
+    int jobs;                   // threads emitting functions, and compiling an executable's partitions
+    int opt_level;              // LLVM pipeline default<O1..O3> on the module, 0: none
+    int optimize_size;          // default<Os> instead (opt_level > 0)
+    const char* target_triple;  // target machine for the passes; NULL: the host's
+    const char* cpu;            // NULL: "generic"; "native": the host's, with its features
+    const char* features;       // "+avx2,-sse4a", NULL: none (both also stamped on every function)
+    int time_report;            // emission and optimisation times on stderr
+    EmitFileType file_type;     // with an output path
+    const char* const* link_modules;    // .bc / .ll files linked in before optimisation
+    int link_module_count;
+    const char* profile_generate;       // count entries and branches, written there at exit
+    const Profile* profile_use;         // branch weights and entry counts from a profile run
+    IRProgram* const* sources;          // other source files of the program: functions only
+    int source_count;
+    int debug_info;                     // DWARF subprograms and line locations (-g)
+} EmitOptions;
 
 // Walk the IR program and produce an LLVM IR module.
+// - Each function (and `main`) is emitted separately, on up to `options->jobs`
+//   threads, then linked in source order. `options` may be NULL (one job).
+// - With `options->profile_generate`, every body counts its entries and
+//   branch outcomes, and the program writes them at exit (profile.h). With
+//   `options->profile_use`, branches get `branch_weights`, functions a
+//   `function_entry_count`, and the module a ProfileSummary, which LLVM's
+//   inliner and block placement use.
+// - `options->sources` are emitted the same way, each into a module of its
+//   own without a `main`, and linked in; their functions and the program's
+//   may call each other (ir_infer_types_linked types them together).
+// - `afficher` prints through the output runtime (llvm_runtime.h), defined
+//   in the module; `main` flushes it before returning. Calls made only of
+//   constants are formatted at compile time, neighbouring ones into a single
+//   write.
+// - With `options->debug_info`, every body gets a subprogram and each
+//   instruction the source line of its IR instruction (IrInstruction.line).
+// - Precompiled modules (`options->link_modules`, such as a runtime
+//   library) are linked in, then the module goes through LLVM's
+//   optimisation pipeline for
+//   `options->opt_level` (emit_llvm_optimize). An executable, or a program
+//   with sources, is optimised as a whole: everything but `main` is
+//   internalized first, so functions are inlined across files and dropped
+//   when unused.
 // - If `output_path` is NULL, prints to stdout (preceded by "=== LLVM IR ===\n").
-// - Otherwise writes the module to `output_path` (no banner, no stdout noise).
+// - Otherwise writes the module to `output_path` (no banner, no stdout noise)
+//   as `options->file_type`. Objects, executables and any module built for
+//   a target machine (-O1 and up, a triple, CPU or features) get its triple
+//   and data layout before the pipeline runs; plain -O0 IR stays
+//   target-neutral.
+// - An executable's code generation is split by function over
+//   `options->jobs` threads, one object per partition, linked together.
 // Returns 0 on success, non-zero on error.
-int emit_llvm(IRProgram* program, const char* module_name, const char* output_path);
+int emit_llvm(IRProgram* program, const char* module_name, const char* output_path,
+              const EmitOptions* options);
+
+// Same module, built in `ctx` and handed to the caller (who disposes it),
+// for in-process use such as the JIT. Not optimised. Returns NULL after
+// reporting an error.
+LLVMModuleRef emit_llvm_module(IRProgram* program, const char* module_name, LLVMContextRef ctx,
+                               const EmitOptions* options);
+
+// Runs LLVM's new pass manager over `module` ("default<O2>", ...) with a
+// target machine built from `options`. Nothing to do at opt_level 0.
+// Returns 0, or non-zero after reporting an error (unknown target, ...).
+int emit_llvm_optimize(LLVMModuleRef module, const EmitOptions* options);
+
+// Whether `func` and every function it calls, directly or not, only use
+// instructions this emitter lowers (arrays are still dropped).
+int emit_llvm_can_lower(const IRProgram* program, const IrFunction* func);
+
+// Module holding `func`, the functions it calls (internal copies), and
+// `void entry_name(const void* args, void* result)`, which calls `func` with
+// its arguments read from 8-byte slots (the value at offset 0, booleen as
+// i32) and stores the result in the same form, flushing what it printed. For callers that hold values
+// untyped, such as the interpreter's tier-up.
+LLVMModuleRef emit_llvm_entry_module(IRProgram* program, IrFunction* func, const char* entry_name,
+                                     LLVMContextRef ctx);
 
 #endif // LLVM_EMITTER_H
@@ -0,0 +1,401 @@
+#include "llvm_runtime.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <llvm-c/Core.h>
+
+// Bytes buffered between two writes.
+#define OUT_CAPACITY 8192
+// Longest "%f" of a double: sign, 309 integer digits, point, 6 decimals.
+#define REAL_MAX_LENGTH 320
+// "-2147483648"
+#define INT_MAX_LENGTH 11
+
+static const char* const runtime_names[RUNTIME_FUNCTION_COUNT] = {
+    "__cyp_flush", "__cyp_write", "__cyp_print_int", "__cyp_print_real", "__cyp_print_str",
+    "__cyp_format_int", "__cyp_format_real", "__cyp_format_str",
+};
+
+static LLVMTypeRef function_type(LLVMContextRef ctx, RuntimeFunction fn) {
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(ctx);
+    LLVMTypeRef params[2] = { LLVMPointerType(LLVMInt8TypeInContext(ctx), 0),
+                              LLVMPointerType(LLVMInt8TypeInContext(ctx), 0) };
+    switch (fn) {
+        case RUNTIME_FLUSH:
+            return LLVMFunctionType(LLVMVoidTypeInContext(ctx), NULL, 0, 0);
+        case RUNTIME_WRITE:
+            params[1] = LLVMInt64TypeInContext(ctx);
+            return LLVMFunctionType(i32, params, 2, 0);
+        case RUNTIME_PRINT_INT:
+            return LLVMFunctionType(i32, &i32, 1, 0);
+        case RUNTIME_PRINT_REAL:
+            params[0] = LLVMDoubleTypeInContext(ctx);
+            return LLVMFunctionType(i32, params, 1, 0);
+        case RUNTIME_PRINT_STR:
+            return LLVMFunctionType(i32, params, 1, 0);
+        case RUNTIME_FORMAT_INT:
+            params[1] = i32;
+            return LLVMFunctionType(i32, params, 2, 0);
+        case RUNTIME_FORMAT_REAL:
+            params[1] = LLVMDoubleTypeInContext(ctx);
+            return LLVMFunctionType(i32, params, 2, 0);
+        default:
+            return LLVMFunctionType(i32, params, 2, 0);
+    }
+}
+
+LLVMValueRef runtime_function(LLVMModuleRef module, RuntimeFunction fn) {
+    LLVMValueRef function = LLVMGetNamedFunction(module, runtime_names[fn]);
+    if (function) return function;
+    return LLVMAddFunction(module, runtime_names[fn], function_type(LLVMGetModuleContext(module), fn));
+}
+
+// ---------- building blocks ----------
+
+typedef struct {
+    LLVMModuleRef module;
+    LLVMContextRef ctx;
+    LLVMBuilderRef builder;
+    LLVMTypeRef i8_type;
+    LLVMTypeRef i32_type;
+    LLVMTypeRef i64_type;
+    LLVMTypeRef ptr_type;
+    LLVMValueRef buffer;    // first byte of the thread-local [OUT_CAPACITY x i8]
+    LLVMValueRef length;    // thread-local i64: bytes used in `buffer`
+    LLVMValueRef function;  // being defined
+} Runtime;
+
+static LLVMValueRef thread_local_global(Runtime* rt, const char* name, LLVMTypeRef type) {
+    LLVMValueRef global = LLVMGetNamedGlobal(rt->module, name);
+    if (global) return global;
+    global = LLVMAddGlobal(rt->module, type, name);
+    LLVMSetInitializer(global, LLVMConstNull(type));
+    LLVMSetLinkage(global, LLVMInternalLinkage);
+    LLVMSetThreadLocal(global, 1);
+    return global;
+}
+
+static LLVMValueRef libc_function(Runtime* rt, const char* name, LLVMTypeRef ret, LLVMTypeRef* params,
+                                  unsigned count, int vararg) {
+    LLVMValueRef function = LLVMGetNamedFunction(rt->module, name);
+    if (function) return function;
+    return LLVMAddFunction(rt->module, name, LLVMFunctionType(ret, params, count, vararg));
+}
+
+static LLVMValueRef call(Runtime* rt, LLVMValueRef function, LLVMValueRef* args, unsigned count) {
+    return LLVMBuildCall2(rt->builder, LLVMGlobalGetValueType(function), function, args, count, "");
+}
+
+static LLVMValueRef call_runtime(Runtime* rt, RuntimeFunction fn, LLVMValueRef* args, unsigned count) {
+    return call(rt, runtime_function(rt->module, fn), args, count);
+}
+
+static LLVMValueRef call_snprintf(Runtime* rt, LLVMValueRef out, LLVMValueRef size, LLVMValueRef format,
+                                  LLVMValueRef value) {
+    LLVMTypeRef params[3] = { rt->ptr_type, rt->i64_type, rt->ptr_type };
+    LLVMValueRef args[4] = { out, size, format, value };
+    return call(rt, libc_function(rt, "snprintf", rt->i32_type, params, 3, 1), args, 4);
+}
+
+static LLVMBasicBlockRef block(Runtime* rt, const char* name) {
+    return LLVMAppendBasicBlockInContext(rt->ctx, rt->function, name);
+}
+
+static LLVMValueRef i64_const(Runtime* rt, unsigned long long value) {
+    return LLVMConstInt(rt->i64_type, value, 0);
+}
+
+// &base[offset], `base` pointing to bytes.
+static LLVMValueRef byte_at(Runtime* rt, LLVMValueRef base, LLVMValueRef offset) {
+    return LLVMBuildInBoundsGEP2(rt->builder, rt->i8_type, base, &offset, 1, "at");
+}
+
+static LLVMValueRef load_length(Runtime* rt) {
+    return LLVMBuildLoad2(rt->builder, rt->i64_type, rt->length, "length");
+}
+
+// ---------- entry points ----------
+
+static void add_attribute(Runtime* rt, const char* name) {
+    unsigned kind = LLVMGetEnumAttributeKindForName(name, strlen(name));
+    LLVMAddAttributeAtIndex(rt->function, LLVMAttributeFunctionIndex, LLVMCreateEnumAttribute(rt->ctx, kind, 0));
+}
+
+// if (length) { fflush(NULL); write(1, buffer, length) until done or failing; length = 0; }
+// Kept out of line: the callers' fast path is a copy into the buffer.
+static void define_flush(Runtime* rt) {
+    add_attribute(rt, "noinline");
+    add_attribute(rt, "cold");
+    LLVMBasicBlockRef flush = block(rt, "flush");
+    LLVMBasicBlockRef loop = block(rt, "loop");
+    LLVMBasicBlockRef more = block(rt, "more");
+    LLVMBasicBlockRef done = block(rt, "done");
+    LLVMBasicBlockRef out = block(rt, "out");
+    LLVMValueRef length = load_length(rt);
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntNE, length, i64_const(rt, 0), ""), flush, out);
+
+    LLVMPositionBuilderAtEnd(rt->builder, flush);
+    LLVMValueRef null = LLVMConstNull(rt->ptr_type);
+    call(rt, libc_function(rt, "fflush", rt->i32_type, &rt->ptr_type, 1, 0), &null, 1);
+    LLVMBuildBr(rt->builder, loop);
+
+    LLVMPositionBuilderAtEnd(rt->builder, loop);
+    LLVMValueRef written = LLVMBuildPhi(rt->builder, rt->i64_type, "written");
+    LLVMTypeRef write_params[3] = { rt->i32_type, rt->ptr_type, rt->i64_type };
+    LLVMValueRef write_args[3] = { LLVMConstInt(rt->i32_type, 1, 0), byte_at(rt, rt->buffer, written),
+                                   LLVMBuildSub(rt->builder, length, written, "") };
+    LLVMValueRef n = call(rt, libc_function(rt, "write", rt->i64_type, write_params, 3, 0), write_args, 3);
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntSGT, n, i64_const(rt, 0), ""), more, done);
+
+    LLVMPositionBuilderAtEnd(rt->builder, more);
+    LLVMValueRef next = LLVMBuildAdd(rt->builder, written, n, "");
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntULT, next, length, ""), loop, done);
+    LLVMValueRef incoming[2] = { i64_const(rt, 0), next };
+    LLVMBasicBlockRef from[2] = { flush, more };
+    LLVMAddIncoming(written, incoming, from, 2);
+
+    LLVMPositionBuilderAtEnd(rt->builder, done);
+    LLVMBuildStore(rt->builder, i64_const(rt, 0), rt->length);
+    LLVMBuildBr(rt->builder, out);
+    LLVMPositionBuilderAtEnd(rt->builder, out);
+    LLVMBuildRetVoid(rt->builder);
+}
+
+// Appends text[0 .. n) to the buffer, flushing it as often as it fills.
+static void define_write(Runtime* rt) {
+    LLVMBasicBlockRef copy = block(rt, "copy");
+    LLVMBasicBlockRef spill = block(rt, "spill");
+    LLVMBasicBlockRef rest = block(rt, "rest");
+    LLVMBasicBlockRef done = block(rt, "done");
+    LLVMValueRef text = LLVMGetParam(rt->function, 0);
+    LLVMValueRef n = LLVMGetParam(rt->function, 1);
+    LLVMValueRef count = LLVMBuildTrunc(rt->builder, n, rt->i32_type, "count");
+    LLVMValueRef length = load_length(rt);
+    LLVMValueRef room = LLVMBuildSub(rt->builder, i64_const(rt, OUT_CAPACITY), length, "room");
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntULE, n, room, ""), copy, spill);
+
+    LLVMPositionBuilderAtEnd(rt->builder, copy);
+    LLVMBuildMemCpy(rt->builder, byte_at(rt, rt->buffer, length), 1, text, 1, n);
+    LLVMBuildStore(rt->builder, LLVMBuildAdd(rt->builder, length, n, ""), rt->length);
+    LLVMBuildRet(rt->builder, count);
+
+    // Full: flush, keep what fits, and write the rest the same way.
+    LLVMPositionBuilderAtEnd(rt->builder, spill);
+    call_runtime(rt, RUNTIME_FLUSH, NULL, 0);
+    LLVMValueRef fits = LLVMBuildICmp(rt->builder, LLVMIntULE, n, i64_const(rt, OUT_CAPACITY), "");
+    LLVMValueRef piece = LLVMBuildSelect(rt->builder, fits, n, i64_const(rt, OUT_CAPACITY), "piece");
+    LLVMBuildMemCpy(rt->builder, rt->buffer, 1, text, 1, piece);
+    LLVMBuildStore(rt->builder, piece, rt->length);
+    LLVMBuildCondBr(rt->builder, fits, done, rest);
+
+    LLVMPositionBuilderAtEnd(rt->builder, rest);
+    LLVMValueRef args[2] = { byte_at(rt, text, piece), LLVMBuildSub(rt->builder, n, piece, "") };
+    call_runtime(rt, RUNTIME_WRITE, args, 2);
+    LLVMBuildBr(rt->builder, done);
+    LLVMPositionBuilderAtEnd(rt->builder, done);
+    LLVMBuildRet(rt->builder, count);
+}
+
+// Digits from the right, two at a time from a "00".."99" table, then the sign.
+static void define_print_int(Runtime* rt) {
+    char pairs[201];
+    for (int i = 0; i < 100; i++) {
+        pairs[2 * i] = (char)('0' + i / 10);
+        pairs[2 * i + 1] = (char)('0' + i % 10);
+    }
+    LLVMValueRef table = LLVMGetNamedGlobal(rt->module, "__cyp_digit_pairs");
+    if (!table) {
+        LLVMValueRef init = LLVMConstStringInContext(rt->ctx, pairs, 200, /*DontNullTerminate=*/1);
+        table = LLVMAddGlobal(rt->module, LLVMTypeOf(init), "__cyp_digit_pairs");
+        LLVMSetInitializer(table, init);
+        LLVMSetLinkage(table, LLVMPrivateLinkage);
+        LLVMSetGlobalConstant(table, 1);
+        LLVMSetUnnamedAddress(table, LLVMGlobalUnnamedAddr);
+        LLVMSetAlignment(table, 1);
+    }
+    LLVMValueRef zero = i64_const(rt, 0);
+    LLVMValueRef indices[2] = { zero, zero };
+    // byte_at indexes bytes: start from the first one (typed pointers: [200 x i8]* -> i8*).
+    table = LLVMConstInBoundsGEP2(LLVMGlobalGetValueType(table), table, indices, 2);
+
+    LLVMBasicBlockRef loop = block(rt, "loop");
+    LLVMBasicBlockRef pair = block(rt, "pair");
+    LLVMBasicBlockRef last = block(rt, "last");
+    LLVMBasicBlockRef two = block(rt, "two");
+    LLVMBasicBlockRef one = block(rt, "one");
+    LLVMBasicBlockRef sign = block(rt, "sign");
+    LLVMBasicBlockRef minus = block(rt, "minus");
+    LLVMBasicBlockRef write = block(rt, "write");
+    LLVMTypeRef digits_type = LLVMArrayType(rt->i8_type, INT_MAX_LENGTH);
+    LLVMValueRef digits = LLVMBuildAlloca(rt->builder, digits_type, "digits");
+    digits = LLVMBuildInBoundsGEP2(rt->builder, digits_type, digits, indices, 2, "");
+    LLVMValueRef pos = LLVMBuildAlloca(rt->builder, rt->i64_type, "pos");
+    LLVMValueRef rest = LLVMBuildAlloca(rt->builder, rt->i64_type, "rest");
+    LLVMValueRef value = LLVMGetParam(rt->function, 0);
+    LLVMValueRef negative = LLVMBuildICmp(rt->builder, LLVMIntSLT, value, LLVMConstInt(rt->i32_type, 0, 0), "negative");
+    LLVMValueRef wide = LLVMBuildSExt(rt->builder, value, rt->i64_type, "");
+    LLVMBuildStore(rt->builder, LLVMBuildSelect(rt->builder, negative, LLVMBuildNeg(rt->builder, wide, ""), wide, ""), rest);
+    LLVMBuildStore(rt->builder, i64_const(rt, INT_MAX_LENGTH), pos);
+    LLVMBuildBr(rt->builder, loop);
+
+    LLVMPositionBuilderAtEnd(rt->builder, loop);
+    LLVMValueRef u = LLVMBuildLoad2(rt->builder, rt->i64_type, rest, "u");
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntUGE, u, i64_const(rt, 100), ""), pair, last);
+
+    LLVMPositionBuilderAtEnd(rt->builder, pair);
+    LLVMValueRef q = LLVMBuildUDiv(rt->builder, u, i64_const(rt, 100), "");
+    LLVMValueRef r = LLVMBuildSub(rt->builder, u, LLVMBuildMul(rt->builder, q, i64_const(rt, 100), ""), "");
+    LLVMValueRef p = LLVMBuildSub(rt->builder, LLVMBuildLoad2(rt->builder, rt->i64_type, pos, ""), i64_const(rt, 2), "");
+    LLVMValueRef source = byte_at(rt, table, LLVMBuildShl(rt->builder, r, i64_const(rt, 1), ""));
+    LLVMBuildMemCpy(rt->builder, byte_at(rt, digits, p), 1, source, 1, i64_const(rt, 2));
+    LLVMBuildStore(rt->builder, p, pos);
+    LLVMBuildStore(rt->builder, q, rest);
+    LLVMBuildBr(rt->builder, loop);
+
+    LLVMPositionBuilderAtEnd(rt->builder, last);
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntUGE, u, i64_const(rt, 10), ""), two, one);
+
+    LLVMPositionBuilderAtEnd(rt->builder, two);
+    p = LLVMBuildSub(rt->builder, LLVMBuildLoad2(rt->builder, rt->i64_type, pos, ""), i64_const(rt, 2), "");
+    source = byte_at(rt, table, LLVMBuildShl(rt->builder, u, i64_const(rt, 1), ""));
+    LLVMBuildMemCpy(rt->builder, byte_at(rt, digits, p), 1, source, 1, i64_const(rt, 2));
+    LLVMBuildStore(rt->builder, p, pos);
+    LLVMBuildBr(rt->builder, sign);
+
+    LLVMPositionBuilderAtEnd(rt->builder, one);
+    p = LLVMBuildSub(rt->builder, LLVMBuildLoad2(rt->builder, rt->i64_type, pos, ""), i64_const(rt, 1), "");
+    LLVMValueRef digit = LLVMBuildAdd(rt->builder, LLVMBuildTrunc(rt->builder, u, rt->i8_type, ""),
+                                      LLVMConstInt(rt->i8_type, '0', 0), "");
+    LLVMBuildStore(rt->builder, digit, byte_at(rt, digits, p));
+    LLVMBuildStore(rt->builder, p, pos);
+    LLVMBuildBr(rt->builder, sign);
+
+    LLVMPositionBuilderAtEnd(rt->builder, sign);
+    LLVMBuildCondBr(rt->builder, negative, minus, write);
+
+    LLVMPositionBuilderAtEnd(rt->builder, minus);
+    p = LLVMBuildSub(rt->builder, LLVMBuildLoad2(rt->builder, rt->i64_type, pos, ""), i64_const(rt, 1), "");
+    LLVMBuildStore(rt->builder, LLVMConstInt(rt->i8_type, '-', 0), byte_at(rt, digits, p));
+    LLVMBuildStore(rt->builder, p, pos);
+    LLVMBuildBr(rt->builder, write);
+
+    LLVMPositionBuilderAtEnd(rt->builder, write);
+    p = LLVMBuildLoad2(rt->builder, rt->i64_type, pos, "");
+    LLVMValueRef args[2] = { byte_at(rt, digits, p), LLVMBuildSub(rt->builder, i64_const(rt, INT_MAX_LENGTH), p, "") };
+    LLVMBuildRet(rt->builder, call_runtime(rt, RUNTIME_WRITE, args, 2));
+}
+
+// snprintf("%f") straight into the buffer, flushed first unless the
+// longest double fits.
+static void define_print_real(Runtime* rt) {
+    LLVMBasicBlockRef spill = block(rt, "spill");
+    LLVMBasicBlockRef format = block(rt, "format");
+    LLVMValueRef room = LLVMBuildSub(rt->builder, i64_const(rt, OUT_CAPACITY), load_length(rt), "room");
+    LLVMValueRef fits = LLVMBuildICmp(rt->builder, LLVMIntUGE, room, i64_const(rt, REAL_MAX_LENGTH), "");
+    LLVMBuildCondBr(rt->builder, fits, format, spill);
+
+    LLVMPositionBuilderAtEnd(rt->builder, spill);
+    call_runtime(rt, RUNTIME_FLUSH, NULL, 0);
+    LLVMBuildBr(rt->builder, format);
+
+    LLVMPositionBuilderAtEnd(rt->builder, format);
+    LLVMValueRef length = load_length(rt);
+    LLVMValueRef n = call_snprintf(rt, byte_at(rt, rt->buffer, length),
+                                   LLVMBuildSub(rt->builder, i64_const(rt, OUT_CAPACITY), length, ""),
+                                   LLVMBuildGlobalStringPtr(rt->builder, "%f", "__cyp_real_format"),
+                                   LLVMGetParam(rt->function, 0));
+    LLVMValueRef wide = LLVMBuildSExt(rt->builder, n, rt->i64_type, "");
+    LLVMBuildStore(rt->builder, LLVMBuildAdd(rt->builder, length, wide, ""), rt->length);
+    LLVMBuildRet(rt->builder, n);
+}
+
+static void define_print_str(Runtime* rt) {
+    LLVMBasicBlockRef empty = block(rt, "empty");
+    LLVMBasicBlockRef text = block(rt, "text");
+    LLVMValueRef s = LLVMGetParam(rt->function, 0);
+    LLVMBuildCondBr(rt->builder, LLVMBuildIsNull(rt->builder, s, ""), empty, text);
+
+    LLVMPositionBuilderAtEnd(rt->builder, empty);
+    LLVMBuildRet(rt->builder, LLVMConstInt(rt->i32_type, 0, 0));
+
+    LLVMPositionBuilderAtEnd(rt->builder, text);
+    LLVMValueRef args[2] = { s, call(rt, libc_function(rt, "strlen", rt->i64_type, &rt->ptr_type, 1, 0), &s, 1) };
+    LLVMBuildRet(rt->builder, call_runtime(rt, RUNTIME_WRITE, args, 2));
+}
+
+// snprintf(spec, value) into the buffer; when that overflows, again after a
+// flush, or printf itself when even an empty buffer is too small.
+static void define_format(Runtime* rt) {
+    LLVMBasicBlockRef done = block(rt, "done");
+    LLVMBasicBlockRef spill = block(rt, "spill");
+    LLVMBasicBlockRef again = block(rt, "again");
+    LLVMBasicBlockRef direct = block(rt, "direct");
+    LLVMValueRef spec = LLVMGetParam(rt->function, 0);
+    LLVMValueRef value = LLVMGetParam(rt->function, 1);
+    if (LLVMTypeOf(value) == rt->ptr_type) {
+        // NULL chaine as "", like the VM.
+        value = LLVMBuildSelect(rt->builder, LLVMBuildIsNull(rt->builder, value, ""),
+                                LLVMBuildGlobalStringPtr(rt->builder, "", "__cyp_empty"), value, "");
+    }
+    LLVMValueRef length = load_length(rt);
+    LLVMValueRef room = LLVMBuildSub(rt->builder, i64_const(rt, OUT_CAPACITY), length, "room");
+    LLVMValueRef n = call_snprintf(rt, byte_at(rt, rt->buffer, length), room, spec, value);
+    LLVMValueRef wide = LLVMBuildSExt(rt->builder, n, rt->i64_type, "");
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntULT, wide, room, ""), done, spill);
+
+    LLVMPositionBuilderAtEnd(rt->builder, done);
+    LLVMBuildStore(rt->builder, LLVMBuildAdd(rt->builder, length, wide, ""), rt->length);
+    LLVMBuildRet(rt->builder, n);
+
+    LLVMPositionBuilderAtEnd(rt->builder, spill);
+    call_runtime(rt, RUNTIME_FLUSH, NULL, 0);
+    LLVMBuildCondBr(rt->builder, LLVMBuildICmp(rt->builder, LLVMIntULT, wide, i64_const(rt, OUT_CAPACITY), ""),
+                    again, direct);
+
+    LLVMPositionBuilderAtEnd(rt->builder, again);
+    call_snprintf(rt, rt->buffer, i64_const(rt, OUT_CAPACITY), spec, value);
+    LLVMBuildStore(rt->builder, wide, rt->length);
+    LLVMBuildRet(rt->builder, n);
+
+    // stdio's own buffer: the next flush writes it out first.
+    LLVMPositionBuilderAtEnd(rt->builder, direct);
+    LLVMValueRef args[2] = { spec, value };
+    LLVMBuildRet(rt->builder, call(rt, libc_function(rt, "printf", rt->i32_type, &rt->ptr_type, 1, 1), args, 2));
+}
+
+static void (*const definers[RUNTIME_FUNCTION_COUNT])(Runtime*) = {
+    define_flush, define_write, define_print_int, define_print_real, define_print_str,
+    define_format, define_format, define_format,
+};
+
+void runtime_define(LLVMModuleRef module) {
+    Runtime rt = { 0 };
+    rt.module = module;
+    rt.ctx = LLVMGetModuleContext(module);
+    rt.i8_type = LLVMInt8TypeInContext(rt.ctx);
+    rt.i32_type = LLVMInt32TypeInContext(rt.ctx);
+    rt.i64_type = LLVMInt64TypeInContext(rt.ctx);
+    rt.ptr_type = LLVMPointerType(rt.i8_type, 0);
+
+    // Each entry point only calls those before it: defining from the last
+    // one declares what the next ones define.
+    for (int fn = RUNTIME_FUNCTION_COUNT - 1; fn >= 0; fn--) {
+        LLVMValueRef function = LLVMGetNamedFunction(module, runtime_names[fn]);
+        if (!function || !LLVMIsDeclaration(function)) continue;
+        if (!rt.builder) {
+            rt.builder = LLVMCreateBuilderInContext(rt.ctx);
+            LLVMTypeRef buffer_type = LLVMArrayType(rt.i8_type, OUT_CAPACITY);
+            LLVMValueRef zero = i64_const(&rt, 0);
+            LLVMValueRef indices[2] = { zero, zero };
+            rt.buffer = LLVMConstInBoundsGEP2(buffer_type, thread_local_global(&rt, "__cyp_out", buffer_type),
+                                              indices, 2);
+            rt.length = thread_local_global(&rt, "__cyp_out_length", rt.i64_type);
+        }
+        rt.function = function;
+        LLVMSetLinkage(function, LLVMInternalLinkage);
+        LLVMPositionBuilderAtEnd(rt.builder, block(&rt, "entry"));
+        definers[fn](&rt);
+    }
+    if (rt.builder) LLVMDisposeBuilder(rt.builder);
+}
@@ -0,0 +1,35 @@
+#ifndef LLVM_RUNTIME_H
+#define LLVM_RUNTIME_H
+
+#include <llvm-c/Types.h>
+
+// The runtime behind `afficher` in compiled code, built as LLVM IR into the
+// module that uses it, so executables, objects and JIT-compiled code need
+// nothing beyond libc.
+//
+// Output goes to a thread-local buffer, written to stdout (fd 1) when full
+// and by __cyp_flush, which compiled `main` calls before returning. A flush
+// first flushes stdio, so text printf'd by the host (the VM, in a tiered
+// run) comes out in order. Every entry point returns the number of
+// characters it printed.
+
+typedef enum {
+    RUNTIME_FLUSH,          // void ()
+    RUNTIME_WRITE,          // i32 (ptr text, i64 length)
+    RUNTIME_PRINT_INT,      // i32 (i32): "%d"
+    RUNTIME_PRINT_REAL,     // i32 (double): "%f"
+    RUNTIME_PRINT_STR,      // i32 (ptr): "%s", NULL as ""
+    RUNTIME_FORMAT_INT,     // i32 (ptr spec, i32): any other conversion, through snprintf
+    RUNTIME_FORMAT_REAL,    // i32 (ptr spec, double)
+    RUNTIME_FORMAT_STR,     // i32 (ptr spec, ptr)
+    RUNTIME_FUNCTION_COUNT
+} RuntimeFunction;
+
+// Declaration of `fn` in `module`, added on first use.
+LLVMValueRef runtime_function(LLVMModuleRef module, RuntimeFunction fn);
+
+// Defines, with internal linkage, every runtime function `module` declares
+// and those they call. Once per module, after the code using them.
+void runtime_define(LLVMModuleRef module);
+
+#endif // LLVM_RUNTIME_H
@@ -0,0 +1,64 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "native_link.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int link_executable(const char* const* objects, int object_count, const char* output_path) {
+    const char* driver = getenv("CC");
+    if (!driver || !*driver) driver = "cc";
+
+    // driver OBJECTS... -o OUTPUT
+    const char** argv = malloc(sizeof(char*) * (size_t)(object_count + 4));
+    int argc = 0;
+    argv[argc++] = driver;
+    for (int i = 0; i < object_count; i++) argv[argc++] = objects[i];
+    argv[argc++] = "-o";
+    argv[argc++] = output_path;
+    argv[argc] = NULL;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        execvp(driver, (char* const*)argv);
+        fprintf(stderr, "Cannot run linker '%s': ", driver);
+        perror(NULL);
+        _exit(127);
+    }
+    free(argv);
+    if (pid < 0) {
+        perror("Cannot start linker");
+        return 1;
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("Cannot wait for linker");
+        return 1;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Link of %s failed (%s)\n", output_path, driver);
+        return 1;
+    }
+    return 0;
+}
+
+char* temp_object_path(void) {
+    const char* dir = getenv("TMPDIR");
+    if (!dir || !*dir) dir = "/tmp";
+    size_t len = strlen(dir) + sizeof("/cyplang-XXXXXX");
+    char* path = malloc(len);
+    snprintf(path, len, "%s/cyplang-XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("Cannot create temporary object file");
+        free(path);
+        return NULL;
+    }
+    close(fd);
+    return path;
+}
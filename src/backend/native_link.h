@@ -0,0 +1,15 @@
+#ifndef NATIVE_LINK_H
+#define NATIVE_LINK_H
+
+// Final link of object files into an executable, through the system C
+// compiler driver ($CC, default `cc`), which adds the C start files and
+// libc that the emitted code calls (printf, ...). No source is compiled.
+
+// Returns 0, or non-zero after reporting on stderr.
+int link_executable(const char* const* objects, int object_count, const char* output_path);
+
+// A new empty temporary file for an intermediate object, as a malloc'd path
+// the caller unlinks and frees. NULL after reporting on stderr.
+char* temp_object_path(void);
+
+#endif // NATIVE_LINK_H
@@ -0,0 +1,75 @@
+#include "profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void parse_error(const char* path, int line, FILE* file, Profile* profile) {
+    fprintf(stderr, "%s:%d: malformed profile\n", path, line);
+    fclose(file);
+    profile_free(profile);
+}
+
+Profile* profile_load(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open profile %s: ", path);
+        perror(NULL);
+        return NULL;
+    }
+
+    Profile* profile = calloc(1, sizeof(Profile));
+    int capacity = 0;
+    int line = 0;
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        line++;
+        if (buffer[0] == '#' || buffer[0] == '\n') continue;
+
+        char name[256];
+        int size = 0, branch_count = 0;
+        long long entries = 0;
+        if (sscanf(buffer, "fonction %255s %d %lld %d", name, &size, &entries, &branch_count) != 4 ||
+            branch_count < 0) {
+            parse_error(path, line, file, profile);
+            return NULL;
+        }
+        if (profile->function_count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            profile->functions = realloc(profile->functions, sizeof(ProfileFunction) * (size_t)capacity);
+        }
+        ProfileFunction* f = &profile->functions[profile->function_count++];
+        f->name = strdup(name);
+        f->size = size;
+        f->entries = entries;
+        f->branch_count = branch_count;
+        f->branches = calloc((size_t)(branch_count > 0 ? branch_count : 1), sizeof(*f->branches));
+        for (int b = 0; b < branch_count; b++) {
+            line++;
+            if (!fgets(buffer, sizeof(buffer), file) ||
+                sscanf(buffer, "%lld %lld", &f->branches[b][0], &f->branches[b][1]) != 2) {
+                parse_error(path, line, file, profile);
+                return NULL;
+            }
+        }
+    }
+    fclose(file);
+    return profile;
+}
+
+void profile_free(Profile* profile) {
+    if (!profile) return;
+    for (int i = 0; i < profile->function_count; i++) {
+        free(profile->functions[i].name);
+        free(profile->functions[i].branches);
+    }
+    free(profile->functions);
+    free(profile);
+}
+
+const ProfileFunction* profile_find(const Profile* profile, const char* name) {
+    for (int i = 0; profile && i < profile->function_count; i++) {
+        if (strcmp(profile->functions[i].name, name) == 0) return &profile->functions[i];
+    }
+    return NULL;
+}
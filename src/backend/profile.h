@@ -0,0 +1,40 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Execution profiles for profile-guided optimisation.
+//
+// A program compiled with `--profile-generate` counts, for each body, its
+// entries and both outcomes of every `if !t goto` in emission order, and
+// writes them at exit as text:
+//
+//   # cyplang profile
+//   fonction NAME SIZE ENTRIES BRANCHES
+//   FALLTHROUGH JUMP        (BRANCHES lines)
+//
+// SIZE is the body's IR instruction count. A profile only applies to a
+// body with the same size and branch count, so it must come from a build
+// with the same IR options (-O, --passes).
+
+typedef struct {
+    char* name;
+    int size;
+    long long entries;
+    int branch_count;
+    long long (*branches)[2];   // [fallthrough, jump] per branch
+} ProfileFunction;
+
+typedef struct Profile {
+    ProfileFunction* functions;
+    int function_count;
+} Profile;
+
+// Returns NULL after reporting on stderr (missing file, bad syntax).
+Profile* profile_load(const char* path);
+void profile_free(Profile* profile);
+// NULL if the profile has no record for `name`.
+const ProfileFunction* profile_find(const Profile* profile, const char* name);
+
+// Name of the file an instrumented program writes when no other is given.
+#define PROFILE_DEFAULT_PATH "cyplang.profile"
+
+#endif // PROFILE_H
@@ -0,0 +1,168 @@
+#include "tier.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "jit.h"
+#include "llvm_emitter.h"
+#include "vm.h"
+
+typedef enum {
+    TIER_QUEUED,        // requested, not compiled yet (or the program ended first)
+    TIER_COMPILED,
+    TIER_UNSUPPORTED,   // uses something the emitter does not lower yet
+    TIER_FAILED
+} TierState;
+
+typedef struct {
+    IrFunction* func;
+    int requested;
+    TierState state;
+    long calls, backedges;      // counts when the request fired
+    double requested_ms;        // since the start of the run
+    double native_ms;
+} TierFunction;
+
+typedef struct {
+    IRProgram* program;
+    const TierOptions* options;
+    JitSession* session;        // set up by the first compilation
+    TierFunction* functions;    // indexed like BcProgram.functions
+    _Atomic(VmNative)* natives;
+    struct timespec start;
+
+    // Requests, in order. Each function is requested at most once.
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int* queue;
+    int queue_head, queue_tail;
+    int stopping;
+} Tier;
+
+static double elapsed_ms(const Tier* tier) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - tier->start.tv_sec) * 1e3 + (double)(now.tv_nsec - tier->start.tv_nsec) / 1e6;
+}
+
+// Compiles one requested function and publishes its native code. The JIT is
+// only set up once something is hot, so short runs never pay for it.
+static void compile_function(Tier* tier, int function) {
+    TierFunction* f = &tier->functions[function];
+    if (!emit_llvm_can_lower(tier->program, f->func)) {
+        f->state = TIER_UNSUPPORTED;
+        return;
+    }
+    if (!tier->session) tier->session = jit_session_create();
+    // Hot code is worth the full pipeline, whatever the run's -O level.
+    EmitOptions emit = { .jobs = 1, .opt_level = 2 };
+    JitEntry entry = tier->session ? jit_compile_entry(tier->session, tier->program, f->func, &emit) : NULL;
+    if (!entry) {
+        f->state = TIER_FAILED;
+        return;
+    }
+    f->state = TIER_COMPILED;
+    f->native_ms = elapsed_ms(tier);
+    atomic_store_explicit(&tier->natives[function], entry, memory_order_release);
+}
+
+// VM thread: queue the function and return to interpreting, or compile it
+// right away with --tier-sync.
+static void request(void* data, int function, long calls, long backedges) {
+    Tier* tier = (Tier*)data;
+    TierFunction* f = &tier->functions[function];
+    pthread_mutex_lock(&tier->lock);
+    f->requested = 1;
+    f->state = TIER_QUEUED;
+    f->calls = calls;
+    f->backedges = backedges;
+    f->requested_ms = elapsed_ms(tier);
+    if (!tier->options->sync) {
+        tier->queue[tier->queue_tail++] = function;
+        pthread_cond_signal(&tier->wake);
+    }
+    pthread_mutex_unlock(&tier->lock);
+    if (tier->options->sync) compile_function(tier, function);
+}
+
+// Background thread: compiles queued functions until the program ends.
+static void* compile_worker(void* data) {
+    Tier* tier = (Tier*)data;
+    for (;;) {
+        pthread_mutex_lock(&tier->lock);
+        while (tier->queue_head == tier->queue_tail && !tier->stopping) {
+            pthread_cond_wait(&tier->wake, &tier->lock);
+        }
+        if (tier->stopping) {
+            pthread_mutex_unlock(&tier->lock);
+            break;
+        }
+        int function = tier->queue[tier->queue_head++];
+        pthread_mutex_unlock(&tier->lock);
+        compile_function(tier, function);
+    }
+    return NULL;
+}
+
+static void print_report(const Tier* tier, int count, const TierOptions* options, FILE* out) {
+    fprintf(out, "tier-up after %d calls or %d back-edges:\n", options->call_threshold, options->backedge_threshold);
+    fprintf(out, "%-16s %10s %10s %14s %11s  %s\n", "function", "calls", "back-edges", "requested (ms)",
+            "native (ms)", "state");
+    for (int i = 0; i < count; i++) {
+        const TierFunction* f = &tier->functions[i];
+        if (!f->requested) continue;
+        static const char* const states[] = { "pending", "compiled", "not lowered", "failed" };
+        fprintf(out, "%-16s %10ld %10ld %14.2f ", f->func->name, f->calls, f->backedges, f->requested_ms);
+        if (f->state == TIER_COMPILED) {
+            fprintf(out, "%11.2f", f->native_ms);
+        } else {
+            fprintf(out, "%11s", "-");
+        }
+        fprintf(out, "  %s\n", states[f->state]);
+    }
+}
+
+int tier_run(IRProgram* program, const BcProgram* bytecode, const TierOptions* options) {
+    int count = bytecode->function_count;
+    Tier tier;
+    tier.program = program;
+    tier.options = options;
+    tier.session = NULL;
+    tier.functions = calloc((size_t)count, sizeof(TierFunction));
+    tier.natives = calloc((size_t)count, sizeof(*tier.natives));
+    tier.queue = calloc((size_t)count, sizeof(int));
+    tier.queue_head = tier.queue_tail = 0;
+    tier.stopping = 0;
+    pthread_mutex_init(&tier.lock, NULL);
+    pthread_cond_init(&tier.wake, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &tier.start);
+
+    // Bytecode functions are the IR functions in order, then the global code.
+    IrFunction* f = program->functions;
+    for (int i = 0; i < count && f; i++, f = f->next) tier.functions[i].func = f;
+
+    pthread_t worker;
+    pthread_create(&worker, NULL, compile_worker, &tier);
+
+    VmTiering tiering = { options->call_threshold, options->backedge_threshold, request, &tier, tier.natives };
+    int rc = vm_run(bytecode, &tiering);
+
+    pthread_mutex_lock(&tier.lock);
+    tier.stopping = 1;
+    pthread_cond_signal(&tier.wake);
+    pthread_mutex_unlock(&tier.lock);
+    pthread_join(worker, NULL);
+    // Native code is gone with the session: the VM has stopped by now.
+    jit_session_dispose(tier.session);
+
+    if (options->report) print_report(&tier, count, options, stderr);
+
+    pthread_cond_destroy(&tier.wake);
+    pthread_mutex_destroy(&tier.lock);
+    free(tier.queue);
+    free(tier.natives);
+    free(tier.functions);
+    return rc;
+}
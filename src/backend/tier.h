@@ -0,0 +1,28 @@
+#ifndef TIER_H
+#define TIER_H
+
+#include "bytecode.h"
+
+// Tiered execution for `cyplang run --tier`: the program starts in the
+// bytecode VM right away; a function whose calls or loop back-edges reach a
+// threshold is compiled through the LLVM emitter, the LLVM -O2 pipeline and
+// ORC on a background thread, and the VM calls the native code from its
+// next call on.
+//
+// Only functions the emitter fully lowers (emit_llvm_can_lower) tier up;
+// the others keep interpreting.
+
+#define TIER_DEFAULT_CALLS 1000
+#define TIER_DEFAULT_LOOPS 10000
+
+typedef struct {
+    int call_threshold;         // calls before compiling (<= 0: never)
+    int backedge_threshold;     // loop back-edges before compiling (<= 0: never)
+    int report;                 // print the tier-up table on stderr at exit
+    int sync;                   // compile on the VM thread, at the request (deterministic)
+} TierOptions;
+
+// Runs `bytecode`, compiled from `program`. Returns vm_run()'s result.
+int tier_run(IRProgram* program, const BcProgram* bytecode, const TierOptions* options);
+
+#endif // TIER_H
@@ -0,0 +1,352 @@
+#include "vm.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Labels-as-values dispatch (one indirect jump per instruction, each with its
+// own branch-predictor entry) where the compiler supports it, a switch loop
+// otherwise.
+#if defined(__GNUC__) && !defined(CYPLANG_VM_SWITCH)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+#define VM_MAX_DEPTH 100000
+
+typedef struct {
+    const BcFunction* function;
+    const int32_t* pc;      // where to resume the caller
+    size_t base;            // first register of the frame in the register stack
+    int32_t result;         // caller register receiving the return value
+} Frame;
+
+typedef struct {
+    VmValue* regs;
+    size_t reg_count, reg_cap;
+    Frame* frames;
+    int depth;
+} Vm;
+
+// Pushes a frame for `callee` and returns its registers, or NULL when the
+// call stack is exhausted. May move the register stack.
+static VmValue* push_frame(Vm* vm, const BcFunction* callee) {
+    if (vm->depth == VM_MAX_DEPTH) return NULL;
+    size_t need = vm->reg_count + (size_t)callee->reg_count;
+    if (need > vm->reg_cap) {
+        while (need > vm->reg_cap) vm->reg_cap = vm->reg_cap ? vm->reg_cap * 2 : 1024;
+        vm->regs = realloc(vm->regs, sizeof(VmValue) * vm->reg_cap);
+    }
+    VmValue* regs = vm->regs + vm->reg_count;
+    memcpy(regs, callee->init, sizeof(VmValue) * (size_t)callee->reg_count);
+    vm->frames[vm->depth].function = callee;
+    vm->frames[vm->depth].base = vm->reg_count;
+    vm->depth++;
+    vm->reg_count = need;
+    return regs;
+}
+
+// ---------- afficher ----------
+
+static int print_value(VmValue v, IrType type) {
+    switch (type) {
+        case IR_TYPE_REEL:   return printf("%f", v.f);
+        case IR_TYPE_CHAINE: return printf("%s", v.s ? v.s : "");
+        default:             return printf("%d", v.i);
+    }
+}
+
+// printf(format, args...) with the arguments' static types: each conversion
+// takes the next argument, converted to what the conversion expects.
+static int vm_print(const VmValue* regs, const int32_t* args, int argc) {
+    if (argc == 0) return 0;
+    if ((IrType)args[1] != IR_TYPE_CHAINE) {
+        int written = 0;
+        for (int a = 0; a < argc; a++) written += print_value(regs[args[2 * a]], (IrType)args[2 * a + 1]);
+        return written;
+    }
+
+    const char* format = regs[args[0]].s ? regs[args[0]].s : "";
+    int next = 1;
+    int written = 0;
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') {
+            putchar(*p);
+            written++;
+            continue;
+        }
+        if (p[1] == '%') {
+            putchar('%');
+            written++;
+            p++;
+            continue;
+        }
+        // Copy the conversion spec (flags, width, precision, length) up to its letter.
+        char spec[32];
+        size_t len = 0;
+        spec[len++] = *p++;
+        while (*p && !strchr("diouxXeEfFgGaAcsp", *p) && len < sizeof(spec) - 2) spec[len++] = *p++;
+        if (!*p) {
+            spec[len] = '\0';
+            written += printf("%s", spec);
+            break;
+        }
+        char conv = *p;
+        spec[len++] = conv;
+        spec[len] = '\0';
+        if (next >= argc) {
+            written += printf("%s", spec);
+            continue;
+        }
+        VmValue v = regs[args[2 * next]];
+        IrType type = (IrType)args[2 * next + 1];
+        next++;
+        if (strchr("eEfFgGaA", conv)) {
+            written += printf(spec, type == IR_TYPE_REEL ? v.f : (double)v.i);
+        } else if (conv == 's') {
+            written += type == IR_TYPE_CHAINE ? printf(spec, v.s ? v.s : "") : print_value(v, type);
+        } else if (conv == 'p') {
+            written += printf(spec, (const void*)v.s);
+        } else {
+            // Length modifiers (%ld, %lld) would read past an int; drop them.
+            char plain[32];
+            size_t k = 0;
+            for (size_t j = 0; j < len; j++) {
+                if (spec[j] != 'l' && spec[j] != 'h' && spec[j] != 'j' && spec[j] != 'z' && spec[j] != 't') {
+                    plain[k++] = spec[j];
+                }
+            }
+            plain[k] = '\0';
+            written += printf(plain, type == IR_TYPE_REEL ? (int)v.f : v.i);
+        }
+    }
+    return written;
+}
+
+// ---------- interpreter ----------
+
+static int runtime_error(Vm* vm, const char* message) {
+    fflush(stdout);
+    const char* where = vm->depth > 0 ? vm->frames[vm->depth - 1].function->name : "main";
+    fprintf(stderr, "erreur d'execution (%s): %s\n", where, message);
+    return 1;
+}
+
+// Wrapping 32-bit arithmetic, as in the compiled code.
+#define WRAP(op, x, y) ((int32_t)((uint32_t)(x) op (uint32_t)(y)))
+
+// Per-function tier-up counters.
+typedef struct {
+    long* calls;
+    long* backedges;
+    char* requested;
+} TierCounts;
+
+// Counts a call or back-edge of `function` and fires its single request
+// when a count reaches its threshold.
+static void tier_count(const VmTiering* tiering, TierCounts* counts, int function, int is_call) {
+    long count = is_call ? ++counts->calls[function] : ++counts->backedges[function];
+    int threshold = is_call ? tiering->call_threshold : tiering->backedge_threshold;
+    if (count != threshold || counts->requested[function]) return;
+    counts->requested[function] = 1;
+    tiering->request(tiering->data, function, counts->calls[function], counts->backedges[function]);
+}
+
+int vm_run(const BcProgram* program, const VmTiering* tiering) {
+#ifdef VM_COMPUTED_GOTO
+    static const void* const dispatch[BC_OP_COUNT] = {
+#define BC_LABEL(name) [BC_##name] = &&op_##name,
+        BC_OPCODES(BC_LABEL)
+#undef BC_LABEL
+    };
+#define CASE(name) op_##name:
+#define NEXT() goto *dispatch[*pc]
+#else
+#define CASE(name) case BC_##name:
+#define NEXT() goto next
+#endif
+
+    Vm vm;
+    memset(&vm, 0, sizeof(vm));
+    vm.frames = malloc(sizeof(Frame) * VM_MAX_DEPTH);
+
+    // Counters only when tiering; the global code never tiers.
+    TierCounts counts = { NULL, NULL, NULL };
+    _Atomic(VmNative)* natives = NULL;
+    if (tiering) {
+        counts.calls = calloc((size_t)program->function_count, sizeof(long));
+        counts.backedges = calloc((size_t)program->function_count, sizeof(long));
+        counts.requested = calloc((size_t)program->function_count, 1);
+        natives = tiering->natives;
+    }
+
+    const BcFunction* function = &program->functions[program->main_index];
+    VmValue* regs = push_frame(&vm, function);
+    const int32_t* pc = function->code;
+    int rc = 0;
+
+#define R(k) regs[pc[k]]
+
+#ifdef VM_COMPUTED_GOTO
+    NEXT();
+#else
+next:
+    switch ((BcOp)*pc) {
+#endif
+
+    CASE(MOV)   R(1) = R(2); pc += 3; NEXT();
+
+    CASE(ADD_I) R(1).i = WRAP(+, R(2).i, R(3).i); pc += 4; NEXT();
+    CASE(SUB_I) R(1).i = WRAP(-, R(2).i, R(3).i); pc += 4; NEXT();
+    CASE(MUL_I) R(1).i = WRAP(*, R(2).i, R(3).i); pc += 4; NEXT();
+    CASE(DIV_I)
+        if (R(3).i == 0) {
+            rc = runtime_error(&vm, "division par zero");
+            goto done;
+        }
+        if (R(3).i == -1 && R(2).i == INT32_MIN) {
+            rc = runtime_error(&vm, "debordement de division");
+            goto done;
+        }
+        R(1).i = R(2).i / R(3).i; pc += 4; NEXT();
+    CASE(MOD_I)
+        if (R(3).i == 0) {
+            rc = runtime_error(&vm, "division par zero");
+            goto done;
+        }
+        if (R(3).i == -1 && R(2).i == INT32_MIN) {
+            rc = runtime_error(&vm, "debordement de division");
+            goto done;
+        }
+        R(1).i = R(2).i % R(3).i; pc += 4; NEXT();
+
+    CASE(ADD_F) R(1).f = R(2).f + R(3).f; pc += 4; NEXT();
+    CASE(SUB_F) R(1).f = R(2).f - R(3).f; pc += 4; NEXT();
+    CASE(MUL_F) R(1).f = R(2).f * R(3).f; pc += 4; NEXT();
+    CASE(DIV_F) R(1).f = R(2).f / R(3).f; pc += 4; NEXT();
+    CASE(MOD_F) R(1).f = fmod(R(2).f, R(3).f); pc += 4; NEXT();
+
+    CASE(NEG_I) R(1).i = WRAP(-, 0, R(2).i); pc += 3; NEXT();
+    CASE(NEG_F) R(1).f = -R(2).f; pc += 3; NEXT();
+    CASE(NOT)   R(1).i = !R(2).i; pc += 3; NEXT();
+    CASE(AND)   R(1).i = R(2).i && R(3).i; pc += 4; NEXT();
+    CASE(OR)    R(1).i = R(2).i || R(3).i; pc += 4; NEXT();
+
+    CASE(EQ_I)  R(1).i = R(2).i == R(3).i; pc += 4; NEXT();
+    CASE(NE_I)  R(1).i = R(2).i != R(3).i; pc += 4; NEXT();
+    CASE(LT_I)  R(1).i = R(2).i <  R(3).i; pc += 4; NEXT();
+    CASE(LE_I)  R(1).i = R(2).i <= R(3).i; pc += 4; NEXT();
+    CASE(GT_I)  R(1).i = R(2).i >  R(3).i; pc += 4; NEXT();
+    CASE(GE_I)  R(1).i = R(2).i >= R(3).i; pc += 4; NEXT();
+    CASE(EQ_F)  R(1).i = R(2).f == R(3).f; pc += 4; NEXT();
+    CASE(NE_F)  R(1).i = R(2).f != R(3).f; pc += 4; NEXT();
+    CASE(LT_F)  R(1).i = R(2).f <  R(3).f; pc += 4; NEXT();
+    CASE(LE_F)  R(1).i = R(2).f <= R(3).f; pc += 4; NEXT();
+    CASE(GT_F)  R(1).i = R(2).f >  R(3).f; pc += 4; NEXT();
+    CASE(GE_F)  R(1).i = R(2).f >= R(3).f; pc += 4; NEXT();
+    CASE(EQ_S)  R(1).i = strcmp(R(2).s ? R(2).s : "", R(3).s ? R(3).s : "") == 0; pc += 4; NEXT();
+    CASE(NE_S)  R(1).i = strcmp(R(2).s ? R(2).s : "", R(3).s ? R(3).s : "") != 0; pc += 4; NEXT();
+
+    CASE(ITOF)  R(1).f = (double)R(2).i; pc += 3; NEXT();
+    CASE(FTOI)  R(1).i = (int32_t)R(2).f; pc += 3; NEXT();
+
+    CASE(JMP)   pc = function->code + pc[1]; NEXT();
+    CASE(LOOP)
+        if (natives && function != &program->functions[program->main_index]) {
+            tier_count(tiering, &counts, (int)(function - program->functions), 0);
+        }
+        pc = function->code + pc[1];
+        NEXT();
+    CASE(JMP_IF_NOT)
+        pc = R(1).i ? pc + 3 : function->code + pc[2];
+        NEXT();
+
+    CASE(JF_EQ_I) pc = R(1).i == R(2).i ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_NE_I) pc = R(1).i != R(2).i ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_LT_I) pc = R(1).i <  R(2).i ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_LE_I) pc = R(1).i <= R(2).i ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_GT_I) pc = R(1).i >  R(2).i ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_GE_I) pc = R(1).i >= R(2).i ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_EQ_F) pc = R(1).f == R(2).f ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_NE_F) pc = R(1).f != R(2).f ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_LT_F) pc = R(1).f <  R(2).f ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_LE_F) pc = R(1).f <= R(2).f ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_GT_F) pc = R(1).f >  R(2).f ? pc + 4 : function->code + pc[3]; NEXT();
+    CASE(JF_GE_F) pc = R(1).f >= R(2).f ? pc + 4 : function->code + pc[3]; NEXT();
+
+    CASE(CALL) {
+        const BcFunction* callee = &program->functions[pc[2]];
+        int argc = pc[3];
+        if (natives) {
+            VmNative native = atomic_load_explicit(&natives[pc[2]], memory_order_acquire);
+            if (native) {
+                VmValue args[BC_MAX_CALL_ARGS];
+                for (int a = 0; a < argc; a++) args[a] = R(4 + a);
+                native(args, &R(1));
+                pc += 4 + argc;
+                NEXT();
+            }
+            tier_count(tiering, &counts, pc[2], 1);
+        }
+        Frame* caller = &vm.frames[vm.depth - 1];
+        caller->pc = pc + 4 + argc;
+        caller->result = pc[1];
+        size_t caller_base = caller->base;
+        VmValue* callee_regs = push_frame(&vm, callee);
+        if (!callee_regs) {
+            rc = runtime_error(&vm, "pile d'appels epuisee (recursion trop profonde ?)");
+            goto done;
+        }
+        regs = vm.regs + caller_base; // the register stack may have moved
+        for (int a = 0; a < argc; a++) callee_regs[a] = regs[pc[4 + a]];
+        regs = callee_regs;
+        function = callee;
+        pc = callee->code;
+        NEXT();
+    }
+
+    CASE(PRINT) {
+        int argc = pc[2];
+        R(1).i = vm_print(regs, pc + 3, argc);
+        pc += 3 + 2 * argc;
+        NEXT();
+    }
+
+    CASE(RET0)
+    CASE(RET) {
+        VmValue value;
+        if ((BcOp)*pc == BC_RET) {
+            value = R(1);
+        } else {
+            memset(&value, 0, sizeof(value));
+        }
+        vm.depth--;
+        vm.reg_count = vm.frames[vm.depth].base;
+        if (vm.depth == 0) goto done;
+        Frame* caller = &vm.frames[vm.depth - 1];
+        function = caller->function;
+        regs = vm.regs + caller->base;
+        pc = caller->pc;
+        regs[caller->result] = value;
+        NEXT();
+    }
+
+#ifndef VM_COMPUTED_GOTO
+    default:
+        rc = runtime_error(&vm, "instruction invalide");
+        goto done;
+    }
+#endif
+
+done:
+    fflush(stdout);
+    free(counts.calls);
+    free(counts.backedges);
+    free(counts.requested);
+    free(vm.regs);
+    free(vm.frames);
+    return rc;
+
+#undef R
+#undef CASE
+#undef NEXT
+}
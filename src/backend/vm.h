@@ -0,0 +1,31 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdatomic.h>
+
+#include "bytecode.h"
+
+// Native code standing in for a bytecode function: reads one VmValue per
+// parameter from `args` and writes the result, a VmValue, to `result`.
+typedef void (*VmNative)(const void* args, void* result);
+
+// Tier-up hooks. The VM counts calls and loop back-edges (LOOP) per
+// function; when a count reaches its threshold it calls `request` once for
+// that function. Whoever serves the request stores native code in
+// `natives[function]`, possibly from another thread, and the VM uses it
+// from the next call on. A function already running keeps interpreting.
+typedef struct {
+    int call_threshold;         // <= 0: calls never trigger a request
+    int backedge_threshold;     // <= 0: back-edges never trigger a request
+    void (*request)(void* data, int function, long calls, long backedges);
+    void* data;
+    _Atomic(VmNative)* natives; // function_count slots, NULL until compiled
+} VmTiering;
+
+// Executes the program's global code (its `main`) in process. `afficher`
+// writes to stdout like the compiled program's printf. `tiering` may be NULL.
+// Returns 0, or 1 after a run-time error (division by zero, call stack
+// exhausted), which is reported on stderr.
+int vm_run(const BcProgram* program, const VmTiering* tiering);
+
+#endif // VM_H
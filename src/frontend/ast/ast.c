@@ -140,7 +140,7 @@ void print_ast(AstNode* node, int depth) {
 }
 
 AstNode* create_program_node() {
-    AstProgram* program = (AstProgram*)malloc(sizeof(AstProgram));
+    AstProgram* program = (AstProgram*)calloc(1, sizeof(AstProgram));
     if (!program) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -152,7 +152,7 @@ AstNode* create_program_node() {
 }
 
 AstNode* create_binary_expr_node(AstNode* left, TokenType operator, AstNode* right) {
-    AstBinaryExpr* expr = (AstBinaryExpr*)malloc(sizeof(AstBinaryExpr));
+    AstBinaryExpr* expr = (AstBinaryExpr*)calloc(1, sizeof(AstBinaryExpr));
     if (!expr) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -165,7 +165,7 @@ AstNode* create_binary_expr_node(AstNode* left, TokenType operator, AstNode* rig
 }
 
 AstNode* create_unary_expr_node(TokenType operator, AstNode* operand) {
-    AstUnaryExpr* expr = (AstUnaryExpr*)malloc(sizeof(AstUnaryExpr));
+    AstUnaryExpr* expr = (AstUnaryExpr*)calloc(1, sizeof(AstUnaryExpr));
     if (!expr) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -177,7 +177,7 @@ AstNode* create_unary_expr_node(TokenType operator, AstNode* operand) {
 }
 
 AstNode* create_variable_decl_node(char* name, AstNode* type, AstNode* initializer) {
-    AstVariableDeclaration* var = (AstVariableDeclaration*)malloc(sizeof(AstVariableDeclaration));
+    AstVariableDeclaration* var = (AstVariableDeclaration*)calloc(1, sizeof(AstVariableDeclaration));
     if (!var) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -190,7 +190,7 @@ AstNode* create_variable_decl_node(char* name, AstNode* type, AstNode* initializ
 }
 
 AstNode* create_function_decl_node(char* name, AstNode** params, int param_count, AstNode* return_type, AstNode* body) {
-    AstFunctionDeclaration* func = (AstFunctionDeclaration*)malloc(sizeof(AstFunctionDeclaration));
+    AstFunctionDeclaration* func = (AstFunctionDeclaration*)calloc(1, sizeof(AstFunctionDeclaration));
     if (!func) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -206,7 +206,7 @@ AstNode* create_function_decl_node(char* name, AstNode** params, int param_count
 
 AstNode* create_parameter_node(char* name, AstNode* type, AstNode* initializer) {
     (void)initializer; // reserved for default-value support; unused for now
-    AstParameter* param = (AstParameter*)malloc(sizeof(AstParameter));
+    AstParameter* param = (AstParameter*)calloc(1, sizeof(AstParameter));
     if (!param) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -219,7 +219,7 @@ AstNode* create_parameter_node(char* name, AstNode* type, AstNode* initializer)
 }
 
 AstNode* create_block_node() {
-    AstBlock* block = (AstBlock*)malloc(sizeof(AstBlock));
+    AstBlock* block = (AstBlock*)calloc(1, sizeof(AstBlock));
     if (!block) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -231,7 +231,7 @@ AstNode* create_block_node() {
 }
 
 AstNode* create_assignment_node(AstNode* target, AstNode* value) {
-    AstAssignment* assign = (AstAssignment*)malloc(sizeof(AstAssignment));
+    AstAssignment* assign = (AstAssignment*)calloc(1, sizeof(AstAssignment));
     if (!assign) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -243,7 +243,7 @@ AstNode* create_assignment_node(AstNode* target, AstNode* value) {
 }
 
 AstNode* create_if_stmt_node(AstNode* condition, AstNode* then_branch, AstNode* else_branch) {
-    AstIfStatement* if_stmt = (AstIfStatement*)malloc(sizeof(AstIfStatement));
+    AstIfStatement* if_stmt = (AstIfStatement*)calloc(1, sizeof(AstIfStatement));
     if (!if_stmt) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -256,7 +256,7 @@ AstNode* create_if_stmt_node(AstNode* condition, AstNode* then_branch, AstNode*
 }
 
 AstNode* create_while_stmt_node(AstNode* condition, AstNode* body) {
-    AstWhileStatement* while_stmt = (AstWhileStatement*)malloc(sizeof(AstWhileStatement));
+    AstWhileStatement* while_stmt = (AstWhileStatement*)calloc(1, sizeof(AstWhileStatement));
     if (!while_stmt) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -268,7 +268,7 @@ AstNode* create_while_stmt_node(AstNode* condition, AstNode* body) {
 }
 
 AstNode* create_for_stmt_node(AstNode* init, AstNode* condition, AstNode* update, AstNode* body, int direction) {
-    AstForStatement* for_stmt = (AstForStatement*)malloc(sizeof(AstForStatement));
+    AstForStatement* for_stmt = (AstForStatement*)calloc(1, sizeof(AstForStatement));
     if (!for_stmt) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -283,7 +283,7 @@ AstNode* create_for_stmt_node(AstNode* init, AstNode* condition, AstNode* update
 }
 
 AstNode* create_return_stmt_node(AstNode* value) {
-    AstReturnStatement* ret = (AstReturnStatement*)malloc(sizeof(AstReturnStatement));
+    AstReturnStatement* ret = (AstReturnStatement*)calloc(1, sizeof(AstReturnStatement));
     if (!ret) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -294,7 +294,7 @@ AstNode* create_return_stmt_node(AstNode* value) {
 }
 
 AstNode* create_function_call_node(char* name, AstNode** arguments, int argument_count) {
-    AstFunctionCall* call = (AstFunctionCall*)malloc(sizeof(AstFunctionCall));
+    AstFunctionCall* call = (AstFunctionCall*)calloc(1, sizeof(AstFunctionCall));
     if (!call) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -307,7 +307,7 @@ AstNode* create_function_call_node(char* name, AstNode** arguments, int argument
 }
 
 AstNode* create_variable_node(char* name) {
-    AstVariable* var = (AstVariable*)malloc(sizeof(AstVariable));
+    AstVariable* var = (AstVariable*)calloc(1, sizeof(AstVariable));
     if (!var) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -318,7 +318,7 @@ AstNode* create_variable_node(char* name) {
 }
 
 AstNode* create_literal_node_int(int value) {
-    AstLiteral* literal = (AstLiteral*)malloc(sizeof(AstLiteral));
+    AstLiteral* literal = (AstLiteral*)calloc(1, sizeof(AstLiteral));
     if (!literal) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -330,7 +330,7 @@ AstNode* create_literal_node_int(int value) {
 }
 
 AstNode* create_literal_node_float(float value) {
-    AstLiteral* literal = (AstLiteral*)malloc(sizeof(AstLiteral));
+    AstLiteral* literal = (AstLiteral*)calloc(1, sizeof(AstLiteral));
     if (!literal) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -342,7 +342,7 @@ AstNode* create_literal_node_float(float value) {
 }
 
 AstNode* create_literal_node_string(char* value) {
-    AstLiteral* literal = (AstLiteral*)malloc(sizeof(AstLiteral));
+    AstLiteral* literal = (AstLiteral*)calloc(1, sizeof(AstLiteral));
     if (!literal) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -354,7 +354,7 @@ AstNode* create_literal_node_string(char* value) {
 }
 
 AstNode* create_literal_node_char(char value) {
-    AstLiteral* literal = (AstLiteral*)malloc(sizeof(AstLiteral));
+    AstLiteral* literal = (AstLiteral*)calloc(1, sizeof(AstLiteral));
     if (!literal) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -366,7 +366,7 @@ AstNode* create_literal_node_char(char value) {
 }
 
 AstNode* create_literal_node_bool(int value) {
-    AstLiteral* literal = (AstLiteral*)malloc(sizeof(AstLiteral));
+    AstLiteral* literal = (AstLiteral*)calloc(1, sizeof(AstLiteral));
     if (!literal) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -378,7 +378,7 @@ AstNode* create_literal_node_bool(int value) {
 }
 
 AstNode* create_array_access_node(AstNode* array, AstNode* index) {
-    AstArrayAccess* access = (AstArrayAccess*)malloc(sizeof(AstArrayAccess));
+    AstArrayAccess* access = (AstArrayAccess*)calloc(1, sizeof(AstArrayAccess));
     if (!access) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -390,7 +390,7 @@ AstNode* create_array_access_node(AstNode* array, AstNode* index) {
 }
 
 AstNode* create_struct_access_node(AstNode* structure, char* field_name) {
-    AstStructAccess* access = (AstStructAccess*)malloc(sizeof(AstStructAccess));
+    AstStructAccess* access = (AstStructAccess*)calloc(1, sizeof(AstStructAccess));
     if (!access) {
         fprintf(stderr, "Erreur d'allocation mémoire\n");
         exit(EXIT_FAILURE);
@@ -401,6 +401,17 @@ AstNode* create_struct_access_node(AstNode* structure, char* field_name) {
     return (AstNode*)access;
 }
 
+AstNode* create_type_node(TokenType type_token) {
+    AstType* type = (AstType*)calloc(1, sizeof(AstType));
+    if (!type) {
+        fprintf(stderr, "Erreur d'allocation mémoire\n");
+        exit(EXIT_FAILURE);
+    }
+    type->base.type = AST_TYPE;
+    type->type_token = type_token;
+    return (AstNode*)type;
+}
+
 void free_ast_node(AstNode* node) {
     if (!node) return;
 
@@ -434,6 +445,7 @@ void free_ast_node(AstNode* node) {
         }
         case AST_VARIABLE_DECL: {
             AstVariableDeclaration* var = (AstVariableDeclaration*)node;
+            free_ast_node(var->type);
             free_ast_node(var->initializer);
             free(var->name);
             break;
@@ -463,6 +475,7 @@ void free_ast_node(AstNode* node) {
         }
         case AST_PARAMETER: {
             AstParameter* param = (AstParameter*)node;
+            free_ast_node(param->type);
             free(param->name);
             break;
         }
@@ -521,6 +534,8 @@ void free_ast_node(AstNode* node) {
             free(access->field_name);
             break;
         }
+        case AST_TYPE:
+            break;
     }
 
     free(node);
@@ -27,7 +27,9 @@ typedef enum {
     AST_LITERAL,
 
     AST_ARRAY_ACCESS,
-    AST_STRUCT_ACCESS
+    AST_STRUCT_ACCESS,
+
+    AST_TYPE
 } AstNodeType;
 
 typedef struct AstNode {
@@ -153,6 +155,12 @@ typedef struct {
     char* field_name;
 } AstStructAccess;
 
+// Declared type of a variable or parameter (`entier`, `reel`, `booleen`, `chaine`).
+typedef struct {
+    AstNode base;
+    TokenType type_token;
+} AstType;
+
 AstNode* create_program_node();
 AstNode* create_function_decl_node(char* name, AstNode** params, int param_count, AstNode* return_type, AstNode* body);
 AstNode* create_block_node();
@@ -174,6 +182,7 @@ AstNode* create_literal_node_char(char value);
 AstNode* create_literal_node_bool(int value);
 AstNode* create_array_access_node(AstNode* array, AstNode* index);
 AstNode* create_struct_access_node(AstNode* structure, char* field_name);
+AstNode* create_type_node(TokenType type_token);
 
 void free_ast_node(AstNode* node);
 void print_ast(AstNode* node, int depth);
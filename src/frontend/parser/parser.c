@@ -25,6 +25,16 @@ void parser_advance (Parser* parser) {
     parser->current_token = get_the_next_token(parser->lexer);
 }
 
+// Records where a statement or declaration starts (its first token) on its
+// node, for the line numbers of the IR and of debug info.
+static AstNode* located(AstNode* node, int line, int column) {
+    if (node) {
+        node->line = line;
+        node->column = column;
+    }
+    return node;
+}
+
 int match (Parser* parser, TokenType type) {
     if (parser->current_token->type == type) {
         parser_advance(parser);
@@ -68,7 +78,8 @@ AstNode* parse_program (Parser* parser) {
     program->declaration_count = 0;
 
     while (parser->current_token->type != TOKEN_EOF) {
-        AstNode* declaration = parse_declaration(parser);
+        int line = parser->current_token->line, column = parser->current_token->column;
+        AstNode* declaration = located(parse_declaration(parser), line, column);
 
         if (declaration) {
             if (program->declaration_count >= capacity) {
@@ -364,6 +375,89 @@ AstNode* parse_while_statement(Parser* parser) {
     return create_while_stmt_node(condition, body);
 }
 
+// pour i <- debut haut|bas fin faire ... finfaire
+// Desugared into the init / condition / update triple of AstForStatement:
+//   init      i <- debut
+//   condition i <= fin   (haut)   or   i >= fin   (bas)
+//   update    i <- i + 1 (haut)   or   i <- i - 1 (bas)
+AstNode* parse_for_statement(Parser* parser) {
+    // No advance here — parse_statement already consumed TOKEN_POUR via match().
+    if (parser->current_token->type != TOKEN_IDENTIFIER) {
+        fprintf(stderr, "Nom de variable attendu après pour (ligne %d, colonne %d)\n",
+                parser->current_token->line, parser->current_token->column);
+        return NULL;
+    }
+
+    char* var_name = strdup(parser->current_token->value);
+    parser_advance(parser);
+
+    if (!expect(parser, TOKEN_ASSIGN, "<- attendu")) {
+        free(var_name);
+        return NULL;
+    }
+
+    AstNode* start = parse_expression(parser);
+    if (!start) {
+        free(var_name);
+        return NULL;
+    }
+
+    int direction;
+    if (match(parser, TOKEN_HAUT)) {
+        direction = 1;
+    } else if (match(parser, TOKEN_BAS)) {
+        direction = -1;
+    } else {
+        fprintf(stderr, "Syntax error in line %d, column %d: haut ou bas attendu\n",
+                parser->current_token->line, parser->current_token->column);
+        free_ast_node(start);
+        free(var_name);
+        return NULL;
+    }
+
+    AstNode* end = parse_expression(parser);
+    if (!end) {
+        free_ast_node(start);
+        free(var_name);
+        return NULL;
+    }
+
+    if (!expect(parser, TOKEN_FAIRE, "faire attendu")) {
+        free_ast_node(start);
+        free_ast_node(end);
+        free(var_name);
+        return NULL;
+    }
+
+    AstNode* body = parse_block(parser);
+    if (!body) {
+        free_ast_node(start);
+        free_ast_node(end);
+        free(var_name);
+        return NULL;
+    }
+
+    if (!expect(parser, TOKEN_FINFAIRE, "finfaire attendu")) {
+        free_ast_node(start);
+        free_ast_node(end);
+        free_ast_node(body);
+        free(var_name);
+        return NULL;
+    }
+
+    AstNode* init = create_assignment_node(create_variable_node(var_name), start);
+    AstNode* condition = create_binary_expr_node(create_variable_node(var_name),
+                                                 direction > 0 ? TOKEN_LESS_EQUAL : TOKEN_GREATER_EQUAL,
+                                                 end);
+    AstNode* step = create_binary_expr_node(create_variable_node(var_name),
+                                            direction > 0 ? TOKEN_PLUS : TOKEN_MINUS,
+                                            create_literal_node_int(1));
+    AstNode* update = create_assignment_node(create_variable_node(var_name), step);
+    free(var_name);
+
+    return create_for_stmt_node(init, condition, update, body, direction);
+}
+
 AstNode* parse_function_declaration(Parser* parser) {
     if (!match(parser, TOKEN_DEBFONC)) {
         return NULL;
@@ -396,11 +490,13 @@ AstNode* parse_function_declaration(Parser* parser) {
         else if (parser->current_token->type == TOKEN_R)   { p_mode = 2; parser_advance(parser); }
         else if (parser->current_token->type == TOKEN_DR)  { p_mode = 3; parser_advance(parser); }
 
-        // Type keyword (optional for now; just consume if present)
+        // Type keyword (optional: untyped parameters are inferred as entier)
+        AstNode* param_type = NULL;
         if (parser->current_token->type == TOKEN_ENTIER  ||
             parser->current_token->type == TOKEN_REEL    ||
             parser->current_token->type == TOKEN_CHAINE  ||
             parser->current_token->type == TOKEN_BOOLEEN) {
+            param_type = create_type_node(parser->current_token->type);
             parser_advance(parser);
         }
 
@@ -410,13 +506,14 @@ AstNode* parse_function_declaration(Parser* parser) {
             for (int i = 0; i < param_count; i++) free_ast_node(params[i]);
             free(params);
             free(func_name);
+            free_ast_node(param_type);
             return NULL;
         }
 
         char* param_name = strdup(parser->current_token->value);
         parser_advance(parser);
 
-        AstNode* param = create_parameter_node(param_name, NULL, NULL);
+        AstNode* param = create_parameter_node(param_name, param_type, NULL);
         ((AstParameter*)param)->param_type = p_mode;
         free(param_name);
 
@@ -483,7 +580,7 @@ AstNode* parse_variable_declaration(Parser* parser) {
         }
     }
 
-    return create_variable_decl_node(var_name, NULL, initializer);
+    return create_variable_decl_node(var_name, create_type_node(type_token), initializer);
 }
 
 AstNode* parse_statement(Parser* parser) {
@@ -494,6 +591,9 @@ AstNode* parse_statement(Parser* parser) {
     if (match(parser, TOKEN_TANTQUE)) {
         return parse_while_statement(parser);
     }
+    if (match(parser, TOKEN_POUR)) {
+        return parse_for_statement(parser);
+    }
     if (match(parser, TOKEN_RETOURNER)) {
         return parse_return_statement(parser);
     }
@@ -540,7 +640,8 @@ AstNode* parse_block(Parser* parser) {
            parser->current_token->type != TOKEN_FINFAIRE &&
            parser->current_token->type != TOKEN_FINFONC) {
 
-        AstNode* stmt = parse_statement(parser);
+        int line = parser->current_token->line, column = parser->current_token->column;
+        AstNode* stmt = located(parse_statement(parser), line, column);
         if (!stmt) break;
 
         if (block->statement_count >= capacity) {
@@ -6,23 +6,85 @@
 #include "frontend/parser/parser.h"
 #include "frontend/ast/ast.h"
 #include "middle/ir_generator.h"
+#include "middle/ir_types.h"
+#include "middle/ir_pass_manager.h"
+#include "middle/work_pool.h"
 #include "backend/llvm_emitter.h"
+#include "backend/bytecode.h"
+#include "backend/vm.h"
+#include "backend/jit.h"
+#include "backend/tier.h"
+#include "backend/profile.h"
 
 #define MAX_FILE_SIZE (1024 * 1024) // 1MB
 
 static char* readFile(const char* filename);
-static char* default_output_path(const char* source_path);
+static char* default_output_path(const char* source_path, EmitFileType file_type);
 static void print_usage(const char* prog);
 
+// Optimisation settings shared by every CLI shape. The -O level drives both
+// the IR pipeline and LLVM's.
+typedef struct {
+    int opt_level;
+    const char* passes;     // --passes=LIST, overrides the -O pipeline
+    int time_passes;
+    int verify_ir;
+    int jobs;               // -jN: threads for IR generation and LLVM emission
+    int optimize_size;      // -Os
+    const char* target;     // --target=TRIPLE
+    const char* cpu;        // --mcpu=NAME, -mcpu=, -march= ("native": the host's)
+    const char* features;   // --mattr=+a,-b
+    int debug_info;         // -g
+} IrOptions;
+
+static int parse_ir_option(const char* arg, IrOptions* opts);
+static EmitOptions emit_options(const IrOptions* opts);
+static int optimize_ir(IRProgram* ir, const IrOptions* opts);
+static IRProgram* generate_program(const char* input_path, const IrOptions* ir_opts, int debug_mode);
+static int build_programs(const char* const* paths, int count, const IrOptions* ir_opts, int debug_mode,
+                          IRProgram** programs);
+static IRProgram* build_ir(const char* input_path, const IrOptions* ir_opts, int debug_mode);
+static int serve(const IrOptions* ir_opts);
+static int parse_tier_option(const char* arg, TierOptions* opts);
+static int is_link_module(const char* arg);
+static int is_source_file(const char* arg);
+
 int main(int argc, char* argv[]) {
     // CLI shapes:
     //   cyplang FILE.cyp                        → debug mode (dump source/AST/IR/LLVM to stdout)
     //   cyplang compile FILE.cyp                → emit FILE.ll next to source
     //   cyplang compile FILE.cyp -o OUT.ll      → emit to OUT.ll
+    //   cyplang compile FILE.cyp -c             → native object FILE.o (--emit=obj)
+    //   cyplang compile FILE.cyp --emit=exe     → executable FILE, linked by the system linker
+    //   cyplang compile MAIN.cyp LIB.cyp ...    → one program: LIB's functions linked in
+    //   cyplang run FILE.cyp                    → interpret in process (bytecode VM)
+    //   cyplang run FILE.cyp --jit              → compile in process with ORC and call main
+    //   cyplang run FILE.cyp --tier             → interpret, JIT-compile hot functions
+    //   cyplang serve                           → JIT-run each source path read on stdin
+    // All shapes accept -O0 (default) / -O1 / -O2 / -O3 / -Os to run the IR
+    // optimiser and then LLVM's pipeline (target machine: --target, --mcpu,
+    // --mattr), --passes=a,b,c for an explicit IR pipeline, --time-passes for
+    // per-pass statistics on stderr and --verify-ir to check the IR after
+    // every pass. -jN lowers and emits functions on N threads (-j0: one per core),
+    // -g adds DWARF line tables for the .cyp source.
     int compile_mode = 0;
+    int run_mode = 0;
+    int serve_mode = 0;
+    int dump_bytecode = 0;  // run: print the bytecode before executing it
+    int use_jit = 0;        // run: LLJIT instead of the bytecode VM
+    int use_tier = 0;       // run: bytecode VM with tier-up to LLJIT
+    TierOptions tier_opts = { TIER_DEFAULT_CALLS, TIER_DEFAULT_LOOPS, 0, 0 };
+    IrOptions ir_opts = { 0, NULL, 0, 0, 1, 0, NULL, NULL, NULL, 0 };
     const char* input_path = NULL;
     const char* output_path = NULL;
     char* output_path_owned = NULL; // free on exit if we allocated a default
+    EmitFileType file_type = EMIT_FILE_LLVM_IR;
+    const char** link_modules = NULL;   // compile: .bc / .ll inputs, pointing into argv
+    int link_module_count = 0;
+    const char** source_paths = NULL;   // compile: every .cyp input, the program first
+    int source_count = 0;
+    const char* profile_generate = NULL;    // compile: instrument, profile written there
+    const char* profile_use = NULL;         // compile: optimise with this profile
 
     if (argc < 2) {
         print_usage(argv[0]);
@@ -39,35 +101,190 @@ int main(int argc, char* argv[]) {
             return EXIT_FAILURE;
         }
         input_path = argv[argi++];
+        source_paths = malloc(sizeof(*source_paths) * (size_t)argc);
+        source_paths[source_count++] = input_path;
         while (argi < argc) {
             if (strcmp(argv[argi], "-o") == 0) {
                 argi++;
                 if (argi >= argc) {
                     fprintf(stderr, "compile: -o requires an argument\n");
+                    free(link_modules);
+                    free(source_paths);
                     return EXIT_FAILURE;
                 }
                 output_path = argv[argi++];
+            } else if (strcmp(argv[argi], "-c") == 0 || strcmp(argv[argi], "--emit=obj") == 0) {
+                file_type = EMIT_FILE_OBJECT;
+                argi++;
+            } else if (strcmp(argv[argi], "--emit=exe") == 0) {
+                file_type = EMIT_FILE_EXECUTABLE;
+                argi++;
+            } else if (strcmp(argv[argi], "--emit=llvm") == 0) {
+                file_type = EMIT_FILE_LLVM_IR;
+                argi++;
+            } else if (strcmp(argv[argi], "--emit=bc") == 0) {
+                file_type = EMIT_FILE_BITCODE;
+                argi++;
+            } else if (strcmp(argv[argi], "--profile-generate") == 0) {
+                profile_generate = PROFILE_DEFAULT_PATH;
+                argi++;
+            } else if (strncmp(argv[argi], "--profile-generate=", 19) == 0) {
+                profile_generate = argv[argi++] + 19;
+            } else if (strncmp(argv[argi], "--profile-use=", 14) == 0) {
+                profile_use = argv[argi++] + 14;
+            } else if (parse_ir_option(argv[argi], &ir_opts)) {
+                argi++;
+            } else if (is_link_module(argv[argi])) {
+                if (!link_modules) link_modules = malloc(sizeof(*link_modules) * (size_t)argc);
+                link_modules[link_module_count++] = argv[argi++];
+            } else if (is_source_file(argv[argi])) {
+                source_paths[source_count++] = argv[argi++];
             } else {
                 fprintf(stderr, "compile: unknown argument '%s'\n", argv[argi]);
+                free(link_modules);
+                free(source_paths);
                 return EXIT_FAILURE;
             }
         }
         if (!output_path) {
-            output_path_owned = default_output_path(input_path);
+            output_path_owned = default_output_path(input_path, file_type);
             output_path = output_path_owned;
         }
+    } else if (strcmp(argv[argi], "run") == 0) {
+        run_mode = 1;
+        argi++;
+        if (argi >= argc) {
+            fprintf(stderr, "run: missing source file\n");
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        input_path = argv[argi++];
+        while (argi < argc) {
+            if (strcmp(argv[argi], "--dump-bytecode") == 0) {
+                dump_bytecode = 1;
+                argi++;
+            } else if (strcmp(argv[argi], "--jit") == 0) {
+                use_jit = 1;
+                argi++;
+            } else if (parse_tier_option(argv[argi], &tier_opts)) {
+                use_tier = 1;
+                argi++;
+            } else if (parse_ir_option(argv[argi], &ir_opts)) {
+                argi++;
+            } else {
+                fprintf(stderr, "run: unknown argument '%s'\n", argv[argi]);
+                return EXIT_FAILURE;
+            }
+        }
+    } else if (strcmp(argv[argi], "serve") == 0) {
+        serve_mode = 1;
+        argi++;
+        while (argi < argc) {
+            if (parse_ir_option(argv[argi], &ir_opts)) {
+                argi++;
+            } else {
+                fprintf(stderr, "serve: unknown argument '%s'\n", argv[argi]);
+                return EXIT_FAILURE;
+            }
+        }
     } else {
-        input_path = argv[argi];
+        input_path = argv[argi++];
+        while (argi < argc) {
+            if (parse_ir_option(argv[argi], &ir_opts)) {
+                argi++;
+            } else {
+                fprintf(stderr, "unknown argument '%s'\n", argv[argi]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (ir_opts.passes && ir_pass_check_list(ir_opts.passes) != 0) {
+        free(output_path_owned);
+        free(link_modules);
+        free(source_paths);
+        return EXIT_FAILURE;
+    }
+
+    // Only the debug shape dumps the pipeline stages.
+    int debug_mode = !compile_mode && !run_mode && !serve_mode;
+
+    if (serve_mode) {
+        return serve(&ir_opts) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // compile: the first source file is the program, the others add functions.
+    int program_count = source_count > 1 ? source_count : 1;
+    IRProgram** programs = malloc(sizeof(IRProgram*) * (size_t)program_count);
+    if (build_programs(source_count > 1 ? source_paths : &input_path, program_count, &ir_opts, debug_mode,
+                       programs) != 0) {
+        free(programs);
+        free(output_path_owned);
+        free(link_modules);
+        free(source_paths);
+        return EXIT_FAILURE;
+    }
+    IRProgram* ir = programs[0];
+
+    if (run_mode && use_jit) {
+        JitSession* session = jit_session_create();
+        EmitOptions emit_opts = emit_options(&ir_opts);
+        int exit_code = 1;
+        int run_rc = session ? jit_run(session, ir, &emit_opts, &exit_code) : 1;
+        jit_session_dispose(session);
+        ir_free_program(ir);
+        free(programs);
+        return run_rc == 0 && exit_code == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
+    if (run_mode) {
+        BcProgram* bytecode = bc_compile(ir);
+        int run_rc = 1;
+        if (bytecode) {
+            if (dump_bytecode) bc_print(bytecode, stdout);
+            run_rc = use_tier ? tier_run(ir, bytecode, &tier_opts) : vm_run(bytecode, NULL);
+            bc_free(bytecode);
+        }
+        ir_free_program(ir);
+        free(programs);
+        return run_rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // 4. LLVM emission
+    EmitOptions emit_opts = emit_options(&ir_opts);
+    emit_opts.file_type = file_type;
+    emit_opts.link_modules = link_modules;
+    emit_opts.link_module_count = link_module_count;
+    emit_opts.profile_generate = profile_generate;
+    emit_opts.sources = programs + 1;
+    emit_opts.source_count = program_count - 1;
+    Profile* profile = NULL;
+    int emit_rc = 1;
+    if (!profile_use || (profile = profile_load(profile_use)) != NULL) {
+        emit_opts.profile_use = profile;
+        emit_rc = emit_llvm(ir, "cyplang_module", compile_mode ? output_path : NULL, &emit_opts);
+    }
+
+    profile_free(profile);
+    for (int p = 0; p < program_count; p++) ir_free_program(programs[p]);
+    free(programs);
+    free(output_path_owned);
+    free(link_modules);
+    free(source_paths);
+
+    return emit_rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Source file -> untyped IR (steps 1-3 of the pipeline), dumping the source
+// and the AST to stdout in debug mode. Returns NULL after reporting an error.
+static IRProgram* generate_program(const char* input_path, const IrOptions* ir_opts, int debug_mode) {
     char* source = readFile(input_path);
     if (!source) {
         fprintf(stderr, "Error: Could not read file %s\n", input_path);
-        free(output_path_owned);
-        return EXIT_FAILURE;
+        return NULL;
     }
 
-    if (!compile_mode) {
+    if (debug_mode) {
         printf("=== Source (%s) ===\n%s\n", input_path, source);
     }
 
@@ -76,8 +293,7 @@ int main(int argc, char* argv[]) {
     if (!lexer) {
         fprintf(stderr, "Failed to initialize lexer\n");
         free(source);
-        free(output_path_owned);
-        return EXIT_FAILURE;
+        return NULL;
     }
 
     // 2. Parser → AST
@@ -86,8 +302,7 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Failed to initialize parser\n");
         free_lexer(lexer);
         free(source);
-        free(output_path_owned);
-        return EXIT_FAILURE;
+        return NULL;
     }
 
     AstNode* ast = parse(parser);
@@ -96,64 +311,289 @@ int main(int argc, char* argv[]) {
         free_parser(parser);
         free_lexer(lexer);
         free(source);
-        free(output_path_owned);
-        return EXIT_FAILURE;
+        return NULL;
     }
 
-    if (!compile_mode) {
+    if (debug_mode) {
         printf("\n=== AST ===\n");
         print_ast(ast, 0);
     }
 
-    // 3. IR generation
-    IRProgram* ir = generate_ir(ast);
+    // 3. IR generation (the IR owns copies of every name it uses)
+    IRProgram* ir = generate_ir_parallel(ast, ir_opts->jobs);
+    free_ast_node(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    free(source);
     if (!ir) {
         fprintf(stderr, "IR generation failed\n");
-        free_ast_node(ast);
-        free_parser(parser);
-        free_lexer(lexer);
-        free(source);
-        free(output_path_owned);
-        return EXIT_FAILURE;
+        return NULL;
+    }
+    ir->source_path = strdup(input_path);
+    return ir;
+}
+
+// Source files -> typed, optimised IR, one program per file, each stage
+// dumped to stdout in debug mode. The functions of any file may call each
+// other; only the first file may have top-level statements (`main`).
+// Returns 0, or non-zero after reporting an error (nothing left to free).
+static int build_programs(const char* const* paths, int count, const IrOptions* ir_opts, int debug_mode,
+                          IRProgram** programs) {
+    int rc = 0;
+    for (int p = 0; p < count; p++) programs[p] = NULL;
+    for (int p = 0; rc == 0 && p < count; p++) {
+        programs[p] = generate_program(paths[p], ir_opts, debug_mode);
+        if (!programs[p]) {
+            rc = 1;
+        } else if (p > 0 && programs[p]->global_instructions) {
+            fprintf(stderr, "%s: top-level statements are only allowed in the first source file\n", paths[p]);
+            rc = 1;
+        }
     }
 
-    if (!compile_mode) {
+    // Types are needed by every later stage, whatever the optimisation level.
+    if (rc == 0) rc = ir_infer_types_linked(programs, count) > 0;
+    for (int p = 0; rc == 0 && p < count; p++) rc = optimize_ir(programs[p], ir_opts) != 0;
+
+    for (int p = 0; rc == 0 && debug_mode && p < count; p++) {
         printf("\n");
-        ir_print_program(ir);
+        ir_print_program(programs[p]);
         printf("\n");
     }
+    if (rc != 0) {
+        for (int p = 0; p < count; p++) {
+            if (programs[p]) ir_free_program(programs[p]);
+        }
+    }
+    return rc;
+}
 
-    // 4. LLVM emission
-    int emit_rc = emit_llvm(ir, "cyplang_module", compile_mode ? output_path : NULL);
+// One source file -> typed, optimised IR. Returns NULL after reporting an error.
+static IRProgram* build_ir(const char* input_path, const IrOptions* ir_opts, int debug_mode) {
+    IRProgram* ir = NULL;
+    return build_programs(&input_path, 1, ir_opts, debug_mode, &ir) == 0 ? ir : NULL;
+}
 
-    ir_free_program(ir);
-    free_ast_node(ast);
-    free_parser(parser);
-    free_lexer(lexer);
-    free(source);
-    free(output_path_owned);
+// `cyplang serve`: reads one source path per line on stdin and runs each
+// program through a single JIT session, so only the first program pays for
+// setting it up. A failing program is reported and the next line is read.
+// Returns 0 if every program compiled and exited with 0.
+static int serve(const IrOptions* ir_opts) {
+    JitSession* session = jit_session_create();
+    if (!session) return 1;
 
-    return emit_rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    EmitOptions emit_opts = emit_options(ir_opts);
+    int failures = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') continue;
+
+        IRProgram* ir = build_ir(line, ir_opts, 0);
+        int exit_code = 1;
+        if (!ir || jit_run(session, ir, &emit_opts, &exit_code) != 0 || exit_code != 0) {
+            fprintf(stderr, "serve: %s failed\n", line);
+            failures++;
+        }
+        if (ir) ir_free_program(ir);
+        fflush(stdout);
+    }
+
+    jit_session_dispose(session);
+    return failures == 0 ? 0 : 1;
 }
 
-// Given "path/to/foo.cyp", returns a malloc'd "path/to/foo.ll".
-// If no .cyp extension, just appends ".ll".
-static char* default_output_path(const char* source_path) {
+// Given "path/to/foo.cyp", returns a malloc'd "path/to/foo.ll" (".bc" for
+// bitcode, ".o" for an object, no extension for an executable). If no .cyp extension, just
+// appends the new one; an executable then gets ".out" rather than
+// overwriting its source.
+static char* default_output_path(const char* source_path, EmitFileType file_type) {
     size_t len = strlen(source_path);
     const char* dot = strrchr(source_path, '.');
-    size_t base_len = (dot && strcmp(dot, ".cyp") == 0) ? (size_t)(dot - source_path) : len;
-    char* out = malloc(base_len + 4); // ".ll" + '\0'
+    int has_cyp = dot && strcmp(dot, ".cyp") == 0;
+    size_t base_len = has_cyp ? (size_t)(dot - source_path) : len;
+    const char* ext = file_type == EMIT_FILE_BITCODE ? ".bc"
+                    : file_type == EMIT_FILE_OBJECT ? ".o"
+                    : file_type == EMIT_FILE_EXECUTABLE ? (has_cyp ? "" : ".out")
+                    : ".ll";
+    size_t ext_len = strlen(ext);
+    char* out = malloc(base_len + ext_len + 1);
     memcpy(out, source_path, base_len);
-    memcpy(out + base_len, ".ll", 4);
+    memcpy(out + base_len, ext, ext_len + 1);
     return out;
 }
 
+// A further source file of the compiled program: a .cyp path.
+static int is_source_file(const char* arg) {
+    const char* dot = strrchr(arg, '.');
+    return arg[0] != '-' && dot && strcmp(dot, ".cyp") == 0;
+}
+
+// A precompiled module to link into the compiled one: a .bc or .ll path.
+static int is_link_module(const char* arg) {
+    const char* dot = strrchr(arg, '.');
+    return arg[0] != '-' && dot && (strcmp(dot, ".bc") == 0 || strcmp(dot, ".ll") == 0);
+}
+
+// Recognises -O0..-O3, -Os, --passes=LIST, --time-passes, --verify-ir, -jN,
+// -g and the target machine options --target=, --mcpu= (or -mcpu=, -march=)
+// and --mattr=.
+// Returns 1 and updates `opts` if `arg` is one of them.
+static int parse_ir_option(const char* arg, IrOptions* opts) {
+    if (strncmp(arg, "-j", 2) == 0 && arg[2] >= '0' && arg[2] <= '9') {
+        char* end = NULL;
+        long jobs = strtol(arg + 2, &end, 10);
+        if (*end != '\0') return 0;
+        opts->jobs = jobs > 0 ? (int)jobs : work_pool_default_jobs();
+        return 1;
+    }
+    if (strncmp(arg, "-O", 2) == 0 && arg[2] >= '0' && arg[2] <= '3' && arg[3] == '\0') {
+        opts->opt_level = arg[2] - '0';
+        opts->optimize_size = 0;
+        return 1;
+    }
+    if (strcmp(arg, "-Os") == 0) {
+        opts->opt_level = 2;
+        opts->optimize_size = 1;
+        return 1;
+    }
+    if (strncmp(arg, "--target=", 9) == 0) {
+        opts->target = arg + 9;
+        return 1;
+    }
+    if (strncmp(arg, "--mcpu=", 7) == 0 || strncmp(arg, "-mcpu=", 6) == 0 || strncmp(arg, "-march=", 7) == 0) {
+        opts->cpu = strchr(arg, '=') + 1;
+        return 1;
+    }
+    if (strncmp(arg, "--mattr=", 8) == 0) {
+        opts->features = arg + 8;
+        return 1;
+    }
+    if (strncmp(arg, "--passes=", 9) == 0) {
+        opts->passes = arg + 9;
+        return 1;
+    }
+    if (strcmp(arg, "--time-passes") == 0) {
+        opts->time_passes = 1;
+        return 1;
+    }
+    if (strcmp(arg, "--verify-ir") == 0) {
+        opts->verify_ir = 1;
+        return 1;
+    }
+    if (strcmp(arg, "-g") == 0) {
+        opts->debug_info = 1;
+        return 1;
+    }
+    return 0;
+}
+
+// Recognises --tier, --tier-calls=N, --tier-loops=N, --tier-report and
+// --tier-sync, each of which turns tiering on. Returns 1 and updates `opts` if `arg` is one of them.
+static int parse_tier_option(const char* arg, TierOptions* opts) {
+    if (strcmp(arg, "--tier") == 0) return 1;
+    if (strcmp(arg, "--tier-report") == 0) {
+        opts->report = 1;
+        return 1;
+    }
+    if (strcmp(arg, "--tier-sync") == 0) {
+        opts->sync = 1;
+        return 1;
+    }
+    int* threshold = strncmp(arg, "--tier-calls=", 13) == 0 ? &opts->call_threshold
+                   : strncmp(arg, "--tier-loops=", 13) == 0 ? &opts->backedge_threshold
+                   : NULL;
+    if (!threshold) return 0;
+    char* end = NULL;
+    long value = strtol(arg + 13, &end, 10);
+    if (end == arg + 13 || *end != '\0') return 0;
+    *threshold = (int)value;
+    return 1;
+}
+
+// LLVM-side settings for the same options.
+static EmitOptions emit_options(const IrOptions* opts) {
+    // Fields not named here (output kind, linked modules, profiles, other
+    // sources) start out zero and are set by the caller that needs them.
+    EmitOptions emit = {
+        .jobs = opts->jobs,
+        .opt_level = opts->opt_level,
+        .optimize_size = opts->optimize_size,
+        .target_triple = opts->target,
+        .cpu = opts->cpu,
+        .features = opts->features,
+        .time_report = opts->time_passes,
+        .file_type = EMIT_FILE_LLVM_IR,
+        .debug_info = opts->debug_info,
+    };
+    return emit;
+}
+
+// IR-level optimisation pipeline, run between generate_ir() and emit_llvm().
+// -O3 and -Os share the -O2 IR pipeline; -Os only changes LLVM's.
+// Returns 0, or -1 for an unknown pass name or IR that fails verification.
+static int optimize_ir(IRProgram* ir, const IrOptions* opts) {
+    IrPassManager pm;
+    ir_pass_manager_init(&pm);
+    pm.verify = opts->verify_ir;
+
+    int rc = 0;
+    if (opts->passes) {
+        rc = ir_pass_manager_add_list(&pm, opts->passes);
+    } else {
+        ir_pass_manager_add_level(&pm, opts->opt_level);
+    }
+    if (rc == 0) rc = ir_pass_manager_run(&pm, ir);
+    if (rc == 0 && opts->time_passes) ir_pass_manager_report(&pm, stderr);
+
+    ir_pass_manager_free(&pm);
+    return rc;
+}
+
 static void print_usage(const char* prog) {
     fprintf(stderr,
         "Usage:\n"
-        "  %s FILE.cyp                          dump source/AST/IR/LLVM to stdout\n"
-        "  %s compile FILE.cyp [-o OUT.ll]      emit LLVM IR to a file\n",
-        prog, prog);
+        "  %s FILE.cyp [OPTIONS]                        dump source/AST/IR/LLVM to stdout\n"
+        "  %s compile FILE.cyp [-o OUT.ll] [OPTIONS]    emit LLVM IR to a file\n"
+        "  %s compile FILE.cyp --emit=bc [-o OUT.bc]    emit LLVM bitcode (-o -: stdout)\n"
+        "  %s compile FILE.cyp -c [-o OUT.o] [OPTIONS]  emit a native object file\n"
+        "  %s compile FILE.cyp --emit=exe [-o OUT]      emit an executable (links with $CC, default cc)\n"
+        "  %s run FILE.cyp [--dump-bytecode] [OPTIONS]  interpret in process\n"
+        "  %s run FILE.cyp --jit [OPTIONS]              JIT-compile in process and run\n"
+        "  %s run FILE.cyp --tier [TIER] [OPTIONS]      interpret, JIT-compile hot functions\n"
+        "  %s serve [OPTIONS]                           JIT-run each source path read on stdin\n"
+        "  compile also takes LIB.bc / LIB.ll modules, linked in before the LLVM pipeline,\n"
+        "  and further LIB.cyp files, whose functions the program may call; with -O1 and\n"
+        "  up, an executable or a multi-file program is optimised as a whole (LTO)\n"
+        "\n"
+        "Profile-guided optimisation (compile):\n"
+        "  --profile-generate[=FILE]  count branches and calls; the program writes them\n"
+        "                      to FILE (default " PROFILE_DEFAULT_PATH ") when it exits\n"
+        "  --profile-use=FILE  weigh branches and functions with a profile from a build\n"
+        "                      with the same IR options\n"
+        "\n"
+        "Options:\n"
+        "  -O0|-O1|-O2|-O3|-Os optimisation level, IR then LLVM pipeline (default -O0)\n"
+        "  --passes=a,b,...    run exactly these IR passes, in order (overrides -O)\n"
+        "  --time-passes       print per-pass time and instruction counts, and LLVM\n"
+        "                      emission/optimisation times, on stderr\n"
+        "  --verify-ir         check the IR before and after every pass\n"
+        "  -jN                 lower and emit functions on N threads (-j0: all cores)\n"
+        "  -g                  DWARF debug info: functions and .cyp line numbers\n"
+        "  --target=TRIPLE     target machine for the LLVM pipeline (default: host)\n"
+        "  --mcpu=NAME         ... its CPU (default generic, native: the host's CPU and\n"
+        "                      features); also -mcpu=NAME and -march=NAME\n"
+        "  --mattr=+a,-b       ... and its features\n"
+        "\n"
+        "Tiering (run --tier):\n"
+        "  --tier-calls=N      compile a function after N calls (default %d, 0: never)\n"
+        "  --tier-loops=N      ... or after N loop back-edges in it (default %d, 0: never)\n"
+        "  --tier-report       list the functions that tiered up, and when, on stderr\n"
+        "  --tier-sync         compile on the interpreter thread instead of in the background\n"
+        "\n"
+        "IR passes:\n",
+        prog, prog, prog, prog, prog, prog, prog, prog, prog, TIER_DEFAULT_CALLS, TIER_DEFAULT_LOOPS);
+    ir_pass_list(stderr);
 }
 
 static char* readFile(const char* filename) {
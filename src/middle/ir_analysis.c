@@ -0,0 +1,593 @@
+#include "ir_analysis.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---------- name map ----------
+
+unsigned int ir_name_hash(const char* s) {
+    // FNV-1a
+    unsigned int h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void ir_name_map_init(IrNameMap* map, int expected) {
+    int capacity = 16;
+    while (capacity < expected * 2) capacity *= 2;
+    map->keys = calloc((size_t)capacity, sizeof(const char*));
+    map->values = calloc((size_t)capacity, sizeof(int));
+    map->capacity = capacity;
+    map->count = 0;
+}
+
+void ir_name_map_free(IrNameMap* map) {
+    free(map->keys);
+    free(map->values);
+    map->keys = NULL;
+    map->values = NULL;
+    map->capacity = 0;
+    map->count = 0;
+}
+
+static int find_slot(const IrNameMap* map, const char* key) {
+    unsigned int mask = (unsigned int)map->capacity - 1;
+    unsigned int i = ir_name_hash(key) & mask;
+    while (map->keys[i] && strcmp(map->keys[i], key) != 0) {
+        i = (i + 1) & mask;
+    }
+    return (int)i;
+}
+
+static void grow(IrNameMap* map) {
+    IrNameMap bigger;
+    ir_name_map_init(&bigger, map->capacity);
+    for (int i = 0; i < map->capacity; i++) {
+        if (!map->keys[i]) continue;
+        int j = find_slot(&bigger, map->keys[i]);
+        bigger.keys[j] = map->keys[i];
+        bigger.values[j] = map->values[i];
+        bigger.count++;
+    }
+    ir_name_map_free(map);
+    *map = bigger;
+}
+
+int ir_name_map_get(const IrNameMap* map, const char* key, int fallback) {
+    if (!key || map->capacity == 0) return fallback;
+    int i = find_slot(map, key);
+    return map->keys[i] ? map->values[i] : fallback;
+}
+
+int* ir_name_map_slot(IrNameMap* map, const char* key) {
+    if ((map->count + 1) * 2 > map->capacity) grow(map);
+    int i = find_slot(map, key);
+    if (!map->keys[i]) {
+        map->keys[i] = key;
+        map->values[i] = 0;
+        map->count++;
+    }
+    return &map->values[i];
+}
+
+void ir_name_map_set(IrNameMap* map, const char* key, int value) {
+    *ir_name_map_slot(map, key) = value;
+}
+
+// ---------- operand / instruction helpers ----------
+
+int ir_int_literal(const char* s, long* out) {
+    if (!s || !*s) return 0;
+    const char* p = s;
+    if (*p == '-') p++;
+    if (!*p) return 0;
+    for (; *p; p++) {
+        if (!isdigit((unsigned char)*p)) return 0;
+    }
+    if (out) *out = strtol(s, NULL, 10);
+    return 1;
+}
+
+int ir_is_literal(const char* s) {
+    if (!s || !*s) return 0;
+    if (s[0] == '"' || s[0] == '\'') return 1;
+    if (strcmp(s, "true") == 0 || strcmp(s, "false") == 0) return 1;
+    const char* p = s;
+    if (*p == '-') p++;
+    if (!isdigit((unsigned char)*p)) return 0;
+    for (; *p; p++) {
+        if (!isdigit((unsigned char)*p) && *p != '.') return 0;
+    }
+    return 1;
+}
+
+const char* ir_inst_def(const IrInstruction* inst) {
+    switch (inst->op) {
+        case IR_ASSIGN:
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_MOD:
+        case IR_NEG:
+        case IR_NOT:
+        case IR_EQ:
+        case IR_NEQ:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_AND:
+        case IR_OR:
+        case IR_CALL:
+        case IR_ARRAY_ACCESS:
+        case IR_ITOF:
+        case IR_FTOI:
+            return inst->result;
+        default:
+            return NULL;
+    }
+}
+
+static void push_use(const char* name, const char* out[3], int* n) {
+    if (name && !ir_is_literal(name)) out[(*n)++] = name;
+}
+
+int ir_inst_uses(const IrInstruction* inst, const char* out[3]) {
+    int n = 0;
+    switch (inst->op) {
+        case IR_ASSIGN:
+        case IR_NEG:
+        case IR_NOT:
+        case IR_IF_GOTO:
+        case IR_RETURN:
+        case IR_PARAM:
+        case IR_ITOF:
+        case IR_FTOI:
+            push_use(inst->arg1, out, &n);
+            break;
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_MOD:
+        case IR_EQ:
+        case IR_NEQ:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_AND:
+        case IR_OR:
+        case IR_ARRAY_ACCESS:
+            push_use(inst->arg1, out, &n);
+            push_use(inst->arg2, out, &n);
+            break;
+        case IR_ARRAY_ASSIGN:
+            push_use(inst->result, out, &n);
+            push_use(inst->arg1, out, &n);
+            push_use(inst->arg2, out, &n);
+            break;
+        default:
+            break;
+    }
+    return n;
+}
+
+int ir_op_is_pure(IrOpType op) {
+    switch (op) {
+        case IR_ASSIGN:
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_NEG:
+        case IR_NOT:
+        case IR_EQ:
+        case IR_NEQ:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_AND:
+        case IR_OR:
+        case IR_ITOF:
+        case IR_FTOI:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int ir_count_instructions(const IrInstruction* list) {
+    int n = 0;
+    for (const IrInstruction* inst = list; inst; inst = inst->next) n++;
+    return n;
+}
+
+int ir_call_params(IrInstruction* const* insts, int call, int* out, int max) {
+    const IrInstruction* inst = insts[call];
+    if (inst->op != IR_CALL || !inst->arg2) return -1;
+    int n = atoi(inst->arg2);
+    if (n > max) return -1;
+
+    // Walk back, letting nested calls consume their own params first.
+    int need = n, skip = 0;
+    for (int i = call - 1; i >= 0 && need > 0; i--) {
+        const IrInstruction* prev = insts[i];
+        if (prev->op == IR_FUNC_BEGIN) break;
+        if (prev->op == IR_CALL) {
+            skip += prev->arg2 ? atoi(prev->arg2) : 0;
+        } else if (prev->op == IR_PARAM) {
+            if (skip > 0) {
+                skip--;
+            } else {
+                out[--need] = i;
+            }
+        }
+    }
+    return need == 0 ? n : -1;
+}
+
+void ir_count_defs(const IrInstruction* list, int formal_count, IrNameMap* defs) {
+    int formals_left = 0;
+    for (const IrInstruction* inst = list; inst; inst = inst->next) {
+        if (inst->op == IR_FUNC_BEGIN) {
+            formals_left = formal_count;
+            continue;
+        }
+        if (inst->op == IR_PARAM && formals_left > 0) {
+            (*ir_name_map_slot(defs, inst->arg1))++;
+            formals_left--;
+            continue;
+        }
+        formals_left = 0;
+        const char* def = ir_inst_def(inst);
+        if (def) (*ir_name_map_slot(defs, def))++;
+    }
+}
+
+// ---------- control-flow graph ----------
+
+static int ends_block(IrOpType op) {
+    return op == IR_GOTO || op == IR_IF_GOTO || op == IR_RETURN || op == IR_FUNC_END;
+}
+
+// Reverse postorder from the entry block (iterative DFS).
+static void compute_rpo(IrCfg* cfg, int* order, int* order_count) {
+    int n = cfg->block_count;
+    int* stack = malloc(sizeof(int) * (size_t)n);
+    int* next_succ = calloc((size_t)n, sizeof(int));
+    unsigned char* seen = calloc((size_t)n, 1);
+    int* post = malloc(sizeof(int) * (size_t)n);
+    int post_count = 0;
+    int sp = 0;
+
+    stack[sp++] = 0;
+    seen[0] = 1;
+    while (sp > 0) {
+        int b = stack[sp - 1];
+        if (next_succ[b] < cfg->blocks[b].succ_count) {
+            int s = cfg->blocks[b].succs[next_succ[b]++];
+            if (!seen[s]) {
+                seen[s] = 1;
+                stack[sp++] = s;
+            }
+        } else {
+            post[post_count++] = b;
+            sp--;
+        }
+    }
+
+    for (int i = 0; i < post_count; i++) order[i] = post[post_count - 1 - i];
+    *order_count = post_count;
+
+    free(stack);
+    free(next_succ);
+    free(seen);
+    free(post);
+}
+
+// Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm".
+static void compute_dominators(IrCfg* cfg) {
+    int n = cfg->block_count;
+    int* order = malloc(sizeof(int) * (size_t)n);
+    int order_count = 0;
+    compute_rpo(cfg, order, &order_count);
+
+    for (int i = 0; i < n; i++) {
+        cfg->blocks[i].rpo = -1;
+        cfg->blocks[i].idom = -1;
+    }
+    for (int i = 0; i < order_count; i++) cfg->blocks[order[i]].rpo = i;
+
+    cfg->blocks[0].idom = 0;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < order_count; i++) {
+            IrBlock* b = &cfg->blocks[order[i]];
+            int new_idom = -1;
+            for (int p = 0; p < b->pred_count; p++) {
+                int pred = b->preds[p];
+                if (cfg->blocks[pred].idom == -1) continue; // not processed yet / unreachable
+                if (new_idom == -1) {
+                    new_idom = pred;
+                    continue;
+                }
+                int x = pred, y = new_idom;
+                while (x != y) {
+                    while (cfg->blocks[x].rpo > cfg->blocks[y].rpo) x = cfg->blocks[x].idom;
+                    while (cfg->blocks[y].rpo > cfg->blocks[x].rpo) y = cfg->blocks[y].idom;
+                }
+                new_idom = x;
+            }
+            if (new_idom != -1 && b->idom != new_idom) {
+                b->idom = new_idom;
+                changed = 1;
+            }
+        }
+    }
+    cfg->blocks[0].idom = -1;
+    free(order);
+}
+
+IrCfg* ir_cfg_build(IrInstruction* list, int formal_count) {
+    IrCfg* cfg = calloc(1, sizeof(IrCfg));
+    if (!cfg) {
+        fprintf(stderr, "Memory allocation failed for CFG\n");
+        return NULL;
+    }
+
+    int n = ir_count_instructions(list);
+    cfg->inst_count = n;
+    cfg->insts = malloc(sizeof(IrInstruction*) * (size_t)(n > 0 ? n : 1));
+    cfg->block_of = malloc(sizeof(int) * (size_t)(n > 0 ? n : 1));
+    int i = 0;
+    for (IrInstruction* inst = list; inst; inst = inst->next) cfg->insts[i++] = inst;
+    cfg->formal_end = (n > 0 && cfg->insts[0]->op == IR_FUNC_BEGIN) ? 1 + formal_count : 0;
+
+    // Leaders: first instruction, every label, and whatever follows a terminator.
+    int block_count = 0;
+    for (i = 0; i < n; i++) {
+        if (i == 0 || cfg->insts[i]->op == IR_LABEL || ends_block(cfg->insts[i - 1]->op)) {
+            block_count++;
+        }
+        cfg->block_of[i] = block_count - 1;
+    }
+    cfg->block_count = block_count;
+    cfg->blocks = calloc((size_t)(block_count > 0 ? block_count : 1), sizeof(IrBlock));
+    for (i = 0; i < n; i++) {
+        IrBlock* b = &cfg->blocks[cfg->block_of[i]];
+        if (i == 0 || cfg->block_of[i - 1] != cfg->block_of[i]) b->start = i;
+        b->end = i;
+    }
+
+    ir_name_map_init(&cfg->labels, block_count);
+    for (int b = 0; b < block_count; b++) {
+        IrInstruction* first = cfg->insts[cfg->blocks[b].start];
+        if (first->op == IR_LABEL && first->label) {
+            ir_name_map_set(&cfg->labels, first->label, b);
+        }
+    }
+
+    // Successors.
+    for (int b = 0; b < block_count; b++) {
+        IrBlock* blk = &cfg->blocks[b];
+        IrInstruction* last = cfg->insts[blk->end];
+        int fall = (b + 1 < block_count) ? b + 1 : -1;
+        int target = -1;
+        switch (last->op) {
+            case IR_GOTO:
+                target = ir_name_map_get(&cfg->labels, last->label, -1);
+                if (target >= 0) blk->succs[blk->succ_count++] = target;
+                break;
+            case IR_IF_GOTO:
+                target = ir_name_map_get(&cfg->labels, last->label, -1);
+                if (target >= 0) blk->succs[blk->succ_count++] = target;
+                if (fall >= 0 && fall != target) blk->succs[blk->succ_count++] = fall;
+                break;
+            case IR_RETURN:
+            case IR_FUNC_END:
+                break;
+            default:
+                if (fall >= 0) blk->succs[blk->succ_count++] = fall;
+                break;
+        }
+    }
+
+    // Predecessors.
+    for (int b = 0; b < block_count; b++) {
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+            cfg->blocks[cfg->blocks[b].succs[s]].pred_count++;
+        }
+    }
+    for (int b = 0; b < block_count; b++) {
+        cfg->blocks[b].preds = malloc(sizeof(int) * (size_t)(cfg->blocks[b].pred_count + 1));
+        cfg->blocks[b].pred_count = 0;
+    }
+    for (int b = 0; b < block_count; b++) {
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+            IrBlock* succ = &cfg->blocks[cfg->blocks[b].succs[s]];
+            succ->preds[succ->pred_count++] = b;
+        }
+    }
+
+    if (block_count > 0) compute_dominators(cfg);
+    return cfg;
+}
+
+int ir_cfg_dominates(const IrCfg* cfg, int a, int b) {
+    if (cfg->blocks[b].rpo < 0) return 0;
+    for (int x = b; x != -1; x = cfg->blocks[x].idom) {
+        if (x == a) return 1;
+    }
+    return 0;
+}
+
+int ir_cfg_block_of_label(const IrCfg* cfg, const char* label) {
+    return ir_name_map_get(&cfg->labels, label, -1);
+}
+
+static int compare_loops(const void* a, const void* b) {
+    const IrLoop* la = a;
+    const IrLoop* lb = b;
+    if (la->size != lb->size) return la->size - lb->size;
+    return la->header - lb->header;
+}
+
+void ir_cfg_find_loops(IrCfg* cfg) {
+    int n = cfg->block_count;
+    int capacity = 4;
+    cfg->loops = malloc(sizeof(IrLoop) * (size_t)capacity);
+    cfg->loop_count = 0;
+    int* work = malloc(sizeof(int) * (size_t)(n > 0 ? n : 1));
+
+    for (int b = 0; b < n; b++) {
+        if (cfg->blocks[b].rpo < 0) continue;
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+            int h = cfg->blocks[b].succs[s];
+            if (!ir_cfg_dominates(cfg, h, b)) continue;
+
+            IrLoop* loop = NULL;
+            for (int l = 0; l < cfg->loop_count; l++) {
+                if (cfg->loops[l].header == h) loop = &cfg->loops[l];
+            }
+            if (!loop) {
+                if (cfg->loop_count >= capacity) {
+                    capacity *= 2;
+                    cfg->loops = realloc(cfg->loops, sizeof(IrLoop) * (size_t)capacity);
+                }
+                loop = &cfg->loops[cfg->loop_count++];
+                loop->header = h;
+                loop->member = calloc((size_t)n, 1);
+                loop->member[h] = 1;
+                loop->size = 1;
+                loop->depth = 0;
+            }
+
+            // Walk backwards from the latch until the header is reached.
+            int top = 0;
+            if (!loop->member[b]) {
+                loop->member[b] = 1;
+                loop->size++;
+                work[top++] = b;
+            }
+            while (top > 0) {
+                int x = work[--top];
+                for (int p = 0; p < cfg->blocks[x].pred_count; p++) {
+                    int pred = cfg->blocks[x].preds[p];
+                    if (cfg->blocks[pred].rpo < 0 || loop->member[pred]) continue;
+                    loop->member[pred] = 1;
+                    loop->size++;
+                    work[top++] = pred;
+                }
+            }
+        }
+    }
+    free(work);
+
+    for (int l = 0; l < cfg->loop_count; l++) {
+        for (int o = 0; o < cfg->loop_count; o++) {
+            if (cfg->loops[o].member[cfg->loops[l].header]) cfg->loops[l].depth++;
+        }
+    }
+    qsort(cfg->loops, (size_t)cfg->loop_count, sizeof(IrLoop), compare_loops);
+}
+
+void ir_cfg_free(IrCfg* cfg) {
+    if (!cfg) return;
+    for (int b = 0; b < cfg->block_count; b++) free(cfg->blocks[b].preds);
+    for (int l = 0; l < cfg->loop_count; l++) free(cfg->loops[l].member);
+    free(cfg->loops);
+    free(cfg->blocks);
+    free(cfg->block_of);
+    free(cfg->insts);
+    ir_name_map_free(&cfg->labels);
+    free(cfg);
+}
+
+void ir_def_info_build(IrDefInfo* info, const IrCfg* cfg) {
+    ir_name_map_init(&info->defs, cfg->inst_count);
+    ir_name_map_init(&info->def_site, cfg->inst_count);
+    for (int i = 0; i < cfg->inst_count; i++) {
+        IrInstruction* inst = cfg->insts[i];
+        const char* def = (i < cfg->formal_end && inst->op == IR_PARAM) ? inst->arg1 : ir_inst_def(inst);
+        if (!def) continue;
+        (*ir_name_map_slot(&info->defs, def))++;
+        ir_name_map_set(&info->def_site, def, i);
+    }
+}
+
+void ir_def_info_free(IrDefInfo* info) {
+    ir_name_map_free(&info->defs);
+    ir_name_map_free(&info->def_site);
+}
+
+int ir_resolve_int_constant(const IrCfg* cfg, const IrDefInfo* info, const char* name, long* out) {
+    for (int hops = 0; name && hops < 8; hops++) {
+        if (ir_int_literal(name, out)) return 1;
+        if (ir_name_map_get(&info->defs, name, 0) != 1) return 0;
+        int site = ir_name_map_get(&info->def_site, name, 0);
+        if (site < cfg->formal_end) return 0;
+        IrInstruction* def = cfg->insts[site];
+        if (def->op != IR_ASSIGN) return 0;
+        name = def->arg1;
+    }
+    return 0;
+}
+
+int ir_loop_preheader(IRProgram* program, IrCfg* cfg, const IrLoop* loop, IrInstruction** label_out) {
+    IrBlock* header = &cfg->blocks[loop->header];
+    IrInstruction* header_label = cfg->insts[header->start];
+    *label_out = NULL;
+    if (header_label->op != IR_LABEL) return -1;
+
+    // A dedicated preheader is a single outside predecessor whose only
+    // successor is the header: preheader code can go at its end.
+    int outside = 0, outside_pred = -1;
+    for (int p = 0; p < header->pred_count; p++) {
+        if (!loop->member[header->preds[p]]) {
+            outside++;
+            outside_pred = header->preds[p];
+        }
+    }
+    if (outside == 1 && cfg->blocks[outside_pred].succ_count == 1) {
+        IrBlock* pred = &cfg->blocks[outside_pred];
+        IrOpType last_op = cfg->insts[pred->end]->op;
+        if (last_op == IR_GOTO) return pred->end;
+        if (last_op != IR_IF_GOTO && outside_pred == loop->header - 1) return header->start;
+    }
+
+    // Otherwise create one right before the header. Bail out if a loop block
+    // would fall through into it from above.
+    int prev = loop->header - 1;
+    if (prev >= 0 && loop->member[prev]) {
+        IrOpType last_op = cfg->insts[cfg->blocks[prev].end]->op;
+        if (last_op != IR_GOTO && last_op != IR_RETURN && last_op != IR_FUNC_END) return -1;
+    }
+
+    IrInstruction* label = create_instruction(IR_LABEL);
+    label->label = new_label(program);
+    for (int p = 0; p < header->pred_count; p++) {
+        if (loop->member[header->preds[p]]) continue;
+        IrInstruction* last = cfg->insts[cfg->blocks[header->preds[p]].end];
+        if ((last->op == IR_GOTO || last->op == IR_IF_GOTO) &&
+            last->label && strcmp(last->label, header_label->label) == 0) {
+            free(last->label);
+            last->label = strdup(label->label);
+        }
+    }
+    *label_out = label;
+    return header->start;
+}
+
+void ir_relink(IrInstruction** head, IrInstruction** order, int count) {
+    for (int i = 0; i + 1 < count; i++) order[i]->next = order[i + 1];
+    if (count > 0) order[count - 1]->next = NULL;
+    *head = count > 0 ? order[0] : NULL;
+}
@@ -0,0 +1,124 @@
+#ifndef IR_ANALYSIS_H
+#define IR_ANALYSIS_H
+
+#include "ir_generator.h"
+
+// Shared analyses for the IR optimisation passes: name maps, operand/def
+// helpers, control-flow graph, dominators and natural loops.
+//
+// A "body" is an instruction list: either an IrFunction's instructions (which
+// start with IR_FUNC_BEGIN followed by `param_count` formal IR_PARAMs) or the
+// program's global instructions (no formals).
+
+// ---------- name map: IR name ("t0", "x", "L3", ...) -> int ----------
+
+// Open addressing, linear probing. Keys are borrowed, not copied: they must
+// outlive the map (in practice they point into IrInstruction strings).
+typedef struct {
+    const char** keys;
+    int* values;
+    int capacity;
+    int count;
+} IrNameMap;
+
+void ir_name_map_init(IrNameMap* map, int expected);
+void ir_name_map_free(IrNameMap* map);
+int ir_name_map_get(const IrNameMap* map, const char* key, int fallback);
+void ir_name_map_set(IrNameMap* map, const char* key, int value);
+// Returns the value slot for `key`, inserting it with 0 if absent.
+int* ir_name_map_slot(IrNameMap* map, const char* key);
+// The maps' hash of a name (FNV-1a), for tables keyed the same way.
+unsigned int ir_name_hash(const char* name);
+
+// ---------- operand / instruction helpers ----------
+
+// True for operands that are constants rather than names: numbers, quoted
+// strings and characters, `true` / `false`.
+int ir_is_literal(const char* operand);
+// If `operand` is an integer literal, stores it in *out and returns 1.
+int ir_int_literal(const char* operand, long* out);
+// Name written by `inst`, or NULL. IR_ARRAY_ASSIGN mutates an array and is
+// not a scalar definition.
+const char* ir_inst_def(const IrInstruction* inst);
+// Collects the operands read by `inst` into `out` (at most 3). Formal
+// parameter declarations must be filtered out by the caller.
+int ir_inst_uses(const IrInstruction* inst, const char* out[3]);
+// Side-effect-free, non-trapping value computation (IR_DIV / IR_MOD excluded).
+int ir_op_is_pure(IrOpType op);
+// Number of instructions in a body (used for statistics and cost models).
+int ir_count_instructions(const IrInstruction* list);
+
+// Collects the indices of the IR_PARAMs consumed by the IR_CALL at insts[call],
+// in argument order. Returns the argument count, or -1 if the call carries no
+// count, has more than `max` arguments, or its params cannot be found.
+int ir_call_params(IrInstruction* const* insts, int call, int* out, int max);
+
+// Per-name definition counts over a body. Formal parameters count as one
+// definition each (they are written by the caller on entry).
+void ir_count_defs(const IrInstruction* list, int formal_count, IrNameMap* defs);
+
+// ---------- control-flow graph ----------
+
+typedef struct {
+    int start;          // first instruction index (inclusive)
+    int end;            // last instruction index (inclusive)
+    int succs[2];
+    int succ_count;
+    int* preds;
+    int pred_count;
+    int idom;           // immediate dominator, -1 for entry / unreachable blocks
+    int rpo;            // reverse-postorder number, -1 if unreachable
+} IrBlock;
+
+typedef struct {
+    int header;
+    unsigned char* member;  // member[b] != 0 iff block b belongs to the loop
+    int size;               // number of member blocks
+    int depth;              // 1 for outermost loops
+} IrLoop;
+
+typedef struct {
+    IrInstruction** insts;  // body in layout order
+    int inst_count;
+    int formal_end;         // index of the first instruction after the formal IR_PARAMs
+    int* block_of;          // instruction index -> block index
+    IrNameMap labels;       // label name -> block index
+    IrBlock* blocks;
+    int block_count;
+    IrLoop* loops;          // innermost first (ascending size)
+    int loop_count;
+} IrCfg;
+
+IrCfg* ir_cfg_build(IrInstruction* list, int formal_count);
+void ir_cfg_free(IrCfg* cfg);
+// True if block `a` dominates block `b`.
+int ir_cfg_dominates(const IrCfg* cfg, int a, int b);
+// Detect natural loops (back edges whose target dominates their source).
+// Loops sharing a header are merged.
+void ir_cfg_find_loops(IrCfg* cfg);
+// Index of the block whose leading IR_LABEL is `label`, or -1.
+int ir_cfg_block_of_label(const IrCfg* cfg, const char* label);
+
+// Definition counts over a CFG's body, plus the index of the last definition
+// of each name (only meaningful when the count is 1).
+typedef struct {
+    IrNameMap defs;
+    IrNameMap def_site;
+} IrDefInfo;
+
+void ir_def_info_build(IrDefInfo* info, const IrCfg* cfg);
+void ir_def_info_free(IrDefInfo* info);
+// Follows single-definition copies (`t1 = 4`, `t2 = t1`) down to an integer literal.
+int ir_resolve_int_constant(const IrCfg* cfg, const IrDefInfo* info, const char* name, long* out);
+
+// Finds (or creates) the place where code can run once before `loop` is entered.
+// Returns the instruction index before which preheader code must be inserted,
+// or -1 if no safe spot exists. When a new preheader block is needed, outside
+// branches to the header are retargeted and the caller must insert
+// *label_out at the returned index, ahead of its own code.
+int ir_loop_preheader(IRProgram* program, IrCfg* cfg, const IrLoop* loop, IrInstruction** label_out);
+
+// Rewrites the `next` links so the list follows `order[0..count)`.
+void ir_relink(IrInstruction** head, IrInstruction** order, int count);
+
+#endif // IR_ANALYSIS_H
@@ -1,10 +1,9 @@
 #include "ir_generator.h"
+#include "work_pool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static IrFunction* current_function = NULL;
-
 IRProgram* init_ir_program() {
     IRProgram* program = (IRProgram*)malloc(sizeof(IRProgram));
     if (!program) {
@@ -13,11 +12,38 @@ IRProgram* init_ir_program() {
     }
     program->functions = NULL;
     program->global_instructions = NULL;
+    program->global_decls = NULL;
+    program->global_loop_hints = NULL;
     program->temp_counter = 0;
     program->label_counter = 0;
+    program->source_path = NULL;
     return program;
 }
 
+void ir_gen_context_init(IrGenContext* ctx, IRProgram* program) {
+    ctx->program = program;
+    ctx->function = NULL;
+    ctx->tail = &program->global_instructions;
+    while (*ctx->tail) ctx->tail = &(*ctx->tail)->next;
+    ctx->temp_counter = program->temp_counter;
+    ctx->label_counter = program->label_counter;
+    ctx->line = 0;
+}
+
+// Names allocated while lowering come from the context, not the program, so
+// concurrent bodies never share a counter.
+static char* next_temp(IrGenContext* ctx) {
+    char* temp = (char*)malloc(20);
+    sprintf(temp, "t%d", ctx->temp_counter++);
+    return temp;
+}
+
+static char* next_label(IrGenContext* ctx) {
+    char* label = (char*)malloc(20);
+    sprintf(label, "L%d", ctx->label_counter++);
+    return label;
+}
+
 char* new_temp(IRProgram* program) {
     char* temp = (char*)malloc(20);
     sprintf(temp, "t%d", program->temp_counter++);
@@ -42,38 +68,44 @@ IrInstruction* create_instruction(IrOpType op) {
     inst->arg2 = NULL;
     inst->label = NULL;
     inst->line = 0;
+    inst->type = IR_TYPE_UNKNOWN;
     inst->next = NULL;
     return inst;
 }
 
-void emit_instruction(IRProgram* program, IrInstruction* instruction) {
+void emit_instruction(IrGenContext* ctx, IrInstruction* instruction) {
     if (!instruction) return;
+    if (instruction->line == 0) instruction->line = ctx->line;
 
-    if (current_function) {
-        if (!current_function->instructions) {
-            current_function->instructions = instruction;
-        } else {
-            IrInstruction* tail = current_function->instructions;
-            while (tail->next) {
-                tail = tail->next;
-            }
-            tail->next = instruction;
-        }
-    } else {
-        if (!program->global_instructions) {
-            program->global_instructions = instruction;
-        } else {
-            IrInstruction* tail = program->global_instructions;
-            while (tail->next) {
-                tail = tail->next;
-            }
-            tail->next = instruction;
-        }
+    *ctx->tail = instruction;
+    ctx->tail = &instruction->next;
+}
+
+static IrType type_from_ast(AstNode* type) {
+    if (!type || type->type != AST_TYPE) return IR_TYPE_UNKNOWN;
+    switch (((AstType*)type)->type_token) {
+        case TOKEN_ENTIER:  return IR_TYPE_ENTIER;
+        case TOKEN_REEL:    return IR_TYPE_REEL;
+        case TOKEN_BOOLEEN: return IR_TYPE_BOOLEEN;
+        case TOKEN_CHAINE:  return IR_TYPE_CHAINE;
+        default:            return IR_TYPE_UNKNOWN;
     }
 }
 
-char* generate_ir_from_literal(IRProgram* program, AstLiteral* literal) {
-    char* result = new_temp(program);
+// Records a declaration in the body being generated (function or global).
+static void record_decl(IrGenContext* ctx, const char* name, IrType type) {
+    IrDecl* decl = (IrDecl*)malloc(sizeof(IrDecl));
+    decl->name = strdup(name);
+    decl->type = type;
+    decl->next = NULL;
+
+    IrDecl** tail = ctx->function ? &ctx->function->decls : &ctx->program->global_decls;
+    while (*tail) tail = &(*tail)->next;
+    *tail = decl;
+}
+
+char* generate_ir_from_literal(IrGenContext* ctx, AstLiteral* literal) {
+    char* result = next_temp(ctx);
     IrInstruction* inst = create_instruction(IR_ASSIGN);
     inst->result = strdup(result);
 
@@ -101,19 +133,19 @@ char* generate_ir_from_literal(IRProgram* program, AstLiteral* literal) {
             strcpy(value, "0");
     }
     inst->arg1 = strdup(value);
-    emit_instruction(program, inst);
+    emit_instruction(ctx, inst);
     return result;
 }
 
-char* generate_ir_from_variable(IRProgram* program, AstVariable* var) {
-    (void)program;
+char* generate_ir_from_variable(IrGenContext* ctx, AstVariable* var) {
+    (void)ctx;
     return strdup(var->name);
 }
 
-char* generate_ir_from_binary_expr(IRProgram* program, AstBinaryExpr* expr) {
-    char* left = generate_ir_from_node(program, expr->left, NULL);
-    char* right = generate_ir_from_node(program, expr->right, NULL);
-    char* result = new_temp(program);
+char* generate_ir_from_binary_expr(IrGenContext* ctx, AstBinaryExpr* expr) {
+    char* left = generate_ir_from_node(ctx, expr->left, NULL);
+    char* right = generate_ir_from_node(ctx, expr->right, NULL);
+    char* result = next_temp(ctx);
 
     IrInstruction* inst = NULL;
     switch (expr->operator) {
@@ -166,7 +198,7 @@ char* generate_ir_from_binary_expr(IRProgram* program, AstBinaryExpr* expr) {
         inst->result = strdup(result);
         inst->arg1 = strdup(left);
         inst->arg2 = strdup(right);
-        emit_instruction(program, inst);
+        emit_instruction(ctx, inst);
     }
 
     free(left);
@@ -174,9 +206,9 @@ char* generate_ir_from_binary_expr(IRProgram* program, AstBinaryExpr* expr) {
     return result;
 }
 
-char* generate_ir_from_unary_expr(IRProgram* program, AstUnaryExpr* expr) {
-    char* operand = generate_ir_from_node(program, expr->operand, NULL);
-    char* result = new_temp(program);
+char* generate_ir_from_unary_expr(IrGenContext* ctx, AstUnaryExpr* expr) {
+    char* operand = generate_ir_from_node(ctx, expr->operand, NULL);
+    char* result = next_temp(ctx);
 
     IrInstruction* inst = NULL;
     switch (expr->operator) {
@@ -195,203 +227,214 @@ char* generate_ir_from_unary_expr(IRProgram* program, AstUnaryExpr* expr) {
     if (inst) {
         inst->result = strdup(result);
         inst->arg1 = strdup(operand);
-        emit_instruction(program, inst);
+        emit_instruction(ctx, inst);
     }
 
     free(operand);
     return result;
 }
 
-char* generate_ir_from_assignment(IRProgram* program, AstAssignment* assign) {
-    char* value = generate_ir_from_node(program, assign->value, NULL);
+char* generate_ir_from_assignment(IrGenContext* ctx, AstAssignment* assign) {
+    char* value = generate_ir_from_node(ctx, assign->value, NULL);
 
     if (assign->target->type == AST_ARRAY_ACCESS) {
         AstArrayAccess* array_access = (AstArrayAccess*)assign->target;
-        char* array = generate_ir_from_node(program, array_access->array, NULL);
-        char* index = generate_ir_from_node(program, array_access->index, NULL);
+        char* array = generate_ir_from_node(ctx, array_access->array, NULL);
+        char* index = generate_ir_from_node(ctx, array_access->index, NULL);
 
         IrInstruction* inst = create_instruction(IR_ARRAY_ASSIGN);
         inst->result = strdup(array);
         inst->arg1 = strdup(index);
         inst->arg2 = strdup(value);
-        emit_instruction(program, inst);
+        emit_instruction(ctx, inst);
 
         free(array);
         free(index);
         return value; // caller owns
     } else {
-        char* target = generate_ir_from_node(program, assign->target, NULL);
+        char* target = generate_ir_from_node(ctx, assign->target, NULL);
         IrInstruction* inst = create_instruction(IR_ASSIGN);
         inst->result = strdup(target);
         inst->arg1 = strdup(value);
-        emit_instruction(program, inst);
+        emit_instruction(ctx, inst);
 
         free(value);
         return target; // caller owns
     }
 }
 
-void generate_ir_from_if_statement(IRProgram* program, AstIfStatement* if_stmt) {
-    char* condition = generate_ir_from_node(program, if_stmt->condition, NULL);
+void generate_ir_from_if_statement(IrGenContext* ctx, AstIfStatement* if_stmt) {
+    char* condition = generate_ir_from_node(ctx, if_stmt->condition, NULL);
 
-    char* else_label = new_label(program);
-    char* end_label = new_label(program);
+    char* else_label = next_label(ctx);
+    char* end_label = next_label(ctx);
 
     // if !cond goto else_label
     IrInstruction* if_inst = create_instruction(IR_IF_GOTO);
     if_inst->arg1 = strdup(condition);
     if_inst->label = strdup(else_label);
-    emit_instruction(program, if_inst);
+    emit_instruction(ctx, if_inst);
     free(condition);
 
     // then branch
-    char* then_r = generate_ir_from_node(program, if_stmt->then_branch, NULL);
+    char* then_r = generate_ir_from_node(ctx, if_stmt->then_branch, NULL);
     free(then_r);
 
     // goto end
     IrInstruction* goto_end = create_instruction(IR_GOTO);
     goto_end->label = strdup(end_label);
-    emit_instruction(program, goto_end);
+    emit_instruction(ctx, goto_end);
 
     // else_label: (transfer ownership of else_label to this LABEL inst)
     IrInstruction* else_label_inst = create_instruction(IR_LABEL);
     else_label_inst->label = else_label;
-    emit_instruction(program, else_label_inst);
+    emit_instruction(ctx, else_label_inst);
 
     // else branch (optional)
     if (if_stmt->else_branch) {
-        char* else_r = generate_ir_from_node(program, if_stmt->else_branch, NULL);
+        char* else_r = generate_ir_from_node(ctx, if_stmt->else_branch, NULL);
         free(else_r);
     }
 
     // end_label: (transfer ownership)
     IrInstruction* end_label_inst = create_instruction(IR_LABEL);
     end_label_inst->label = end_label;
-    emit_instruction(program, end_label_inst);
+    emit_instruction(ctx, end_label_inst);
 }
 
-void generate_ir_from_while_statement(IRProgram* program, AstWhileStatement* while_stmt) {
-    char* loop_start = new_label(program);
-    char* loop_end = new_label(program);
+void generate_ir_from_while_statement(IrGenContext* ctx, AstWhileStatement* while_stmt) {
+    char* loop_start = next_label(ctx);
+    char* loop_end = next_label(ctx);
 
     IrInstruction* start_label = create_instruction(IR_LABEL);
     start_label->label = strdup(loop_start);
-    emit_instruction(program, start_label);
+    emit_instruction(ctx, start_label);
 
-    char* condition = generate_ir_from_node(program, while_stmt->condition, NULL);
+    char* condition = generate_ir_from_node(ctx, while_stmt->condition, NULL);
 
     IrInstruction* if_inst = create_instruction(IR_IF_GOTO);
     if_inst->arg1 = strdup(condition);
     if_inst->label = strdup(loop_end);
-    emit_instruction(program, if_inst);
+    emit_instruction(ctx, if_inst);
     free(condition);
 
-    char* body_r = generate_ir_from_node(program, while_stmt->body, NULL);
+    char* body_r = generate_ir_from_node(ctx, while_stmt->body, NULL);
     free(body_r);
 
     // goto loop_start: transfer ownership of loop_start
     IrInstruction* goto_start = create_instruction(IR_GOTO);
     goto_start->label = loop_start;
-    emit_instruction(program, goto_start);
+    emit_instruction(ctx, goto_start);
 
     // loop_end label: transfer ownership of loop_end
     IrInstruction* end_label = create_instruction(IR_LABEL);
     end_label->label = loop_end;
-    emit_instruction(program, end_label);
+    emit_instruction(ctx, end_label);
 }
 
-void generate_ir_from_for_statement(IRProgram* program, AstForStatement* for_stmt) {
+void generate_ir_from_for_statement(IrGenContext* ctx, AstForStatement* for_stmt) {
     if (for_stmt->init) {
-        char* r = generate_ir_from_node(program, for_stmt->init, NULL);
+        char* r = generate_ir_from_node(ctx, for_stmt->init, NULL);
         free(r);
     }
 
-    char* loop_start = new_label(program);
-    char* loop_end = new_label(program);
+    char* loop_start = next_label(ctx);
+    char* loop_end = next_label(ctx);
 
     IrInstruction* start_label = create_instruction(IR_LABEL);
     start_label->label = strdup(loop_start);
-    emit_instruction(program, start_label);
+    emit_instruction(ctx, start_label);
 
     if (for_stmt->condition) {
-        char* condition = generate_ir_from_node(program, for_stmt->condition, NULL);
+        char* condition = generate_ir_from_node(ctx, for_stmt->condition, NULL);
         IrInstruction* if_inst = create_instruction(IR_IF_GOTO);
         if_inst->arg1 = strdup(condition);
         if_inst->label = strdup(loop_end);
-        emit_instruction(program, if_inst);
+        emit_instruction(ctx, if_inst);
         free(condition);
     }
 
-    char* body_r = generate_ir_from_node(program, for_stmt->body, NULL);
+    char* body_r = generate_ir_from_node(ctx, for_stmt->body, NULL);
     free(body_r);
 
     if (for_stmt->update) {
-        char* upd_r = generate_ir_from_node(program, for_stmt->update, NULL);
+        char* upd_r = generate_ir_from_node(ctx, for_stmt->update, NULL);
         free(upd_r);
     }
 
     // transfer ownership
     IrInstruction* goto_start = create_instruction(IR_GOTO);
     goto_start->label = loop_start;
-    emit_instruction(program, goto_start);
+    emit_instruction(ctx, goto_start);
 
     IrInstruction* end_label = create_instruction(IR_LABEL);
     end_label->label = loop_end;
-    emit_instruction(program, end_label);
+    emit_instruction(ctx, end_label);
 }
 
-void generate_ir_from_return_statement(IRProgram* program, AstReturnStatement* ret_stmt) {
+void generate_ir_from_return_statement(IrGenContext* ctx, AstReturnStatement* ret_stmt) {
     char* value = NULL;
     if (ret_stmt->value) {
-        value = generate_ir_from_node(program, ret_stmt->value, NULL);
+        value = generate_ir_from_node(ctx, ret_stmt->value, NULL);
     }
 
     IrInstruction* inst = create_instruction(IR_RETURN);
     inst->arg1 = value ? strdup(value) : NULL;
-    emit_instruction(program, inst);
+    emit_instruction(ctx, inst);
     free(value);
 }
 
-char* generate_ir_from_function_call(IRProgram* program, AstFunctionCall* call) {
+char* generate_ir_from_function_call(IrGenContext* ctx, AstFunctionCall* call) {
     // Emit IR_PARAM for each argument (evaluated left-to-right).
     // The backend will pop them when it sees the IR_CALL that follows.
     for (int i = 0; i < call->argument_count; i++) {
-        char* arg = generate_ir_from_node(program, call->arguments[i], NULL);
+        char* arg = generate_ir_from_node(ctx, call->arguments[i], NULL);
         IrInstruction* p = create_instruction(IR_PARAM);
         p->arg1 = arg ? strdup(arg) : NULL;
-        emit_instruction(program, p);
+        emit_instruction(ctx, p);
         free(arg);
     }
 
-    char* result = new_temp(program);
+    char* result = next_temp(ctx);
+    char arg_count[16];
+    snprintf(arg_count, sizeof(arg_count), "%d", call->argument_count);
     IrInstruction* inst = create_instruction(IR_CALL);
     inst->result = strdup(result);
     inst->arg1 = strdup(call->name);
-    emit_instruction(program, inst);
+    inst->arg2 = strdup(arg_count); // number of IR_PARAMs this call consumes
+    emit_instruction(ctx, inst);
 
     return result;
 }
 
-void generate_ir_from_block(IRProgram* program, AstBlock* block) {
+void generate_ir_from_block(IrGenContext* ctx, AstBlock* block) {
     for (int i = 0; i < block->statement_count; i++) {
-        char* r = generate_ir_from_node(program, block->statements[i], NULL);
+        char* r = generate_ir_from_node(ctx, block->statements[i], NULL);
         free(r); // safe even if NULL
     }
 }
 
-void generate_ir_from_function_decl(IRProgram* program, AstFunctionDeclaration* func_decl) {
+// Creates the IrFunction for `func_decl` (signature only, empty body) and
+// appends it to the program's function list.
+static IrFunction* declare_ir_function(IRProgram* program, AstFunctionDeclaration* func_decl) {
     IrFunction* func = (IrFunction*)malloc(sizeof(IrFunction));
     func->name = strdup(func_decl->name);
     func->param_count = func_decl->parameter_count;
     func->params = NULL;
+    func->param_types = NULL;
+    func->return_type = IR_TYPE_UNKNOWN;
+    func->decls = NULL;
     func->instructions = NULL;
+    func->loop_hints = NULL;
     func->next = NULL;
 
     if (func_decl->parameter_count > 0) {
         func->params = (char**)malloc(sizeof(char*) * func_decl->parameter_count);
+        func->param_types = (IrType*)malloc(sizeof(IrType) * func_decl->parameter_count);
         for (int i = 0; i < func_decl->parameter_count; i++) {
             AstParameter* param = (AstParameter*)func_decl->parameters[i];
             func->params[i] = strdup(param->name);
+            func->param_types[i] = type_from_ast(param->type);
         }
     }
 
@@ -404,106 +447,143 @@ void generate_ir_from_function_decl(IRProgram* program, AstFunctionDeclaration*
         }
         tail->next = func;
     }
+    return func;
+}
 
-    current_function = func;
+// Lowers the body of `func` into a fresh context `body`. Temps and labels are
+// numbered from 0 in every function, so bodies get the same names whatever
+// order (or thread) they are lowered in. Only `func` and `body` are written.
+static void lower_function_body(IrGenContext* body, IRProgram* program, IrFunction* func,
+                                AstFunctionDeclaration* func_decl) {
+    body->program = program;
+    body->function = func;
+    body->tail = &func->instructions;
+    body->temp_counter = 0;
+    body->label_counter = 0;
+    body->line = func_decl->base.line;
 
     IrInstruction* func_begin = create_instruction(IR_FUNC_BEGIN);
     func_begin->arg1 = strdup(func_decl->name);
-    emit_instruction(program, func_begin);
+    emit_instruction(body, func_begin);
 
     for (int i = 0; i < func_decl->parameter_count; i++) {
         AstParameter* param = (AstParameter*)func_decl->parameters[i];
         IrInstruction* param_inst = create_instruction(IR_PARAM);
         param_inst->arg1 = strdup(param->name);
-        emit_instruction(program, param_inst);
+        emit_instruction(body, param_inst);
     }
 
     if (func_decl->body) {
-        char* body_r = generate_ir_from_node(program, func_decl->body, NULL);
+        char* body_r = generate_ir_from_node(body, func_decl->body, NULL);
         free(body_r);
     }
 
     IrInstruction* func_end = create_instruction(IR_FUNC_END);
-    emit_instruction(program, func_end);
+    emit_instruction(body, func_end);
+}
+
+// Later passes draw fresh names from the program counters: keep them above
+// every name a body has used.
+static void merge_counters(IRProgram* program, const IrGenContext* ctx) {
+    if (ctx->temp_counter > program->temp_counter) program->temp_counter = ctx->temp_counter;
+    if (ctx->label_counter > program->label_counter) program->label_counter = ctx->label_counter;
+}
 
-    current_function = NULL;
+void generate_ir_from_function_decl(IrGenContext* ctx, AstFunctionDeclaration* func_decl) {
+    IrFunction* func = declare_ir_function(ctx->program, func_decl);
+    IrGenContext body;
+    lower_function_body(&body, ctx->program, func, func_decl);
+    merge_counters(ctx->program, &body);
 }
 
-void generate_ir_from_variable_decl(IRProgram* program, AstVariableDeclaration* var_decl) {
+void generate_ir_from_variable_decl(IrGenContext* ctx, AstVariableDeclaration* var_decl) {
+    record_decl(ctx, var_decl->name, type_from_ast(var_decl->type));
     if (var_decl->initializer) {
-        char* value = generate_ir_from_node(program, var_decl->initializer, NULL);
+        char* value = generate_ir_from_node(ctx, var_decl->initializer, NULL);
         IrInstruction* inst = create_instruction(IR_ASSIGN);
         inst->result = strdup(var_decl->name);
         inst->arg1 = strdup(value);
-        emit_instruction(program, inst);
+        emit_instruction(ctx, inst);
         free(value);
     }
 }
 
-char* generate_ir_from_array_access(IRProgram* program, AstArrayAccess* array_access) {
-    char* array = generate_ir_from_node(program, array_access->array, NULL);
-    char* index = generate_ir_from_node(program, array_access->index, NULL);
-    char* result = new_temp(program);
+char* generate_ir_from_array_access(IrGenContext* ctx, AstArrayAccess* array_access) {
+    char* array = generate_ir_from_node(ctx, array_access->array, NULL);
+    char* index = generate_ir_from_node(ctx, array_access->index, NULL);
+    char* result = next_temp(ctx);
 
     IrInstruction* inst = create_instruction(IR_ARRAY_ACCESS);
     inst->result = strdup(result);
     inst->arg1 = strdup(array);
     inst->arg2 = strdup(index);
-    emit_instruction(program, inst);
+    emit_instruction(ctx, inst);
 
     free(array);
     free(index);
     return result;
 }
 
-char* generate_ir_from_node(IRProgram* program, AstNode* node, char* result_var) {
+static char* lower_node(IrGenContext* ctx, AstNode* node);
+
+// Instructions take the line of the innermost statement they come from;
+// expressions and the parts of a `pour` the parser builds have none.
+char* generate_ir_from_node(IrGenContext* ctx, AstNode* node, char* result_var) {
     (void)result_var; // reserved for future SSA-style hinting
     if (!node) return NULL;
+    int outer_line = ctx->line;
+    if (node->line > 0) ctx->line = node->line;
+    char* result = lower_node(ctx, node);
+    ctx->line = outer_line;
+    return result;
+}
+
+static char* lower_node(IrGenContext* ctx, AstNode* node) {
 
     switch (node->type) {
         case AST_PROGRAM: {
             AstProgram* prog = (AstProgram*)node;
             for (int i = 0; i < prog->declaration_count; i++) {
-                char* r = generate_ir_from_node(program, prog->declarations[i], NULL);
+                char* r = generate_ir_from_node(ctx, prog->declarations[i], NULL);
                 free(r); // safe even if NULL
             }
             return NULL;
         }
         case AST_FUNCTION_DECL:
-            generate_ir_from_function_decl(program, (AstFunctionDeclaration*)node);
+            generate_ir_from_function_decl(ctx, (AstFunctionDeclaration*)node);
             return NULL;
         case AST_BLOCK_DECL:
-            generate_ir_from_block(program, (AstBlock*)node);
+            generate_ir_from_block(ctx, (AstBlock*)node);
             return NULL;
         case AST_VARIABLE_DECL:
-            generate_ir_from_variable_decl(program, (AstVariableDeclaration*)node);
+            generate_ir_from_variable_decl(ctx, (AstVariableDeclaration*)node);
             return NULL;
         case AST_ASSIGNMENT:
-            return generate_ir_from_assignment(program, (AstAssignment*)node);
+            return generate_ir_from_assignment(ctx, (AstAssignment*)node);
         case AST_BINARY_EXPR:
-            return generate_ir_from_binary_expr(program, (AstBinaryExpr*)node);
+            return generate_ir_from_binary_expr(ctx, (AstBinaryExpr*)node);
         case AST_UNARY_EXPR:
-            return generate_ir_from_unary_expr(program, (AstUnaryExpr*)node);
+            return generate_ir_from_unary_expr(ctx, (AstUnaryExpr*)node);
         case AST_IF_STATEMENT:
-            generate_ir_from_if_statement(program, (AstIfStatement*)node);
+            generate_ir_from_if_statement(ctx, (AstIfStatement*)node);
             return NULL;
         case AST_WHILE_STATEMENT:
-            generate_ir_from_while_statement(program, (AstWhileStatement*)node);
+            generate_ir_from_while_statement(ctx, (AstWhileStatement*)node);
             return NULL;
         case AST_FOR_STATEMENT:
-            generate_ir_from_for_statement(program, (AstForStatement*)node);
+            generate_ir_from_for_statement(ctx, (AstForStatement*)node);
             return NULL;
         case AST_RETURN_STATEMENT:
-            generate_ir_from_return_statement(program, (AstReturnStatement*)node);
+            generate_ir_from_return_statement(ctx, (AstReturnStatement*)node);
             return NULL;
         case AST_FUNCTION_CALL:
-            return generate_ir_from_function_call(program, (AstFunctionCall*)node);
+            return generate_ir_from_function_call(ctx, (AstFunctionCall*)node);
         case AST_VARIABLE:
-            return generate_ir_from_variable(program, (AstVariable*)node);
+            return generate_ir_from_variable(ctx, (AstVariable*)node);
         case AST_LITERAL:
-            return generate_ir_from_literal(program, (AstLiteral*)node);
+            return generate_ir_from_literal(ctx, (AstLiteral*)node);
         case AST_ARRAY_ACCESS:
-            return generate_ir_from_array_access(program, (AstArrayAccess*)node);
+            return generate_ir_from_array_access(ctx, (AstArrayAccess*)node);
         default:
             fprintf(stderr, "Unknown AST node type: %d\n", node->type);
             return NULL;
@@ -511,10 +591,65 @@ char* generate_ir_from_node(IRProgram* program, AstNode* node, char* result_var)
 }
 
 IRProgram* generate_ir(AstNode* ast) {
+    return generate_ir_parallel(ast, 1);
+}
+
+// One function body to lower, filled in by a worker.
+typedef struct {
+    IrFunction* func;
+    AstFunctionDeclaration* decl;
+    IrGenContext body;
+} FunctionJob;
+
+typedef struct {
+    IRProgram* program;
+    FunctionJob* jobs;
+} FunctionJobs;
+
+static void lower_function_job(void* data, int index) {
+    FunctionJobs* batch = (FunctionJobs*)data;
+    FunctionJob* job = &batch->jobs[index];
+    lower_function_body(&job->body, batch->program, job->func, job->decl);
+}
+
+IRProgram* generate_ir_parallel(AstNode* ast, int jobs) {
     IRProgram* program = init_ir_program();
     if (!program) return NULL;
 
-    generate_ir_from_node(program, ast, NULL);
+    IrGenContext ctx;
+    ir_gen_context_init(&ctx, program);
+    if (!ast || ast->type != AST_PROGRAM) {
+        generate_ir_from_node(&ctx, ast, NULL);
+        merge_counters(program, &ctx);
+        return program;
+    }
+
+    // Global code is lowered here, in order; functions are only declared, so
+    // the function list keeps source order, and their bodies queued.
+    AstProgram* prog = (AstProgram*)ast;
+    FunctionJobs batch = { program, NULL };
+    int job_count = 0;
+    if (prog->declaration_count > 0) {
+        batch.jobs = (FunctionJob*)malloc(sizeof(FunctionJob) * prog->declaration_count);
+    }
+    for (int i = 0; i < prog->declaration_count; i++) {
+        AstNode* decl = prog->declarations[i];
+        if (decl && decl->type == AST_FUNCTION_DECL) {
+            FunctionJob* job = &batch.jobs[job_count++];
+            job->decl = (AstFunctionDeclaration*)decl;
+            job->func = declare_ir_function(program, job->decl);
+        } else {
+            char* r = generate_ir_from_node(&ctx, decl, NULL);
+            free(r);
+        }
+    }
+    merge_counters(program, &ctx);
+
+    work_pool_run(job_count, jobs, lower_function_job, &batch);
+    for (int i = 0; i < job_count; i++) {
+        merge_counters(program, &batch.jobs[i].body);
+    }
+    free(batch.jobs);
     return program;
 }
 
@@ -602,6 +737,37 @@ void print_instruction(IrInstruction* inst) {
         case IR_ARRAY_ASSIGN:
             printf("    %s[%s] = %s\n", inst->result, inst->arg1, inst->arg2);
             break;
+        case IR_ITOF:
+            printf("    %s = (reel) %s\n", inst->result, inst->arg1);
+            break;
+        case IR_FTOI:
+            printf("    %s = (entier) %s\n", inst->result, inst->arg1);
+            break;
+    }
+}
+
+static const char* cmp_symbol(IrOpType op) {
+    switch (op) {
+        case IR_LT:  return "<";
+        case IR_LE:  return "<=";
+        case IR_GT:  return ">";
+        case IR_GE:  return ">=";
+        case IR_EQ:  return "==";
+        case IR_NEQ: return "!=";
+        default:     return "?";
+    }
+}
+
+static void print_loop_hints(IrLoopHint* hint) {
+    for (; hint; hint = hint->next) {
+        printf("Loop %s: iv %s from %s step %ld while %s %s %s, ",
+               hint->header, hint->iv, hint->init ? hint->init : "?", hint->step,
+               hint->iv, cmp_symbol(hint->cmp), hint->bound);
+        if (hint->trip_count >= 0) {
+            printf("trip count %ld\n", hint->trip_count);
+        } else {
+            printf("trip count unknown\n");
+        }
     }
 }
 
@@ -617,6 +783,7 @@ void ir_print_program(IRProgram* program) {
             print_instruction(inst);
             inst = inst->next;
         }
+        print_loop_hints(program->global_loop_hints);
         printf("\n");
     }
 
@@ -626,23 +793,49 @@ void ir_print_program(IRProgram* program) {
         if (func->param_count > 0) {
             printf("Parameters: ");
             for (int i = 0; i < func->param_count; i++) {
+                if (func->param_types && func->param_types[i] != IR_TYPE_UNKNOWN) {
+                    printf("%s ", ir_type_name(func->param_types[i]));
+                }
                 printf("%s", func->params[i]);
                 if (i < func->param_count - 1) printf(", ");
             }
             printf("\n");
         }
+        if (func->return_type != IR_TYPE_UNKNOWN) {
+            printf("Returns: %s\n", ir_type_name(func->return_type));
+        }
 
         IrInstruction* inst = func->instructions;
         while (inst) {
             print_instruction(inst);
             inst = inst->next;
         }
+        print_loop_hints(func->loop_hints);
         func = func->next;
     }
 
     printf("=== End IR Program ===\n");
 }
 
+const char* ir_type_name(IrType type) {
+    switch (type) {
+        case IR_TYPE_ENTIER:  return "entier";
+        case IR_TYPE_REEL:    return "reel";
+        case IR_TYPE_BOOLEEN: return "booleen";
+        case IR_TYPE_CHAINE:  return "chaine";
+        default:              return "?";
+    }
+}
+
+static void free_decls(IrDecl* decl) {
+    while (decl) {
+        IrDecl* next = decl->next;
+        free(decl->name);
+        free(decl);
+        decl = next;
+    }
+}
+
 void free_instruction(IrInstruction* inst) {
     if (!inst) return;
     free(inst->result);
@@ -660,6 +853,18 @@ void free_instruction_list(IrInstruction* inst) {
     }
 }
 
+void ir_free_loop_hints(IrLoopHint* hint) {
+    while (hint) {
+        IrLoopHint* next = hint->next;
+        free(hint->header);
+        free(hint->iv);
+        free(hint->init);
+        free(hint->bound);
+        free(hint);
+        hint = next;
+    }
+}
+
 void free_function(IrFunction* func) {
     if (!func) return;
     free(func->name);
@@ -669,7 +874,10 @@ void free_function(IrFunction* func) {
         }
         free(func->params);
     }
+    free(func->param_types);
+    free_decls(func->decls);
     free_instruction_list(func->instructions);
+    ir_free_loop_hints(func->loop_hints);
     free(func);
 }
 
@@ -677,6 +885,8 @@ void ir_free_program(IRProgram* program) {
     if (!program) return;
 
     free_instruction_list(program->global_instructions);
+    free_decls(program->global_decls);
+    ir_free_loop_hints(program->global_loop_hints);
 
     IrFunction* func = program->functions;
     while (func) {
@@ -685,5 +895,6 @@ void ir_free_program(IRProgram* program) {
         func = next;
     }
 
+    free(program->source_path);
     free(program);
 }
\ No newline at end of file
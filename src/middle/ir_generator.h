@@ -30,42 +30,109 @@ typedef enum {
     IR_FUNC_BEGIN,
     IR_FUNC_END,
     IR_ARRAY_ACCESS,
-    IR_ARRAY_ASSIGN
+    IR_ARRAY_ASSIGN,
+    IR_ITOF,            // result = (reel) arg1
+    IR_FTOI             // result = (entier) arg1, truncating
 } IrOpType;
 
+// CypLang value types. IR_TYPE_UNKNOWN until the type pass (ir_types.h) runs.
+typedef enum {
+    IR_TYPE_UNKNOWN,
+    IR_TYPE_ENTIER,
+    IR_TYPE_REEL,
+    IR_TYPE_BOOLEEN,
+    IR_TYPE_CHAINE
+} IrType;
+
+// A declared variable (`reel x`), recorded even without an initializer.
+typedef struct IrDecl {
+    char* name;
+    IrType type;
+    struct IrDecl* next;
+} IrDecl;
+
 typedef struct IrInstruction {
     IrOpType op;
     char* result;
     char* arg1;
     char* arg2;
     char* label;
-    int line;
+    int line;           // source line (0: unknown; emit_instruction() sets it)
+    IrType type;        // type of `result` (set by the type pass)
     struct IrInstruction* next;
 } IrInstruction;
 
+// Facts about a counted loop, recorded by the induction-variable pass for
+// later passes and the emitter, which turns a known trip count into branch
+// weights on the header's test (LLVM's unroller and vectoriser read them).
+// The loop keeps running while `iv cmp bound` holds.
+typedef struct IrLoopHint {
+    char* header;       // label of the loop header
+    char* iv;           // basic induction variable
+    long step;          // added to `iv` once per iteration (negative for `bas` loops)
+    char* init;         // value of `iv` on entry: literal, invariant name, or NULL if unknown
+    char* bound;        // literal or loop-invariant name
+    IrOpType cmp;       // IR_LT / IR_LE / IR_GT / IR_GE / IR_NEQ
+    long trip_count;    // exact iteration count, or -1 when only known symbolically
+                        // or when the loop has another exit than the header's test
+    struct IrLoopHint* next;
+} IrLoopHint;
+
 typedef struct IrFunction {
     char* name;
     char** params;
+    IrType* param_types;    // declared types of the formals
     int param_count;
+    IrType return_type;     // inferred from the returned values
+    IrDecl* decls;
     IrInstruction* instructions;
+    IrLoopHint* loop_hints;
     struct IrFunction* next;
 } IrFunction;
 
 typedef struct IRProgram {
     IrFunction* functions;
     IrInstruction* global_instructions;
+    IrDecl* global_decls;
+    IrLoopHint* global_loop_hints;
     int temp_counter;
     int label_counter;
+    char* source_path;      // file the program comes from, for debug info (NULL: unknown)
 } IRProgram;
 
+// All state of one lowering: the program being built, the body receiving
+// instructions, its append point and the names handed out so far. Nothing is
+// kept in globals, so separate programs (or separate function bodies of one
+// program) can be lowered concurrently, one context per thread. Each function
+// body numbers its temps and labels from 0; the program counters are raised
+// past them afterwards, for the IR passes that allocate names later.
+typedef struct IrGenContext {
+    IRProgram* program;
+    IrFunction* function;       // function being lowered, NULL for global code
+    IrInstruction** tail;       // where the next emitted instruction is linked
+    int temp_counter;
+    int label_counter;
+    int line;                   // source line of the statement being lowered, 0: none
+} IrGenContext;
+
 IRProgram* generate_ir(AstNode* ast);
-char* generate_ir_from_node(IRProgram* program, AstNode* node, char* result_var);
+// Same as generate_ir(), lowering function bodies on up to `jobs` threads.
+// The result does not depend on `jobs`.
+IRProgram* generate_ir_parallel(AstNode* ast, int jobs);
+// Starts emitting at the end of the program's global instructions.
+void ir_gen_context_init(IrGenContext* ctx, IRProgram* program);
+char* generate_ir_from_node(IrGenContext* ctx, AstNode* node, char* result_var);
 void ir_print_program(IRProgram* program);
 void ir_free_program(IRProgram* program);
 
 char* new_temp(IRProgram* program);
 char* new_label(IRProgram* program);
-void emit_instruction(IRProgram* program, IrInstruction* instruction);
+void emit_instruction(IrGenContext* ctx, IrInstruction* instruction);
 IrInstruction* create_instruction(IrOpType op);
+void free_instruction(IrInstruction* inst);
+void free_instruction_list(IrInstruction* inst);
+void ir_free_loop_hints(IrLoopHint* hint);
+// "entier", "reel", "booleen", "chaine" or "?".
+const char* ir_type_name(IrType type);
 
 #endif //IR_GENERATOR_H
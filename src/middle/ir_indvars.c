@@ -0,0 +1,636 @@
+#include "ir_indvars.h"
+#include "ir_analysis.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_IVS 16
+
+// A basic induction variable: defined exactly once in the loop, by
+// `name = name + step` (possibly through a temporary).
+typedef struct {
+    const char* name;
+    int update;     // instruction defining `name`
+    int add;        // the IR_ADD / IR_SUB computing the new value (may equal `update`)
+    long step;
+} BasicIv;
+
+// A strength-reduced product `iv * factor`, shared by identical products.
+typedef struct {
+    int iv;             // index into the BasicIv array
+    char* factor;       // literal or invariant name
+    char* recurrence;   // name of the additive recurrence
+} Reduced;
+
+static void count_loop_defs(const IrCfg* cfg, const IrLoop* loop, IrNameMap* loop_defs) {
+    ir_name_map_init(loop_defs, 16);
+    for (int i = 0; i < cfg->inst_count; i++) {
+        if (!loop->member[cfg->block_of[i]]) continue;
+        const char* def = ir_inst_def(cfg->insts[i]);
+        if (def) (*ir_name_map_slot(loop_defs, def))++;
+    }
+}
+
+static int is_invariant(const IrNameMap* loop_defs, const char* name) {
+    return name && (ir_is_literal(name) || ir_name_map_get(loop_defs, name, 0) == 0);
+}
+
+// Matches `add` as `name + c`, `c + name` or `name - c` with c an integer constant.
+static int match_step(const IrCfg* cfg, const IrDefInfo* info, const IrInstruction* add,
+                      const char* name, long* step) {
+    long c = 0;
+    if (add->op == IR_ADD) {
+        if (strcmp(add->arg1, name) == 0 && ir_resolve_int_constant(cfg, info, add->arg2, &c)) {
+            *step = c;
+            return 1;
+        }
+        if (strcmp(add->arg2, name) == 0 && ir_resolve_int_constant(cfg, info, add->arg1, &c)) {
+            *step = c;
+            return 1;
+        }
+    } else if (add->op == IR_SUB) {
+        if (strcmp(add->arg1, name) == 0 && ir_resolve_int_constant(cfg, info, add->arg2, &c)) {
+            *step = -c;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int find_basic_ivs(const IrCfg* cfg, const IrDefInfo* info, const IrLoop* loop,
+                          const IrNameMap* loop_defs, BasicIv* out) {
+    int count = 0;
+    for (int i = 0; i < cfg->inst_count && count < MAX_IVS; i++) {
+        if (!loop->member[cfg->block_of[i]]) continue;
+        IrInstruction* inst = cfg->insts[i];
+        const char* name = ir_inst_def(inst);
+        if (!name || ir_name_map_get(loop_defs, name, 0) != 1) continue;
+
+        int add = -1;
+        if (inst->op == IR_ADD || inst->op == IR_SUB) {
+            add = i;
+        } else if (inst->op == IR_ASSIGN && ir_name_map_get(&info->defs, inst->arg1, 0) == 1) {
+            add = ir_name_map_get(&info->def_site, inst->arg1, -1);
+            if (add < cfg->formal_end || !loop->member[cfg->block_of[add]]) continue;
+        } else {
+            continue;
+        }
+
+        long step = 0;
+        if (!match_step(cfg, info, cfg->insts[add], name, &step) || step == 0) continue;
+        out[count].name = name;
+        out[count].update = i;
+        out[count].add = add;
+        out[count].step = step;
+        count++;
+    }
+    return count;
+}
+
+static int find_iv(const BasicIv* ivs, int iv_count, const char* name) {
+    for (int v = 0; v < iv_count; v++) {
+        if (name && strcmp(ivs[v].name, name) == 0) return v;
+    }
+    return -1;
+}
+
+// Appends `inst` to the chain starting at *head (chains are linked through
+// `next`, which is rewritten by ir_relink afterwards).
+static void chain_append(IrInstruction** head, IrInstruction* inst) {
+    while (*head) head = &(*head)->next;
+    *head = inst;
+}
+
+static IrInstruction* make_binary(IrOpType op, const char* result, const char* arg1, const char* arg2, IrType type) {
+    IrInstruction* inst = create_instruction(op);
+    inst->type = type;
+    inst->result = strdup(result);
+    inst->arg1 = strdup(arg1);
+    inst->arg2 = strdup(arg2);
+    return inst;
+}
+
+// True if `name` is read somewhere reachable from the loop's exits, other
+// than by instruction `except`.
+static int used_after_loop(const IrCfg* cfg, const IrLoop* loop, const char* name, int except) {
+    unsigned char* seen = calloc((size_t)cfg->block_count, 1);
+    int* work = malloc(sizeof(int) * (size_t)cfg->block_count);
+    int top = 0, used = 0;
+
+    for (int b = 0; b < cfg->block_count; b++) {
+        if (!loop->member[b]) continue;
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+            int succ = cfg->blocks[b].succs[s];
+            if (!loop->member[succ] && !seen[succ]) {
+                seen[succ] = 1;
+                work[top++] = succ;
+            }
+        }
+    }
+    while (top > 0 && !used) {
+        int b = work[--top];
+        for (int i = cfg->blocks[b].start; i <= cfg->blocks[b].end && !used; i++) {
+            const char* uses[3];
+            int n = ir_inst_uses(cfg->insts[i], uses);
+            for (int u = 0; u < n; u++) {
+                if (i != except && strcmp(uses[u], name) == 0) used = 1;
+            }
+        }
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+            int succ = cfg->blocks[b].succs[s];
+            if (!seen[succ]) {
+                seen[succ] = 1;
+                work[top++] = succ;
+            }
+        }
+    }
+    free(seen);
+    free(work);
+    return used;
+}
+
+static int uses_in_loop(const IrCfg* cfg, const IrLoop* loop, const char* name, int except) {
+    int count = 0;
+    for (int i = 0; i < cfg->inst_count; i++) {
+        if (i == except || !loop->member[cfg->block_of[i]]) continue;
+        const char* uses[3];
+        int n = ir_inst_uses(cfg->insts[i], uses);
+        for (int u = 0; u < n; u++) {
+            if (strcmp(uses[u], name) == 0) count++;
+        }
+    }
+    return count;
+}
+
+// Value of `name` when control reaches the loop header from outside: the last
+// definition along the chain of single-predecessor blocks above the header.
+static char* entry_value(const IrCfg* cfg, const IrDefInfo* info, const IrLoop* loop, const char* name) {
+    const IrBlock* header = &cfg->blocks[loop->header];
+    int block = -1;
+    for (int p = 0; p < header->pred_count; p++) {
+        if (loop->member[header->preds[p]]) continue;
+        if (block >= 0) return NULL;
+        block = header->preds[p];
+    }
+
+    for (int hops = 0; block >= 0 && hops < 64; hops++) {
+        const IrBlock* b = &cfg->blocks[block];
+        for (int i = b->end; i >= b->start; i--) {
+            const IrInstruction* inst = cfg->insts[i];
+            const char* def = (i < cfg->formal_end && inst->op == IR_PARAM) ? inst->arg1 : ir_inst_def(inst);
+            if (!def || strcmp(def, name) != 0) continue;
+            if (inst->op != IR_ASSIGN) return NULL;
+
+            long value = 0;
+            char buf[32];
+            if (ir_resolve_int_constant(cfg, info, inst->arg1, &value)) {
+                snprintf(buf, sizeof(buf), "%ld", value);
+                return strdup(buf);
+            }
+            // A single-definition source cannot change between here and the header.
+            if (ir_name_map_get(&info->defs, inst->arg1, 0) == 1) return strdup(inst->arg1);
+            return NULL;
+        }
+        block = b->pred_count == 1 ? b->preds[0] : -1;
+    }
+    return NULL;
+}
+
+// True if the loop header's exit test reads `name`.
+static int header_test_reads(const IrCfg* cfg, const IrDefInfo* info, const IrLoop* loop, const char* name) {
+    const IrInstruction* exit = cfg->insts[cfg->blocks[loop->header].end];
+    if (exit->op != IR_IF_GOTO || ir_name_map_get(&info->defs, exit->arg1, 0) != 1) return 0;
+    const IrInstruction* test = cfg->insts[ir_name_map_get(&info->def_site, exit->arg1, 0)];
+    const char* uses[3];
+    int n = ir_inst_uses(test, uses);
+    for (int u = 0; u < n; u++) {
+        if (strcmp(uses[u], name) == 0) return 1;
+    }
+    return 0;
+}
+
+// True if an instruction strictly between `low` and `high` reads `name`,
+// `except` aside.
+static int used_between(const IrCfg* cfg, const char* name, int low, int high, int except) {
+    for (int i = low + 1; i < high; i++) {
+        if (i == except) continue;
+        const char* uses[3];
+        int n = ir_inst_uses(cfg->insts[i], uses);
+        for (int u = 0; u < n; u++) {
+            if (strcmp(uses[u], name) == 0) return 1;
+        }
+    }
+    return 0;
+}
+
+// Makes every operand of `inst` that reads `name` read `with` instead.
+static void replace_use(IrInstruction* inst, const char* name, const char* with) {
+    const char* uses[3];
+    int n = ir_inst_uses(inst, uses);
+    for (int u = 0; u < n; u++) {
+        if (strcmp(uses[u], name) != 0) continue;
+        char** field = uses[u] == inst->result ? &inst->result : uses[u] == inst->arg1 ? &inst->arg1 : &inst->arg2;
+        free(*field);
+        *field = strdup(with);
+    }
+}
+
+// Strength-reduces and cleans up one loop. Returns the number of rewrites
+// (0 means the list was left untouched).
+static int reduce_loop(IRProgram* program, IrInstruction** head, IrCfg* cfg, IrLoop* loop) {
+    IrDefInfo info;
+    ir_def_info_build(&info, cfg);
+    IrNameMap loop_defs;
+    count_loop_defs(cfg, loop, &loop_defs);
+
+    BasicIv ivs[MAX_IVS];
+    int iv_count = find_basic_ivs(cfg, &info, loop, &loop_defs, ivs);
+    int rewrites = 0;
+
+    IrInstruction** after = calloc((size_t)cfg->inst_count, sizeof(IrInstruction*));
+    unsigned char* removed = calloc((size_t)cfg->inst_count, 1);
+    IrInstruction* preheader_code = NULL;
+    IrInstruction* preheader_label = NULL;
+    int insert_before = -1;
+    Reduced reduced[MAX_IVS];
+    int reduced_count = 0;
+
+    // 1. `t = iv * k` -> `t = r`, with r = iv * k on entry and r += step * k
+    //    right after every update of iv.
+    for (int i = 0; i < cfg->inst_count && iv_count > 0; i++) {
+        IrInstruction* inst = cfg->insts[i];
+        if (inst->op != IR_MUL || !loop->member[cfg->block_of[i]]) continue;
+        // Recurrences are exact only in integer arithmetic.
+        if (inst->type == IR_TYPE_REEL) continue;
+
+        int v = find_iv(ivs, iv_count, inst->arg1);
+        const char* factor = inst->arg2;
+        if (v < 0) {
+            v = find_iv(ivs, iv_count, inst->arg2);
+            factor = inst->arg1;
+        }
+        if (v < 0 || !is_invariant(&loop_defs, factor)) continue;
+
+        long factor_value = 0;
+        int factor_const = ir_resolve_int_constant(cfg, &info, factor, &factor_value);
+        char factor_key[32];
+        if (factor_const) {
+            snprintf(factor_key, sizeof(factor_key), "%ld", factor_value);
+            factor = factor_key;
+        }
+
+        Reduced* red = NULL;
+        for (int r = 0; r < reduced_count; r++) {
+            if (reduced[r].iv == v && strcmp(reduced[r].factor, factor) == 0) red = &reduced[r];
+        }
+        if (!red) {
+            if (reduced_count >= MAX_IVS) continue;
+            if (insert_before < 0) {
+                insert_before = ir_loop_preheader(program, cfg, loop, &preheader_label);
+                if (insert_before < 0) break;
+            }
+
+            char* temp = new_temp(program);
+            char name[32];
+            snprintf(name, sizeof(name), "iv%s", temp + 1);
+            free(temp);
+
+            red = &reduced[reduced_count++];
+            red->iv = v;
+            red->factor = strdup(factor);
+            red->recurrence = strdup(name);
+
+            chain_append(&preheader_code, make_binary(IR_MUL, name, ivs[v].name, factor, inst->type));
+            char delta[32];
+            if (factor_const) {
+                snprintf(delta, sizeof(delta), "%ld", factor_value * ivs[v].step);
+            } else {
+                char step[32];
+                char* scaled = new_temp(program);
+                snprintf(step, sizeof(step), "%ld", ivs[v].step);
+                chain_append(&preheader_code, make_binary(IR_MUL, scaled, factor, step, inst->type));
+                snprintf(delta, sizeof(delta), "%s", scaled);
+                free(scaled);
+            }
+            chain_append(&after[ivs[v].update], make_binary(IR_ADD, name, name, delta, inst->type));
+        }
+
+        inst->op = IR_ASSIGN;
+        free(inst->arg1);
+        free(inst->arg2);
+        inst->arg1 = strdup(red->recurrence);
+        inst->arg2 = NULL;
+        rewrites++;
+    }
+
+    // 2. `j` bumped by the same step as `i`, in the same block, stays `d`
+    //    away from it: every read of `j` in the loop becomes `i + d`, with d
+    //    a literal when both entry values are known (else `j - i` in the
+    //    preheader), and the update of `j` goes. Not for the variable the
+    //    exit test reads, one read after the loop, or one read between the
+    //    two updates (where the distance is off by a step).
+    //    `lockstep` marks bases (1) and eliminated variables (2).
+    unsigned char lockstep[MAX_IVS] = { 0 };
+    for (int v = 0; v < iv_count; v++) {
+        BasicIv* iv = &ivs[v];
+        int just_reduced = 0;
+        for (int r = 0; r < reduced_count; r++) {
+            if (reduced[r].iv == v) just_reduced = 1;
+        }
+        if (just_reduced || lockstep[v] || iv->update < cfg->formal_end) continue;
+        if (cfg->insts[iv->update]->type == IR_TYPE_REEL) continue;
+        if (header_test_reads(cfg, &info, loop, iv->name)) continue;
+
+        int base = -1;
+        for (int w = 0; w < iv_count && base < 0; w++) {
+            if (w == v || lockstep[w] == 2 || ivs[w].step != iv->step) continue;
+            if (ivs[w].update < cfg->formal_end || cfg->insts[ivs[w].update]->type == IR_TYPE_REEL) continue;
+            if (cfg->block_of[ivs[w].update] == cfg->block_of[iv->update]) base = w;
+        }
+        if (base < 0 || used_after_loop(cfg, loop, iv->name, -1)) continue;
+        int low = iv->update < ivs[base].update ? iv->update : ivs[base].update;
+        int high = iv->update < ivs[base].update ? ivs[base].update : iv->update;
+        if (used_between(cfg, iv->name, low, high, iv->add)) continue;
+        if (iv->update != iv->add) {
+            const char* carrier = cfg->insts[iv->add]->result;
+            if (uses_in_loop(cfg, loop, carrier, iv->update) > 0) continue;
+            if (used_after_loop(cfg, loop, carrier, -1)) continue;
+        }
+
+        char distance[32];
+        char* base_entry = entry_value(cfg, &info, loop, ivs[base].name);
+        char* entry = entry_value(cfg, &info, loop, iv->name);
+        long base_value = 0, value = 0;
+        int known = base_entry && entry && ir_int_literal(base_entry, &base_value) && ir_int_literal(entry, &value);
+        free(base_entry);
+        free(entry);
+        if (known) {
+            snprintf(distance, sizeof(distance), "%ld", value - base_value);
+        } else {
+            if (insert_before < 0) {
+                insert_before = ir_loop_preheader(program, cfg, loop, &preheader_label);
+                if (insert_before < 0) break;
+            }
+            char* temp = new_temp(program);
+            chain_append(&preheader_code, make_binary(IR_SUB, temp, iv->name, ivs[base].name,
+                                                      cfg->insts[iv->update]->type));
+            snprintf(distance, sizeof(distance), "%s", temp);
+            free(temp);
+        }
+
+        for (int i = 0; i < cfg->inst_count; i++) {
+            if (i == iv->add || i == iv->update || !loop->member[cfg->block_of[i]]) continue;
+            const char* uses[3];
+            int n = ir_inst_uses(cfg->insts[i], uses), reads = 0;
+            for (int u = 0; u < n; u++) {
+                if (strcmp(uses[u], iv->name) == 0) reads = 1;
+            }
+            if (!reads) continue;
+            // Computed just ahead of the read: chained after the instruction
+            // before it, which is in the same block (a read is never a label).
+            char* temp = new_temp(program);
+            chain_append(&after[i - 1], make_binary(IR_ADD, temp, ivs[base].name, distance,
+                                                    cfg->insts[iv->update]->type));
+            replace_use(cfg->insts[i], iv->name, temp);
+            free(temp);
+        }
+        if (iv->update != iv->add) removed[iv->add] = 1;
+        removed[iv->update] = 1;
+        lockstep[v] = 2;
+        lockstep[base] = 1;
+        rewrites++;
+    }
+
+    // 3. Induction variables that nothing reads any more (besides their own
+    //    update) are dead weight: drop the update.
+    //    Skip variables reduced in this round, and lockstep bases: their new
+    //    reads are not in the CFG yet, the next round will see them.
+    for (int v = 0; v < iv_count; v++) {
+        BasicIv* iv = &ivs[v];
+        int just_reduced = 0;
+        for (int r = 0; r < reduced_count; r++) {
+            if (reduced[r].iv == v) just_reduced = 1;
+        }
+        if (just_reduced || lockstep[v] || iv->update < cfg->formal_end) continue;
+        if (uses_in_loop(cfg, loop, iv->name, iv->add) > 0) continue;
+        if (used_after_loop(cfg, loop, iv->name, -1)) continue;
+        if (iv->update != iv->add) {
+            const char* carrier = cfg->insts[iv->add]->result;
+            if (uses_in_loop(cfg, loop, carrier, iv->update) > 0) continue;
+            if (used_after_loop(cfg, loop, carrier, -1)) continue;
+            removed[iv->add] = 1;
+        }
+        removed[iv->update] = 1;
+        rewrites++;
+    }
+
+    if (rewrites > 0) {
+        int extra = 1;
+        for (IrInstruction* p = preheader_code; p; p = p->next) extra++;
+        for (int i = 0; i < cfg->inst_count; i++) {
+            for (IrInstruction* p = after[i]; p; p = p->next) extra++;
+        }
+
+        IrInstruction** order = malloc(sizeof(IrInstruction*) * (size_t)(cfg->inst_count + extra));
+        int count = 0;
+        for (int i = 0; i < cfg->inst_count; i++) {
+            if (i == insert_before) {
+                if (preheader_label) order[count++] = preheader_label;
+                for (IrInstruction* p = preheader_code; p; p = p->next) order[count++] = p;
+            }
+            if (removed[i]) {
+                free_instruction(cfg->insts[i]);
+            } else {
+                order[count++] = cfg->insts[i];
+            }
+            for (IrInstruction* p = after[i]; p; p = p->next) order[count++] = p;
+        }
+        ir_relink(head, order, count);
+        free(order);
+    } else if (preheader_label) {
+        free_instruction(preheader_label);
+    }
+
+    for (int r = 0; r < reduced_count; r++) {
+        free(reduced[r].factor);
+        free(reduced[r].recurrence);
+    }
+    free(after);
+    free(removed);
+    ir_name_map_free(&loop_defs);
+    ir_def_info_free(&info);
+    return rewrites;
+}
+
+// ---------- trip counts ----------
+
+static IrOpType mirror_cmp(IrOpType op) {
+    switch (op) {
+        case IR_LT: return IR_GT;
+        case IR_LE: return IR_GE;
+        case IR_GT: return IR_LT;
+        case IR_GE: return IR_LE;
+        default:    return op;
+    }
+}
+
+// Number of times the body runs for `for (iv = init; iv cmp bound; iv += step)`,
+// or -1 if the loop does not terminate that way.
+static long compute_trip_count(long init, long bound, long step, IrOpType cmp) {
+    switch (cmp) {
+        case IR_LT:
+            if (step <= 0) return -1;
+            return bound > init ? (bound - init + step - 1) / step : 0;
+        case IR_LE:
+            if (step <= 0) return -1;
+            return bound >= init ? (bound - init) / step + 1 : 0;
+        case IR_GT:
+            if (step >= 0) return -1;
+            return init > bound ? (init - bound - step - 1) / -step : 0;
+        case IR_GE:
+            if (step >= 0) return -1;
+            return init >= bound ? (init - bound) / -step + 1 : 0;
+        case IR_NEQ:
+            if ((bound - init) % step != 0 || (bound - init) / step < 0) return -1;
+            return (bound - init) / step;
+        default:
+            return -1;
+    }
+}
+
+// True if `loop` is left only through the header's branch to `exit_target`:
+// no other edge out of it, and no `retourner` in it.
+static int header_is_only_exit(const IrCfg* cfg, const IrLoop* loop, int exit_target) {
+    for (int b = 0; b < cfg->block_count; b++) {
+        if (!loop->member[b]) continue;
+        if (cfg->blocks[b].succ_count == 0) return 0;
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+            int succ = cfg->blocks[b].succs[s];
+            if (!loop->member[succ] && !(b == loop->header && succ == exit_target)) return 0;
+        }
+    }
+    return 1;
+}
+
+static IrLoopHint* analyse_loop(const IrCfg* cfg, const IrDefInfo* info, const IrLoop* loop) {
+    const IrBlock* header = &cfg->blocks[loop->header];
+    IrInstruction* label = cfg->insts[header->start];
+    IrInstruction* exit = cfg->insts[header->end];
+    if (label->op != IR_LABEL || exit->op != IR_IF_GOTO) return NULL;
+    int exit_target = ir_cfg_block_of_label(cfg, exit->label);
+    if (exit_target < 0 || loop->member[exit_target]) return NULL;
+
+    // `if !c goto exit` with c = iv cmp bound.
+    if (ir_name_map_get(&info->defs, exit->arg1, 0) != 1) return NULL;
+    IrInstruction* test = cfg->insts[ir_name_map_get(&info->def_site, exit->arg1, 0)];
+    if (test->op < IR_EQ || test->op > IR_GE) return NULL;
+
+    IrNameMap loop_defs;
+    count_loop_defs(cfg, loop, &loop_defs);
+    BasicIv ivs[MAX_IVS];
+    int iv_count = find_basic_ivs(cfg, info, loop, &loop_defs, ivs);
+
+    IrOpType cmp = test->op;
+    int v = find_iv(ivs, iv_count, test->arg1);
+    const char* bound = test->arg2;
+    if (v < 0) {
+        v = find_iv(ivs, iv_count, test->arg2);
+        bound = test->arg1;
+        cmp = mirror_cmp(cmp);
+    }
+    IrLoopHint* hint = NULL;
+    if (v >= 0 && cmp != IR_EQ && is_invariant(&loop_defs, bound)) {
+        // The update must run on every iteration for the step to be exact.
+        int every_iteration = 1;
+        for (int b = 0; b < cfg->block_count; b++) {
+            if (!loop->member[b]) continue;
+            for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+                if (cfg->blocks[b].succs[s] == loop->header &&
+                    !ir_cfg_dominates(cfg, cfg->block_of[ivs[v].update], b)) {
+                    every_iteration = 0;
+                }
+            }
+        }
+
+        if (every_iteration) {
+            hint = calloc(1, sizeof(IrLoopHint));
+            hint->header = strdup(label->label);
+            hint->iv = strdup(ivs[v].name);
+            hint->step = ivs[v].step;
+            hint->cmp = cmp;
+            hint->init = entry_value(cfg, info, loop, ivs[v].name);
+            hint->trip_count = -1;
+
+            long bound_value = 0, init_value = 0;
+            char buf[32];
+            if (ir_resolve_int_constant(cfg, info, bound, &bound_value)) {
+                snprintf(buf, sizeof(buf), "%ld", bound_value);
+                hint->bound = strdup(buf);
+                if (hint->init && ir_int_literal(hint->init, &init_value) &&
+                    header_is_only_exit(cfg, loop, exit_target)) {
+                    hint->trip_count = compute_trip_count(init_value, bound_value, hint->step, cmp);
+                }
+            } else {
+                hint->bound = strdup(bound);
+            }
+        }
+    }
+    ir_name_map_free(&loop_defs);
+    return hint;
+}
+
+static IrLoopHint* collect_hints(IrInstruction* head, int formal_count) {
+    IrCfg* cfg = ir_cfg_build(head, formal_count);
+    if (!cfg) return NULL;
+    ir_cfg_find_loops(cfg);
+    IrDefInfo info;
+    ir_def_info_build(&info, cfg);
+
+    // Report loops in source order.
+    IrLoopHint* hints = NULL;
+    IrLoopHint** tail = &hints;
+    for (int b = 0; b < cfg->block_count; b++) {
+        for (int l = 0; l < cfg->loop_count; l++) {
+            if (cfg->loops[l].header != b) continue;
+            IrLoopHint* hint = analyse_loop(cfg, &info, &cfg->loops[l]);
+            if (hint) {
+                *tail = hint;
+                tail = &hint->next;
+            }
+        }
+    }
+
+    ir_def_info_free(&info);
+    ir_cfg_free(cfg);
+    return hints;
+}
+
+static int indvars_body(IRProgram* program, IrInstruction** head, int formal_count, IrLoopHint** hints) {
+    int total = 0;
+    for (;;) {
+        IrCfg* cfg = ir_cfg_build(*head, formal_count);
+        if (!cfg) break;
+        ir_cfg_find_loops(cfg);
+        int rewrites = 0;
+        for (int l = 0; l < cfg->loop_count && rewrites == 0; l++) {
+            rewrites = reduce_loop(program, head, cfg, &cfg->loops[l]);
+        }
+        ir_cfg_free(cfg);
+        if (rewrites == 0) break;
+        total += rewrites;
+    }
+
+    ir_free_loop_hints(*hints);
+    *hints = collect_hints(*head, formal_count);
+    return total;
+}
+
+int ir_indvars(IRProgram* program) {
+    if (!program) return 0;
+    int total = indvars_body(program, &program->global_instructions, 0, &program->global_loop_hints);
+    for (IrFunction* func = program->functions; func; func = func->next) {
+        total += indvars_body(program, &func->instructions, func->param_count, &func->loop_hints);
+    }
+    return total;
+}
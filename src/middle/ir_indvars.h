@@ -0,0 +1,21 @@
+#ifndef IR_INDVARS_H
+#define IR_INDVARS_H
+
+#include "ir_generator.h"
+
+// Induction-variable analysis and strength reduction.
+// - Recognises basic induction variables (`i = i +/- c`, c constant) of each
+//   natural loop.
+// - Rewrites `t = i * k` (k loop-invariant) into an additive recurrence
+//   initialised in the preheader and bumped next to the update of `i`;
+//   identical products share one recurrence.
+// - Rewrites reads of an induction variable bumped by the same step, in the
+//   same block, as another one as `other + distance`, and deletes its update.
+// - Deletes induction variables whose only remaining use is their own update.
+// - Records an IrLoopHint (step, bounds, trip count when computable) for every
+//   loop whose exit test compares a basic induction variable against an
+//   invariant, replacing the hints of any previous run.
+// Returns the number of rewrites performed.
+int ir_indvars(IRProgram* program);
+
+#endif // IR_INDVARS_H
@@ -0,0 +1,363 @@
+#include "ir_inline.h"
+#include "ir_analysis.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INLINE_BASE_THRESHOLD 20        // callee instructions accepted at a cold call site
+#define INLINE_MAX_THRESHOLD 320        // never inline anything bigger than this
+#define INLINE_LOOP_FREQUENCY 8         // static estimate: iterations per loop entry
+#define INLINE_MAX_CALLER_SIZE 4096     // stop growing a caller past this many instructions
+#define INLINE_MAX_DEPTH 6              // nested inlining through copied bodies
+#define INLINE_MAX_RECURSIVE_DEPTH 2    // levels a recursive callee is unrolled
+#define INLINE_MAX_ARGS 64
+
+typedef struct {
+    IrFunction** functions;
+    IrInstruction** bodies;     // pristine copies: callers are rewritten while callees are cloned
+    int* sizes;
+    int function_count;
+    IrNameMap index;            // function name -> index
+    unsigned char* recursive;   // recursive[i]: function i can reach itself
+} CallGraph;
+
+static int is_formal_param(const IrInstruction* inst, int* formals_left) {
+    if (inst->op == IR_FUNC_BEGIN) return 0;
+    if (inst->op == IR_PARAM && *formals_left > 0) {
+        (*formals_left)--;
+        return 1;
+    }
+    *formals_left = 0;
+    return 0;
+}
+
+static char* dup_or_null(const char* s) {
+    return s ? strdup(s) : NULL;
+}
+
+static IrInstruction* copy_list(const IrInstruction* list) {
+    IrInstruction* head = NULL;
+    IrInstruction** tail = &head;
+    for (const IrInstruction* src = list; src; src = src->next) {
+        IrInstruction* copy = create_instruction(src->op);
+        copy->result = dup_or_null(src->result);
+        copy->arg1 = dup_or_null(src->arg1);
+        copy->arg2 = dup_or_null(src->arg2);
+        copy->label = dup_or_null(src->label);
+        copy->line = src->line;
+        copy->type = src->type;
+        *tail = copy;
+        tail = &copy->next;
+    }
+    return head;
+}
+
+// Instructions a copy of `body` adds to its caller (prologue/epilogue excluded).
+static int body_size(const IrInstruction* body, int param_count) {
+    int size = 0, formals_left = param_count;
+    for (const IrInstruction* inst = body; inst; inst = inst->next) {
+        if (inst->op == IR_FUNC_BEGIN || inst->op == IR_FUNC_END) continue;
+        if (is_formal_param(inst, &formals_left)) continue;
+        size++;
+    }
+    return size;
+}
+
+static void call_graph_build(CallGraph* graph, IRProgram* program) {
+    graph->function_count = 0;
+    for (IrFunction* f = program->functions; f; f = f->next) graph->function_count++;
+    graph->functions = malloc(sizeof(IrFunction*) * (size_t)(graph->function_count + 1));
+    graph->bodies = malloc(sizeof(IrInstruction*) * (size_t)(graph->function_count + 1));
+    graph->sizes = malloc(sizeof(int) * (size_t)(graph->function_count + 1));
+    graph->recursive = calloc((size_t)graph->function_count + 1, 1);
+    ir_name_map_init(&graph->index, graph->function_count);
+
+    int i = 0;
+    for (IrFunction* f = program->functions; f; f = f->next, i++) {
+        graph->functions[i] = f;
+        graph->bodies[i] = copy_list(f->instructions);
+        graph->sizes[i] = body_size(f->instructions, f->param_count);
+        ir_name_map_set(&graph->index, f->name, i);
+    }
+
+    // A function is recursive if a DFS over its callees comes back to it.
+    int n = graph->function_count;
+    unsigned char* seen = malloc((size_t)n + 1);
+    int* work = malloc(sizeof(int) * (size_t)(n + 1));
+    for (int root = 0; root < n; root++) {
+        memset(seen, 0, (size_t)n + 1);
+        int top = 0;
+        work[top++] = root;
+        while (top > 0 && !graph->recursive[root]) {
+            IrFunction* f = graph->functions[work[--top]];
+            for (IrInstruction* inst = f->instructions; inst; inst = inst->next) {
+                if (inst->op != IR_CALL) continue;
+                int callee = ir_name_map_get(&graph->index, inst->arg1, -1);
+                if (callee < 0) continue;
+                if (callee == root) graph->recursive[root] = 1;
+                if (!seen[callee]) {
+                    seen[callee] = 1;
+                    work[top++] = callee;
+                }
+            }
+        }
+    }
+    free(seen);
+    free(work);
+}
+
+static void call_graph_free(CallGraph* graph) {
+    for (int i = 0; i < graph->function_count; i++) free_instruction_list(graph->bodies[i]);
+    free(graph->functions);
+    free(graph->bodies);
+    free(graph->sizes);
+    free(graph->recursive);
+    ir_name_map_free(&graph->index);
+}
+
+// Static frequency estimate of a call site nested `depth` loops deep.
+static long site_frequency(int depth) {
+    long frequency = 1;
+    for (int d = 0; d < depth && frequency < INLINE_MAX_THRESHOLD; d++) frequency *= INLINE_LOOP_FREQUENCY;
+    return frequency;
+}
+
+static int should_inline(int callee_size, long frequency) {
+    long threshold = INLINE_BASE_THRESHOLD * frequency;
+    if (threshold > INLINE_MAX_THRESHOLD) threshold = INLINE_MAX_THRESHOLD;
+    return callee_size <= threshold;
+}
+
+// ---------- body cloning ----------
+
+typedef struct {
+    IRProgram* program;
+    IrNameMap names;    // callee name -> index into `fresh`
+    IrNameMap labels;   // callee label -> index into `fresh`
+    char** fresh;
+    int fresh_count;
+    int fresh_capacity;
+} Renamer;
+
+static const char* renamed(Renamer* r, IrNameMap* map, const char* name, int is_label) {
+    int* slot = ir_name_map_slot(map, name);
+    if (*slot == 0) {
+        if (r->fresh_count >= r->fresh_capacity) {
+            r->fresh_capacity = r->fresh_capacity ? r->fresh_capacity * 2 : 16;
+            r->fresh = realloc(r->fresh, sizeof(char*) * (size_t)r->fresh_capacity);
+        }
+        r->fresh[r->fresh_count++] = is_label ? new_label(r->program) : new_temp(r->program);
+        *slot = r->fresh_count; // stored 1-based so 0 means "absent"
+    }
+    return r->fresh[*slot - 1];
+}
+
+static char* rename_operand(Renamer* r, const char* name) {
+    if (!name) return NULL;
+    if (ir_is_literal(name)) return strdup(name);
+    return strdup(renamed(r, &r->names, name, 0));
+}
+
+static char* rename_label(Renamer* r, const char* label) {
+    return label ? strdup(renamed(r, &r->labels, label, 1)) : NULL;
+}
+
+static void chain_push(IrInstruction*** tail, IrInstruction* inst) {
+    **tail = inst;
+    *tail = &inst->next;
+}
+
+static IrInstruction* make_assign(const char* result, char* value, IrType type) {
+    IrInstruction* inst = create_instruction(IR_ASSIGN);
+    inst->result = strdup(result);
+    inst->arg1 = value;
+    inst->type = type;
+    return inst;
+}
+
+// Value returned when control falls off the end or hits a bare `return`.
+static char* zero_of(IrType type) {
+    return strdup(type == IR_TYPE_REEL ? "0.0" : "0");
+}
+
+// Builds a renamed copy of `callee`'s body that leaves its return value in
+// `result`, and turns the call's IR_PARAMs into assignments to the renamed
+// formals. Returns the chain; *chain_tail receives its last instruction.
+static IrInstruction* clone_body(IRProgram* program, IrFunction* callee, const IrInstruction* body, const char* result,
+                                 IrInstruction** params, IrInstruction** chain_tail) {
+    Renamer r = { program, {0}, {0}, NULL, 0, 0 };
+    ir_name_map_init(&r.names, 32);
+    ir_name_map_init(&r.labels, 8);
+
+    for (int i = 0; i < callee->param_count; i++) {
+        IrInstruction* p = params[i];
+        p->op = IR_ASSIGN;
+        p->result = strdup(renamed(&r, &r.names, callee->params[i], 0));
+        p->type = callee->param_types ? callee->param_types[i] : IR_TYPE_UNKNOWN;
+    }
+
+    IrInstruction* head = NULL;
+    IrInstruction** tail = &head;
+    IrInstruction* last = NULL;
+    int needs_end = 0, falls_off = 1;
+    char* end_label = new_label(program);
+
+    int formals_left = callee->param_count;
+    for (const IrInstruction* src = body; src; src = src->next) {
+        if (src->op == IR_FUNC_BEGIN || src->op == IR_FUNC_END) continue;
+        if (is_formal_param(src, &formals_left)) continue;
+        int is_last = !src->next || src->next->op == IR_FUNC_END;
+
+        if (src->op == IR_RETURN) {
+            chain_push(&tail, make_assign(result, src->arg1 ? rename_operand(&r, src->arg1) : zero_of(callee->return_type),
+                                          callee->return_type));
+            if (!is_last) {
+                IrInstruction* jump = create_instruction(IR_GOTO);
+                jump->label = strdup(end_label);
+                jump->line = src->line;
+                chain_push(&tail, jump);
+                needs_end = 1;
+            } else {
+                falls_off = 0;
+            }
+            continue;
+        }
+
+        IrInstruction* copy = create_instruction(src->op);
+        copy->line = src->line;
+        copy->type = src->type;
+        switch (src->op) {
+            case IR_LABEL:
+            case IR_GOTO:
+                copy->label = rename_label(&r, src->label);
+                break;
+            case IR_IF_GOTO:
+                copy->arg1 = rename_operand(&r, src->arg1);
+                copy->label = rename_label(&r, src->label);
+                break;
+            case IR_CALL:
+                copy->result = rename_operand(&r, src->result);
+                copy->arg1 = strdup(src->arg1);
+                copy->arg2 = src->arg2 ? strdup(src->arg2) : NULL;
+                break;
+            default:
+                copy->result = rename_operand(&r, src->result);
+                copy->arg1 = rename_operand(&r, src->arg1);
+                copy->arg2 = rename_operand(&r, src->arg2);
+                break;
+        }
+        chain_push(&tail, copy);
+        if (is_last && (src->op == IR_GOTO)) falls_off = 0;
+    }
+
+    // Falling off the end of a function returns 0 (same as emit_function).
+    if (falls_off) chain_push(&tail, make_assign(result, zero_of(callee->return_type), callee->return_type));
+    if (needs_end) {
+        IrInstruction* label = create_instruction(IR_LABEL);
+        label->label = end_label;
+        chain_push(&tail, label);
+    } else {
+        free(end_label);
+    }
+
+    for (IrInstruction* inst = head; inst; inst = inst->next) last = inst;
+    *chain_tail = last;
+
+    for (int i = 0; i < r.fresh_count; i++) free(r.fresh[i]);
+    free(r.fresh);
+    ir_name_map_free(&r.names);
+    ir_name_map_free(&r.labels);
+    return head;
+}
+
+// ---------- driver ----------
+
+typedef struct {
+    IrInstruction* resume;  // first instruction after the spliced copy
+    long frequency;         // frequency of the call site the copy replaced
+} Splice;
+
+static int inline_into(IRProgram* program, CallGraph* graph, IrInstruction** head, int formal_count) {
+    IrCfg* cfg = ir_cfg_build(*head, formal_count);
+    if (!cfg) return 0;
+    ir_cfg_find_loops(cfg);
+    int* depth = calloc((size_t)cfg->block_count + 1, sizeof(int));
+    for (int l = 0; l < cfg->loop_count; l++) {
+        for (int b = 0; b < cfg->block_count; b++) {
+            if (cfg->loops[l].member[b]) depth[b]++;
+        }
+    }
+
+    int capacity = cfg->inst_count + 16;
+    IrInstruction** out = malloc(sizeof(IrInstruction*) * (size_t)capacity);
+    int count = 0;
+    Splice stack[INLINE_MAX_DEPTH + 1];
+    int sp = 0;
+    int original = 0;
+    int caller_size = cfg->inst_count;
+    int inlined = 0;
+    int params[INLINE_MAX_ARGS];
+    IrInstruction* param_insts[INLINE_MAX_ARGS];
+
+    IrInstruction* cur = *head;
+    while (cur) {
+        while (sp > 0 && stack[sp - 1].resume == cur) sp--;
+        long frequency = sp > 0 ? stack[sp - 1].frequency
+                                : site_frequency(depth[cfg->block_of[original]]);
+        if (sp == 0) original++;
+        IrInstruction* next = cur->next;
+
+        if (count + 1 >= capacity) {
+            capacity *= 2;
+            out = realloc(out, sizeof(IrInstruction*) * (size_t)capacity);
+        }
+
+        int callee_index = cur->op == IR_CALL ? ir_name_map_get(&graph->index, cur->arg1, -1) : -1;
+        if (callee_index >= 0) {
+            IrFunction* callee = graph->functions[callee_index];
+            int limit = graph->recursive[callee_index] ? INLINE_MAX_RECURSIVE_DEPTH : INLINE_MAX_DEPTH;
+            int size = graph->sizes[callee_index];
+            out[count] = cur;
+            if (sp < limit && should_inline(size, frequency) &&
+                caller_size + size <= INLINE_MAX_CALLER_SIZE &&
+                ir_call_params(out, count, params, INLINE_MAX_ARGS) == callee->param_count) {
+                for (int i = 0; i < callee->param_count; i++) param_insts[i] = out[params[i]];
+
+                IrInstruction* tail = NULL;
+                IrInstruction* copy = clone_body(program, callee, graph->bodies[callee_index], cur->result, param_insts, &tail);
+                tail->next = next;
+                stack[sp].resume = next;
+                stack[sp].frequency = frequency;
+                sp++;
+                free_instruction(cur);
+                caller_size += size;
+                inlined++;
+                cur = copy;
+                continue;
+            }
+        }
+
+        out[count++] = cur;
+        cur = next;
+    }
+
+    ir_relink(head, out, count);
+    free(out);
+    free(depth);
+    ir_cfg_free(cfg);
+    return inlined;
+}
+
+int ir_inline(IRProgram* program) {
+    if (!program || !program->functions) return 0;
+    CallGraph graph;
+    call_graph_build(&graph, program);
+
+    int total = inline_into(program, &graph, &program->global_instructions, 0);
+    for (IrFunction* func = program->functions; func; func = func->next) {
+        total += inline_into(program, &graph, &func->instructions, func->param_count);
+    }
+
+    call_graph_free(&graph);
+    return total;
+}
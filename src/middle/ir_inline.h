@@ -0,0 +1,16 @@
+#ifndef IR_INLINE_H
+#define IR_INLINE_H
+
+#include "ir_generator.h"
+
+// Function inliner.
+// Replaces `param ...; t = call f` with a renamed copy of f's body when the
+// cost model accepts it: a callee is inlined if its instruction count fits a
+// threshold that grows with the estimated frequency of the call site (loop
+// nesting depth). Formals, locals and temporaries of the copy get fresh names
+// from new_temp(), labels from new_label(). Recursive callees are expanded at
+// most a bounded number of levels. Callee definitions are kept.
+// Returns the number of call sites inlined.
+int ir_inline(IRProgram* program);
+
+#endif // IR_INLINE_H
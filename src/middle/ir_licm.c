@@ -0,0 +1,118 @@
+#include "ir_licm.h"
+#include "ir_analysis.h"
+
+#include <stdlib.h>
+
+static int is_hoistable(IrCfg* cfg, IrDefInfo* info, IrNameMap* loop_defs,
+                        const unsigned char* invariant, int i) {
+    IrInstruction* inst = cfg->insts[i];
+    if (!ir_op_is_pure(inst->op)) {
+        // Division only when the divisor is a known constant other than 0
+        // and -1 (INT_MIN / -1 overflows): hoisting must never introduce a
+        // trap on a path that did not execute it.
+        long divisor = 0;
+        if (inst->op != IR_DIV && inst->op != IR_MOD) return 0;
+        if (!ir_resolve_int_constant(cfg, info, inst->arg2, &divisor) || divisor == 0 || divisor == -1) return 0;
+    }
+    // The result must be a single-definition name (a temporary): moving it
+    // cannot then clobber a value another path expects.
+    if (!inst->result || ir_name_map_get(&info->defs, inst->result, 0) != 1) return 0;
+
+    const char* uses[3];
+    int use_count = ir_inst_uses(inst, uses);
+    for (int u = 0; u < use_count; u++) {
+        if (ir_name_map_get(loop_defs, uses[u], 0) == 0) continue;
+        if (ir_name_map_get(&info->defs, uses[u], 0) != 1) return 0;
+        if (!invariant[ir_name_map_get(&info->def_site, uses[u], 0)]) return 0;
+    }
+    return 1;
+}
+
+// Hoists the invariant instructions of one loop. Returns how many were moved
+// (0 means the list was left untouched).
+static int hoist_loop(IRProgram* program, IrInstruction** head, IrCfg* cfg, IrLoop* loop) {
+    IrDefInfo info;
+    ir_def_info_build(&info, cfg);
+    IrNameMap loop_defs;
+    ir_name_map_init(&loop_defs, 16);
+    for (int i = 0; i < cfg->inst_count; i++) {
+        if (!loop->member[cfg->block_of[i]]) continue;
+        const char* def = ir_inst_def(cfg->insts[i]);
+        if (def) (*ir_name_map_slot(&loop_defs, def))++;
+    }
+
+    unsigned char* invariant = calloc((size_t)cfg->inst_count, 1);
+    int* hoisted = malloc(sizeof(int) * (size_t)cfg->inst_count);
+    int hoisted_count = 0;
+
+    // Fixpoint: an instruction becomes invariant once all its operands are.
+    // Recording discovery order keeps definitions ahead of their uses.
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < cfg->inst_count; i++) {
+            if (!loop->member[cfg->block_of[i]] || invariant[i]) continue;
+            if (!is_hoistable(cfg, &info, &loop_defs, invariant, i)) continue;
+            invariant[i] = 1;
+            hoisted[hoisted_count++] = i;
+            changed = 1;
+        }
+    }
+
+    int insert_before = -1;
+    IrInstruction* preheader_label = NULL;
+    if (hoisted_count > 0) {
+        insert_before = ir_loop_preheader(program, cfg, loop, &preheader_label);
+        if (insert_before < 0) hoisted_count = 0;
+    }
+
+    if (hoisted_count > 0) {
+        IrInstruction** order = malloc(sizeof(IrInstruction*) * (size_t)(cfg->inst_count + 1));
+        int count = 0;
+        for (int i = 0; i < cfg->inst_count; i++) {
+            if (i == insert_before) {
+                if (preheader_label) order[count++] = preheader_label;
+                for (int h = 0; h < hoisted_count; h++) order[count++] = cfg->insts[hoisted[h]];
+            }
+            if (invariant[i]) continue;
+            order[count++] = cfg->insts[i];
+        }
+        ir_relink(head, order, count);
+        free(order);
+    }
+
+    free(invariant);
+    free(hoisted);
+    ir_name_map_free(&loop_defs);
+    ir_def_info_free(&info);
+    return hoisted_count;
+}
+
+static int licm_body(IRProgram* program, IrInstruction** head, int formal_count) {
+    int total = 0;
+    for (;;) {
+        IrCfg* cfg = ir_cfg_build(*head, formal_count);
+        if (!cfg) break;
+        ir_cfg_find_loops(cfg);
+
+        // Innermost loops first; rebuild the CFG after every change so outer
+        // loops see the freshly created preheaders.
+        int hoisted = 0;
+        for (int l = 0; l < cfg->loop_count && hoisted == 0; l++) {
+            hoisted = hoist_loop(program, head, cfg, &cfg->loops[l]);
+        }
+        ir_cfg_free(cfg);
+        if (hoisted == 0) break;
+        total += hoisted;
+    }
+    return total;
+}
+
+int ir_licm(IRProgram* program) {
+    if (!program) return 0;
+    int total = licm_body(program, &program->global_instructions, 0);
+    for (IrFunction* func = program->functions; func; func = func->next) {
+        total += licm_body(program, &func->instructions, func->param_count);
+    }
+    return total;
+}
@@ -0,0 +1,13 @@
+#ifndef IR_LICM_H
+#define IR_LICM_H
+
+#include "ir_generator.h"
+
+// Loop-invariant code motion.
+// Hoists side-effect-free computations whose operands do not change inside a
+// natural loop into the loop's preheader (created on demand). Runs over every
+// function body and over the global instructions.
+// Returns the number of instructions hoisted.
+int ir_licm(IRProgram* program);
+
+#endif // IR_LICM_H
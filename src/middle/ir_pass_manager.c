@@ -0,0 +1,156 @@
+#include "ir_pass_manager.h"
+#include "ir_analysis.h"
+#include "ir_verify.h"
+#include "ir_tailcall.h"
+#include "ir_inline.h"
+#include "ir_licm.h"
+#include "ir_indvars.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ---------- registry ----------
+
+static const IrPass passes[] = {
+    { "tailcall", "self tail calls become jumps to the function entry", ir_tailcall },
+    { "inline",   "inline small callees (threshold scaled by loop depth)", ir_inline },
+    { "licm",     "hoist loop-invariant computations into preheaders", ir_licm },
+    { "indvars",  "strength-reduce induction variables, compute trip counts", ir_indvars },
+};
+
+#define PASS_COUNT ((int)(sizeof(passes) / sizeof(passes[0])))
+
+// Default pipelines. Tail calls become loops before the inliner could unroll
+// them; inlining comes next so the loop passes see through call sites.
+static const char* const level_pipelines[] = {
+    "",                                 // -O0
+    "tailcall,licm",                    // -O1
+    "tailcall,inline,licm,indvars",     // -O2
+};
+
+const IrPass* ir_pass_lookup(const char* name) {
+    for (int i = 0; i < PASS_COUNT; i++) {
+        if (strcmp(passes[i].name, name) == 0) return &passes[i];
+    }
+    return NULL;
+}
+
+void ir_pass_list(FILE* out) {
+    for (int i = 0; i < PASS_COUNT; i++) {
+        fprintf(out, "  %-10s %s\n", passes[i].name, passes[i].description);
+    }
+}
+
+// ---------- scheduling ----------
+
+void ir_pass_manager_init(IrPassManager* pm) {
+    pm->records = NULL;
+    pm->count = 0;
+    pm->capacity = 0;
+    pm->verify = 0;
+}
+
+void ir_pass_manager_free(IrPassManager* pm) {
+    free(pm->records);
+    ir_pass_manager_init(pm);
+}
+
+static void schedule(IrPassManager* pm, const IrPass* pass) {
+    if (pm->count >= pm->capacity) {
+        pm->capacity = pm->capacity ? pm->capacity * 2 : 8;
+        pm->records = realloc(pm->records, sizeof(IrPassRecord) * (size_t)pm->capacity);
+    }
+    IrPassRecord* rec = &pm->records[pm->count++];
+    memset(rec, 0, sizeof(*rec));
+    rec->pass = pass;
+}
+
+int ir_pass_manager_add(IrPassManager* pm, const char* name) {
+    const IrPass* pass = ir_pass_lookup(name);
+    if (!pass) return -1;
+    schedule(pm, pass);
+    return 0;
+}
+
+int ir_pass_check_list(const char* list) {
+    char* copy = strdup(list);
+    int rc = 0;
+    for (char* name = strtok(copy, ","); name; name = strtok(NULL, ",")) {
+        if (!ir_pass_lookup(name)) {
+            fprintf(stderr, "unknown pass '%s'; available passes:\n", name);
+            ir_pass_list(stderr);
+            rc = -1;
+            break;
+        }
+    }
+    free(copy);
+    return rc;
+}
+
+int ir_pass_manager_add_list(IrPassManager* pm, const char* list) {
+    // Validate every name first so a typo leaves the pipeline untouched.
+    if (ir_pass_check_list(list) != 0) return -1;
+
+    char* copy = strdup(list);
+    for (char* name = strtok(copy, ","); name; name = strtok(NULL, ",")) {
+        ir_pass_manager_add(pm, name);
+    }
+    free(copy);
+    return 0;
+}
+
+void ir_pass_manager_add_level(IrPassManager* pm, int level) {
+    int max_level = (int)(sizeof(level_pipelines) / sizeof(level_pipelines[0])) - 1;
+    if (level < 0) level = 0;
+    if (level > max_level) level = max_level;
+    ir_pass_manager_add_list(pm, level_pipelines[level]);
+}
+
+// ---------- execution ----------
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int program_size(const IRProgram* program) {
+    int size = ir_count_instructions(program->global_instructions);
+    for (const IrFunction* func = program->functions; func; func = func->next) {
+        size += ir_count_instructions(func->instructions);
+    }
+    return size;
+}
+
+int ir_pass_manager_run(IrPassManager* pm, IRProgram* program) {
+    if (pm->verify && ir_verify(program, "input") > 0) return -1;
+
+    for (int i = 0; i < pm->count; i++) {
+        IrPassRecord* rec = &pm->records[i];
+        rec->insts_before = program_size(program);
+        double start = now_seconds();
+        rec->changes = rec->pass->run(program);
+        rec->seconds = now_seconds() - start;
+        rec->insts_after = program_size(program);
+
+        if (pm->verify && ir_verify(program, rec->pass->name) > 0) {
+            fprintf(stderr, "IR verification failed after pass '%s'\n", rec->pass->name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void ir_pass_manager_report(const IrPassManager* pm, FILE* out) {
+    fprintf(out, "=== IR pass statistics ===\n");
+    fprintf(out, "%-10s %10s %8s %8s %7s %8s\n", "pass", "time (ms)", "before", "after", "delta", "changes");
+    double total = 0.0;
+    for (int i = 0; i < pm->count; i++) {
+        const IrPassRecord* rec = &pm->records[i];
+        total += rec->seconds;
+        fprintf(out, "%-10s %10.3f %8d %8d %+7d %8d\n", rec->pass->name, rec->seconds * 1e3,
+                rec->insts_before, rec->insts_after, rec->insts_after - rec->insts_before, rec->changes);
+    }
+    fprintf(out, "%-10s %10.3f\n", "total", total * 1e3);
+}
@@ -0,0 +1,63 @@
+#ifndef IR_PASS_MANAGER_H
+#define IR_PASS_MANAGER_H
+
+#include <stdio.h>
+
+#include "ir_generator.h"
+
+// Named IR passes and the pipelines built from them.
+//
+// A pass rewrites an IRProgram in place and returns how many changes it made.
+// Pipelines are either the defaults for an optimisation level (-O0/-O1/-O2)
+// or an explicit comma-separated list (`--passes=tailcall,licm`).
+
+typedef int (*IrPassFn)(IRProgram* program);
+
+typedef struct {
+    const char* name;
+    const char* description;
+    IrPassFn run;
+} IrPass;
+
+// What one scheduled pass did during the last run.
+typedef struct {
+    const IrPass* pass;
+    double seconds;         // wall time
+    int insts_before;       // instruction count over all bodies
+    int insts_after;
+    int changes;            // the pass's return value
+} IrPassRecord;
+
+typedef struct {
+    IrPassRecord* records;  // scheduled passes, in execution order
+    int count;
+    int capacity;
+    int verify;             // run ir_verify() on the input and after every pass
+} IrPassManager;
+
+void ir_pass_manager_init(IrPassManager* pm);
+void ir_pass_manager_free(IrPassManager* pm);
+
+// Registered pass by name, or NULL.
+const IrPass* ir_pass_lookup(const char* name);
+// Lists the registered passes (name and description) on `out`.
+void ir_pass_list(FILE* out);
+
+// Returns 0 if every name of a comma-separated list is registered, or -1
+// (with a message listing the available passes on stderr).
+int ir_pass_check_list(const char* list);
+// Appends one pass. Returns 0, or -1 if `name` is not registered.
+int ir_pass_manager_add(IrPassManager* pm, const char* name);
+// Appends the passes of a comma-separated list. Returns 0, or -1 (with a
+// message on stderr) if a name is unknown; nothing is appended in that case.
+int ir_pass_manager_add_list(IrPassManager* pm, const char* list);
+// Appends the default pipeline of -O`level`.
+void ir_pass_manager_add_level(IrPassManager* pm, int level);
+
+// Runs the scheduled passes in order, filling their records. Returns 0, or -1
+// if verification is on and the IR is found broken (the run stops there).
+int ir_pass_manager_run(IrPassManager* pm, IRProgram* program);
+// Per-pass time, instruction counts and changes of the last run.
+void ir_pass_manager_report(const IrPassManager* pm, FILE* out);
+
+#endif // IR_PASS_MANAGER_H
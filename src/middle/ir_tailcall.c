@@ -0,0 +1,98 @@
+#include "ir_tailcall.h"
+#include "ir_analysis.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TAILCALL_MAX_ARGS 64
+
+// True if insts[i] is a call to `name` whose result is returned right away.
+static int is_self_tail_call(IrCfg* cfg, int i, const char* name) {
+    IrInstruction* call = cfg->insts[i];
+    if (call->op != IR_CALL || !call->result || strcmp(call->arg1, name) != 0) return 0;
+    if (i + 1 >= cfg->inst_count) return 0;
+    IrInstruction* ret = cfg->insts[i + 1];
+    return ret->op == IR_RETURN && ret->arg1 && strcmp(ret->arg1, call->result) == 0;
+}
+
+static int tailcall_function(IRProgram* program, IrFunction* func) {
+    IrCfg* cfg = ir_cfg_build(func->instructions, func->param_count);
+    if (!cfg) return 0;
+
+    int capacity = cfg->inst_count + 2;
+    IrInstruction** out = malloc(sizeof(IrInstruction*) * (size_t)capacity);
+    int count = 0;
+    int rewritten = 0;
+    char* entry = NULL;
+    int params[TAILCALL_MAX_ARGS];
+
+    for (int i = 0; i < cfg->inst_count; i++) {
+        IrInstruction* inst = cfg->insts[i];
+        if (!is_self_tail_call(cfg, i, func->name) ||
+            ir_call_params(cfg->insts, i, params, TAILCALL_MAX_ARGS) != func->param_count) {
+            if (count >= capacity) {
+                capacity *= 2;
+                out = realloc(out, sizeof(IrInstruction*) * (size_t)capacity);
+            }
+            out[count++] = inst;
+            continue;
+        }
+
+        if (!entry) entry = new_label(program);
+        capacity += func->param_count + 1;
+        out = realloc(out, sizeof(IrInstruction*) * (size_t)capacity);
+
+        // `param x_i` becomes `a_i = x_i`: the arguments are all evaluated
+        // before any formal is overwritten.
+        char* fresh[TAILCALL_MAX_ARGS];
+        for (int p = 0; p < func->param_count; p++) {
+            IrInstruction* param = cfg->insts[params[p]];
+            fresh[p] = new_temp(program);
+            param->op = IR_ASSIGN;
+            param->result = strdup(fresh[p]);
+            param->type = func->param_types ? func->param_types[p] : IR_TYPE_UNKNOWN;
+        }
+        for (int p = 0; p < func->param_count; p++) {
+            IrInstruction* assign = create_instruction(IR_ASSIGN);
+            assign->result = strdup(func->params[p]);
+            assign->arg1 = fresh[p];
+            assign->type = func->param_types ? func->param_types[p] : IR_TYPE_UNKNOWN;
+            assign->line = inst->line;
+            out[count++] = assign;
+        }
+        IrInstruction* jump = create_instruction(IR_GOTO);
+        jump->label = strdup(entry);
+        jump->line = inst->line;
+        out[count++] = jump;
+
+        free_instruction(cfg->insts[i + 1]);
+        free_instruction(inst);
+        i++;
+        rewritten++;
+    }
+
+    if (rewritten) {
+        // The entry label goes right after the formal parameter declarations.
+        IrInstruction* label = create_instruction(IR_LABEL);
+        label->label = entry;
+        out = realloc(out, sizeof(IrInstruction*) * (size_t)(count + 1));
+        memmove(out + cfg->formal_end + 1, out + cfg->formal_end,
+                sizeof(IrInstruction*) * (size_t)(count - cfg->formal_end));
+        out[cfg->formal_end] = label;
+        count++;
+        ir_relink(&func->instructions, out, count);
+    }
+
+    free(out);
+    ir_cfg_free(cfg);
+    return rewritten;
+}
+
+int ir_tailcall(IRProgram* program) {
+    if (!program) return 0;
+    int total = 0;
+    for (IrFunction* func = program->functions; func; func = func->next) {
+        total += tailcall_function(program, func);
+    }
+    return total;
+}
@@ -0,0 +1,15 @@
+#ifndef IR_TAILCALL_H
+#define IR_TAILCALL_H
+
+#include "ir_generator.h"
+
+// Tail-call elimination for self-recursive functions.
+// A call to the enclosing function whose result is returned immediately
+// (`t = call f; return t`) is rewritten into a reassignment of the formals
+// (through fresh temporaries, so `pgcd(b, a mod b)` reads the old values)
+// followed by a jump to an entry label placed after the formal IR_PARAMs.
+// The recursion becomes a loop and runs in constant stack space.
+// Returns the number of calls rewritten.
+int ir_tailcall(IRProgram* program);
+
+#endif // IR_TAILCALL_H
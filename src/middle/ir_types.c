@@ -0,0 +1,416 @@
+#include "ir_types.h"
+#include "ir_analysis.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TYPES_MAX_ROUNDS 32
+#define TYPES_MAX_ARGS 64
+
+typedef struct {
+    IRProgram* program;
+    IrNameMap function_index;   // function name -> index into `functions`
+    IrFunction** functions;
+    int function_count;
+    int errors;
+} TypeCtx;
+
+// Types of the names of one body.
+typedef struct {
+    IrNameMap types;    // name -> IrType
+    IrNameMap fixed;    // declared names: their type never changes
+    const char* body;   // function name or "global", for messages
+} TypeEnv;
+
+static int is_numeric(IrType t) {
+    return t == IR_TYPE_ENTIER || t == IR_TYPE_REEL;
+}
+
+// Least upper bound; mismatched non-numeric types keep `a` (reported later).
+static IrType join(IrType a, IrType b) {
+    if (a == IR_TYPE_UNKNOWN) return b;
+    if (b == IR_TYPE_UNKNOWN || a == b) return a;
+    if (is_numeric(a) && is_numeric(b)) return IR_TYPE_REEL;
+    return a;
+}
+
+static IrType literal_type(const char* operand) {
+    if (operand[0] == '"') return IR_TYPE_CHAINE;
+    if (strcmp(operand, "true") == 0 || strcmp(operand, "false") == 0) return IR_TYPE_BOOLEEN;
+    if (operand[0] == '\'') return IR_TYPE_ENTIER; // character code
+    return strchr(operand, '.') ? IR_TYPE_REEL : IR_TYPE_ENTIER;
+}
+
+static IrType operand_type(const TypeEnv* env, const char* operand) {
+    if (!operand) return IR_TYPE_UNKNOWN;
+    if (ir_is_literal(operand)) return literal_type(operand);
+    return (IrType)ir_name_map_get(&env->types, operand, IR_TYPE_UNKNOWN);
+}
+
+static IrFunction* find_function(const TypeCtx* ctx, const char* name) {
+    int index = name ? ir_name_map_get(&ctx->function_index, name, -1) : -1;
+    return index >= 0 ? ctx->functions[index] : NULL;
+}
+
+static IrType call_type(const TypeCtx* ctx, const IrInstruction* call) {
+    IrFunction* callee = find_function(ctx, call->arg1);
+    // Builtins (`afficher`: characters printed) and unknown callees return an entier.
+    return callee ? callee->return_type : IR_TYPE_ENTIER;
+}
+
+// Type of the value an instruction computes, from its operands.
+static IrType value_type(const TypeCtx* ctx, const TypeEnv* env, const IrInstruction* inst) {
+    switch (inst->op) {
+        case IR_ASSIGN:
+        case IR_NEG:
+            return operand_type(env, inst->arg1);
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+            return join(operand_type(env, inst->arg1), operand_type(env, inst->arg2));
+        case IR_MOD:
+        case IR_ARRAY_ACCESS:
+        case IR_FTOI:
+            return IR_TYPE_ENTIER;
+        case IR_ITOF:
+            return IR_TYPE_REEL;
+        case IR_NOT:
+        case IR_EQ:
+        case IR_NEQ:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_AND:
+        case IR_OR:
+            return IR_TYPE_BOOLEEN;
+        case IR_CALL:
+            return call_type(ctx, inst);
+        default:
+            return IR_TYPE_UNKNOWN;
+    }
+}
+
+static void env_init(TypeEnv* env, const char* body, IrDecl* decls, IrFunction* func) {
+    ir_name_map_init(&env->types, 32);
+    ir_name_map_init(&env->fixed, 16);
+    env->body = body;
+    for (IrDecl* d = decls; d; d = d->next) {
+        ir_name_map_set(&env->types, d->name, d->type);
+        ir_name_map_set(&env->fixed, d->name, 1);
+    }
+    for (int i = 0; func && i < func->param_count; i++) {
+        ir_name_map_set(&env->types, func->params[i], func->param_types[i]);
+        ir_name_map_set(&env->fixed, func->params[i], 1);
+    }
+}
+
+static void env_free(TypeEnv* env) {
+    ir_name_map_free(&env->types);
+    ir_name_map_free(&env->fixed);
+}
+
+// Propagates types through a body until nothing changes.
+static void infer_body(const TypeCtx* ctx, TypeEnv* env, IrInstruction* list, int formal_count) {
+    for (int round = 0; round < TYPES_MAX_ROUNDS; round++) {
+        int changed = 0;
+        int formals_left = formal_count;
+        for (IrInstruction* inst = list; inst; inst = inst->next) {
+            if (inst->op == IR_FUNC_BEGIN) continue;
+            if (inst->op == IR_PARAM && formals_left > 0) {
+                formals_left--;
+                continue;
+            }
+            formals_left = 0;
+            const char* def = ir_inst_def(inst);
+            if (!def || ir_name_map_get(&env->fixed, def, 0)) continue;
+            int* slot = ir_name_map_slot(&env->types, def);
+            IrType joined = join((IrType)*slot, value_type(ctx, env, inst));
+            if (joined != (IrType)*slot) {
+                *slot = joined;
+                changed = 1;
+            }
+        }
+        if (!changed) break;
+    }
+}
+
+// Join of the values a function returns (a bare `return` yields an entier).
+static IrType returned_type(const TypeEnv* env, const IrFunction* func) {
+    IrType type = IR_TYPE_UNKNOWN;
+    for (IrInstruction* inst = func->instructions; inst; inst = inst->next) {
+        if (inst->op != IR_RETURN) continue;
+        IrType t = inst->arg1 ? operand_type(env, inst->arg1) : IR_TYPE_ENTIER;
+        type = join(type, t);
+    }
+    return type;
+}
+
+// ---------- rewriting ----------
+
+typedef struct {
+    TypeCtx* ctx;
+    TypeEnv* env;
+    IrInstruction** out;
+    int count;
+    int capacity;
+} Rewriter;
+
+static void push(Rewriter* rw, IrInstruction* inst) {
+    if (rw->count >= rw->capacity) {
+        rw->capacity = rw->capacity ? rw->capacity * 2 : 64;
+        rw->out = realloc(rw->out, sizeof(IrInstruction*) * (size_t)rw->capacity);
+    }
+    rw->out[rw->count++] = inst;
+}
+
+static void type_error(Rewriter* rw, const char* message, IrType a, IrType b) {
+    fprintf(stderr, "erreur de type (%s): %s (%s, %s)\n",
+            rw->env->body, message, ir_type_name(a), ir_type_name(b));
+    rw->ctx->errors++;
+}
+
+static IrInstruction* make_conversion(IrOpType op, char* result, char* source) {
+    IrInstruction* conv = create_instruction(op);
+    conv->result = result;
+    conv->arg1 = source;
+    conv->type = op == IR_ITOF ? IR_TYPE_REEL : IR_TYPE_ENTIER;
+    return conv;
+}
+
+// Makes *operand a value of type `to`, emitting a conversion ahead of the
+// current instruction when needed.
+static void coerce(Rewriter* rw, char** operand, IrType to, IrInstruction* at) {
+    IrType from = operand_type(rw->env, *operand);
+    if (from == to || from == IR_TYPE_UNKNOWN || to == IR_TYPE_UNKNOWN) return;
+    if (!is_numeric(from) || !is_numeric(to)) {
+        // booleen -> entier is widened by the emitter; anything else is an error.
+        if (from == IR_TYPE_BOOLEEN && to == IR_TYPE_ENTIER) return;
+        type_error(rw, "types incompatibles", from, to);
+        return;
+    }
+
+    if (to == IR_TYPE_REEL && ir_is_literal(*operand)) {
+        // Integer literal used as a real: rewrite in place (`3` -> `3.0`).
+        size_t len = strlen(*operand);
+        char* real = malloc(len + 3);
+        memcpy(real, *operand, len);
+        memcpy(real + len, ".0", 3);
+        free(*operand);
+        *operand = real;
+        return;
+    }
+    if (to == IR_TYPE_ENTIER) {
+        fprintf(stderr, "warning: %s: conversion implicite reel -> entier (troncature) de %s\n",
+                rw->env->body, *operand);
+    }
+    char* temp = new_temp(rw->ctx->program);
+    IrInstruction* conv = make_conversion(to == IR_TYPE_REEL ? IR_ITOF : IR_FTOI, strdup(temp), *operand);
+    conv->line = at->line;
+    push(rw, conv);
+    ir_name_map_set(&rw->env->types, temp, to);
+    *operand = temp;
+}
+
+static void rewrite_body(Rewriter* rw, IrInstruction** head, IrFunction* func) {
+    TypeEnv* env = rw->env;
+    int count = ir_count_instructions(*head);
+    IrInstruction** insts = malloc(sizeof(IrInstruction*) * (size_t)(count + 1));
+    int i = 0;
+    for (IrInstruction* inst = *head; inst; inst = inst->next) insts[i++] = inst;
+
+    // Expected type of each actual argument of a call to a user function.
+    IrType* arg_type = calloc((size_t)count + 1, sizeof(IrType));
+    int params[TYPES_MAX_ARGS];
+    for (i = 0; i < count; i++) {
+        if (insts[i]->op != IR_CALL) continue;
+        IrFunction* callee = find_function(rw->ctx, insts[i]->arg1);
+        int n = callee ? ir_call_params(insts, i, params, TYPES_MAX_ARGS) : -1;
+        for (int p = 0; p < n && p < callee->param_count; p++) arg_type[params[p]] = callee->param_types[p];
+    }
+
+    int formals_left = func ? func->param_count : 0;
+    rw->count = 0;
+    for (i = 0; i < count; i++) {
+        IrInstruction* inst = insts[i];
+        if (inst->op == IR_FUNC_BEGIN) {
+            push(rw, inst);
+            continue;
+        }
+        if (inst->op == IR_PARAM && formals_left > 0) {
+            inst->type = func->param_types[func->param_count - formals_left];
+            formals_left--;
+            push(rw, inst);
+            continue;
+        }
+        formals_left = 0;
+
+        IrType a = operand_type(env, inst->arg1);
+        IrType b = operand_type(env, inst->arg2);
+        switch (inst->op) {
+            case IR_ADD:
+            case IR_SUB:
+            case IR_MUL:
+            case IR_DIV:
+            case IR_NEG: {
+                IrType t = inst->op == IR_NEG ? a : join(a, b);
+                if (!is_numeric(a) || (inst->op != IR_NEG && !is_numeric(b))) {
+                    type_error(rw, "operation arithmetique sur des valeurs non numeriques", a, b);
+                    break;
+                }
+                coerce(rw, &inst->arg1, t, inst);
+                if (inst->op != IR_NEG) coerce(rw, &inst->arg2, t, inst);
+                break;
+            }
+            case IR_MOD:
+                if (a != IR_TYPE_ENTIER || b != IR_TYPE_ENTIER) type_error(rw, "mod attend deux entiers", a, b);
+                break;
+            case IR_EQ:
+            case IR_NEQ:
+            case IR_LT:
+            case IR_LE:
+            case IR_GT:
+            case IR_GE:
+                if (is_numeric(a) && is_numeric(b)) {
+                    coerce(rw, &inst->arg1, join(a, b), inst);
+                    coerce(rw, &inst->arg2, join(a, b), inst);
+                } else if (a != b && a != IR_TYPE_UNKNOWN && b != IR_TYPE_UNKNOWN) {
+                    type_error(rw, "comparaison de types incompatibles", a, b);
+                }
+                break;
+            case IR_ASSIGN:
+                coerce(rw, &inst->arg1, operand_type(env, inst->result), inst);
+                break;
+            case IR_PARAM:
+                coerce(rw, &inst->arg1, arg_type[i], inst);
+                break;
+            case IR_RETURN:
+                if (func && inst->arg1) coerce(rw, &inst->arg1, func->return_type, inst);
+                break;
+            default:
+                break;
+        }
+
+        const char* def = ir_inst_def(inst);
+        if (!def) {
+            push(rw, inst);
+            continue;
+        }
+        IrType slot = operand_type(env, def);
+        IrType computed = inst->op == IR_ASSIGN ? slot : value_type(rw->ctx, env, inst);
+        if (computed != slot && is_numeric(computed) && is_numeric(slot)) {
+            // The value has another numeric type than the name it lands in
+            // (e.g. an entier sum stored into a variable joined to reel):
+            // compute into a fresh temp, then convert into the name.
+            char* temp = new_temp(rw->ctx->program);
+            char* target = inst->result;
+            inst->result = strdup(temp);
+            inst->type = computed;
+            ir_name_map_set(&env->types, temp, computed);
+            push(rw, inst);
+            IrInstruction* conv = make_conversion(slot == IR_TYPE_REEL ? IR_ITOF : IR_FTOI, target, temp);
+            conv->line = inst->line;
+            push(rw, conv);
+            continue;
+        }
+        inst->type = slot != IR_TYPE_UNKNOWN ? slot : computed;
+        push(rw, inst);
+    }
+
+    ir_relink(head, rw->out, rw->count);
+    free(arg_type);
+    free(insts);
+}
+
+// ---------- driver ----------
+
+static void default_unknown(TypeEnv* env, IrInstruction* list) {
+    // Names nothing could type (e.g. only assigned from an unknown call).
+    for (IrInstruction* inst = list; inst; inst = inst->next) {
+        const char* def = ir_inst_def(inst);
+        if (!def) continue;
+        int* slot = ir_name_map_slot(&env->types, def);
+        if (*slot == IR_TYPE_UNKNOWN) *slot = IR_TYPE_ENTIER;
+    }
+}
+
+int ir_infer_types(IRProgram* program) {
+    if (!program) return 0;
+    return ir_infer_types_linked(&program, 1);
+}
+
+int ir_infer_types_linked(IRProgram* const* programs, int count) {
+    TypeCtx ctx = { NULL, {0}, NULL, 0, 0 };
+
+    for (int p = 0; p < count; p++) {
+        for (IrFunction* f = programs[p]->functions; f; f = f->next) ctx.function_count++;
+    }
+    ctx.functions = malloc(sizeof(IrFunction*) * (size_t)(ctx.function_count + 1));
+    ir_name_map_init(&ctx.function_index, ctx.function_count);
+    int n = 0;
+    for (int p = 0; p < count; p++) {
+        for (IrFunction* f = programs[p]->functions; f; f = f->next, n++) {
+            ctx.functions[n] = f;
+            if (p > 0 && find_function(&ctx, f->name)) {
+                fprintf(stderr, "erreur: fonction %s definie dans plusieurs fichiers\n", f->name);
+                ctx.errors++;
+            }
+            ir_name_map_set(&ctx.function_index, f->name, n);
+            for (int i = 0; i < f->param_count; i++) {
+                if (f->param_types[i] == IR_TYPE_UNKNOWN) f->param_types[i] = IR_TYPE_ENTIER;
+            }
+        }
+    }
+
+    // Return types only grow (unknown -> entier -> reel), so this settles.
+    for (int round = 0; round < TYPES_MAX_ROUNDS; round++) {
+        int changed = 0;
+        for (int i = 0; i < ctx.function_count; i++) {
+            IrFunction* f = ctx.functions[i];
+            TypeEnv env;
+            env_init(&env, f->name, f->decls, f);
+            infer_body(&ctx, &env, f->instructions, f->param_count);
+            IrType ret = join(f->return_type, returned_type(&env, f));
+            if (ret != f->return_type) {
+                f->return_type = ret;
+                changed = 1;
+            }
+            env_free(&env);
+        }
+        if (!changed) break;
+    }
+    for (int i = 0; i < ctx.function_count; i++) {
+        if (ctx.functions[i]->return_type == IR_TYPE_UNKNOWN) ctx.functions[i]->return_type = IR_TYPE_ENTIER;
+    }
+
+    // Conversions take their temporaries from the program of the body.
+    Rewriter rw = { &ctx, NULL, NULL, 0, 0 };
+    for (int p = 0; p < count; p++) {
+        IRProgram* program = programs[p];
+        ctx.program = program;
+        for (IrFunction* f = program->functions; f; f = f->next) {
+            TypeEnv env;
+            env_init(&env, f->name, f->decls, f);
+            infer_body(&ctx, &env, f->instructions, f->param_count);
+            default_unknown(&env, f->instructions);
+            rw.env = &env;
+            rewrite_body(&rw, &f->instructions, f);
+            env_free(&env);
+        }
+
+        TypeEnv env;
+        env_init(&env, "global", program->global_decls, NULL);
+        infer_body(&ctx, &env, program->global_instructions, 0);
+        default_unknown(&env, program->global_instructions);
+        rw.env = &env;
+        rewrite_body(&rw, &program->global_instructions, NULL);
+        env_free(&env);
+    }
+
+    free(rw.out);
+    free(ctx.functions);
+    ir_name_map_free(&ctx.function_index);
+    return ctx.errors;
+}
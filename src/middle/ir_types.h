@@ -0,0 +1,25 @@
+#ifndef IR_TYPES_H
+#define IR_TYPES_H
+
+#include "ir_generator.h"
+
+// Type inference and checking over the IR.
+// - Seeds every body with its declarations (`reel x`) and the formals'
+//   declared types; untyped formals and never-typed names default to entier.
+// - Propagates entier / reel / booleen / chaine through the instructions to a
+//   fixpoint; names assigned several times take the join (entier + reel = reel).
+// - Infers each function's return type from its `return` values, iterating
+//   across functions so recursive and mutually recursive calls settle.
+// - Inserts IR_ITOF / IR_FTOI where an operand, argument, return value or
+//   assignment needs another numeric type (integer literals are rewritten in
+//   place instead), and stores the final type in IrInstruction.type.
+// Type errors (e.g. chaine in arithmetic) are reported on stderr.
+// Returns the number of errors.
+int ir_infer_types(IRProgram* program);
+
+// Same over programs compiled together (one per source file), whose bodies
+// may call the functions of any of them. A function defined in two of them
+// is an error.
+int ir_infer_types_linked(IRProgram* const* programs, int count);
+
+#endif // IR_TYPES_H
@@ -0,0 +1,121 @@
+#include "ir_verify.h"
+#include "ir_analysis.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VERIFY_MAX_ARGS 256
+
+typedef struct {
+    const char* context;
+    const char* body;   // function name or "global"
+    int errors;
+} Verifier;
+
+static void report(Verifier* v, int index, const char* message, const char* detail) {
+    fprintf(stderr, "ir verify (%s): %s, instruction %d: %s%s%s\n",
+            v->context, v->body, index, message,
+            detail ? " " : "", detail ? detail : "");
+    v->errors++;
+}
+
+// Operands an opcode cannot do without.
+static void check_operands(Verifier* v, const IrInstruction* inst, int index) {
+    int need_result = 0, need_arg1 = 0, need_arg2 = 0, need_label = 0;
+    switch (inst->op) {
+        case IR_ASSIGN:
+        case IR_NEG:
+        case IR_NOT:
+        case IR_ITOF:
+        case IR_FTOI:
+            need_result = need_arg1 = 1;
+            break;
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+        case IR_EQ: case IR_NEQ: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_AND: case IR_OR:
+        case IR_ARRAY_ACCESS:
+        case IR_ARRAY_ASSIGN:
+            need_result = need_arg1 = need_arg2 = 1;
+            break;
+        case IR_GOTO:
+        case IR_LABEL:
+            need_label = 1;
+            break;
+        case IR_IF_GOTO:
+            need_arg1 = need_label = 1;
+            break;
+        case IR_CALL:
+        case IR_PARAM:
+        case IR_FUNC_BEGIN:
+            need_arg1 = 1;
+            break;
+        case IR_RETURN:
+        case IR_FUNC_END:
+            break;
+    }
+    if (need_result && !inst->result) report(v, index, "missing result", NULL);
+    if (need_arg1 && !inst->arg1) report(v, index, "missing first operand", NULL);
+    if (need_arg2 && !inst->arg2) report(v, index, "missing second operand", NULL);
+    if (need_label && !inst->label) report(v, index, "missing label", NULL);
+}
+
+static void verify_body(Verifier* v, const IrInstruction* list, const IrFunction* func) {
+    int count = ir_count_instructions(list);
+    IrInstruction** insts = malloc(sizeof(IrInstruction*) * (size_t)(count + 1));
+    int i = 0;
+    for (const IrInstruction* inst = list; inst; inst = inst->next) insts[i++] = (IrInstruction*)inst;
+
+    IrNameMap labels;
+    ir_name_map_init(&labels, 16);
+    for (i = 0; i < count; i++) {
+        IrInstruction* inst = insts[i];
+        check_operands(v, inst, i);
+
+        if (inst->op == IR_FUNC_BEGIN && (!func || i != 0)) report(v, i, "unexpected function begin", NULL);
+        if (inst->op == IR_FUNC_END && (!func || i != count - 1)) report(v, i, "unexpected function end", NULL);
+        if (inst->op == IR_RETURN && !func) report(v, i, "return outside of a function", NULL);
+        if (inst->op == IR_LABEL && inst->label && (*ir_name_map_slot(&labels, inst->label))++ > 0) {
+            report(v, i, "label defined twice:", inst->label);
+        }
+        if (inst->op == IR_CALL && inst->arg2) {
+            int params[VERIFY_MAX_ARGS];
+            if (ir_call_params(insts, i, params, VERIFY_MAX_ARGS) != atoi(inst->arg2)) {
+                report(v, i, "arguments not found for call to", inst->arg1 ? inst->arg1 : "?");
+            }
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        IrInstruction* inst = insts[i];
+        if ((inst->op == IR_GOTO || inst->op == IR_IF_GOTO) && inst->label &&
+            ir_name_map_get(&labels, inst->label, 0) == 0) {
+            report(v, i, "branch to undefined label", inst->label);
+        }
+    }
+
+    if (func) {
+        if (count == 0 || insts[0]->op != IR_FUNC_BEGIN) report(v, 0, "body does not start with a function begin", NULL);
+        if (count == 0 || insts[count - 1]->op != IR_FUNC_END) report(v, count, "body does not end with a function end", NULL);
+        for (int p = 0; p < func->param_count; p++) {
+            const IrInstruction* formal = p + 1 < count ? insts[p + 1] : NULL;
+            if (!formal || formal->op != IR_PARAM || !formal->arg1 || strcmp(formal->arg1, func->params[p]) != 0) {
+                report(v, p + 1, "formal parameter missing:", func->params[p]);
+            }
+        }
+    }
+
+    ir_name_map_free(&labels);
+    free(insts);
+}
+
+int ir_verify(const IRProgram* program, const char* context) {
+    if (!program) return 0;
+    Verifier v = { context ? context : "ir", "global", 0 };
+    verify_body(&v, program->global_instructions, NULL);
+    for (const IrFunction* func = program->functions; func; func = func->next) {
+        v.body = func->name;
+        verify_body(&v, func->instructions, func);
+    }
+    return v.errors;
+}
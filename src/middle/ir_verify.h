@@ -0,0 +1,16 @@
+#ifndef IR_VERIFY_H
+#define IR_VERIFY_H
+
+#include "ir_generator.h"
+
+// Structural IR checks, run by the pass manager between passes:
+// - every instruction carries the operands its opcode needs;
+// - function bodies are framed by IR_FUNC_BEGIN / IR_FUNC_END and start
+//   with their formal IR_PARAMs; the global body has neither, nor returns;
+// - labels are defined once per body and every branch target exists;
+// - each IR_CALL finds the IR_PARAMs its argument count announces.
+// Problems are reported on stderr prefixed with `context` (typically the
+// name of the pass that just ran). Returns the number of problems found.
+int ir_verify(const IRProgram* program, const char* context);
+
+#endif // IR_VERIFY_H
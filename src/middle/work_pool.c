@@ -0,0 +1,56 @@
+#include "work_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    void (*task)(void* data, int index);
+    void* data;
+    int count;
+    atomic_int next;
+} WorkPool;
+
+static void* worker_main(void* arg) {
+    WorkPool* pool = (WorkPool*)arg;
+    int index;
+    while ((index = atomic_fetch_add(&pool->next, 1)) < pool->count) {
+        pool->task(pool->data, index);
+    }
+    return NULL;
+}
+
+void work_pool_run(int count, int jobs, void (*task)(void* data, int index), void* data) {
+    if (jobs > count) jobs = count;
+    if (jobs <= 1) {
+        for (int i = 0; i < count; i++) task(data, i);
+        return;
+    }
+
+    WorkPool pool;
+    pool.task = task;
+    pool.data = data;
+    pool.count = count;
+    atomic_init(&pool.next, 0);
+
+    // The calling thread is one of the workers.
+    pthread_t* threads = malloc(sizeof(pthread_t) * (size_t)(jobs - 1));
+    int started = 0;
+    for (int t = 0; t < jobs - 1; t++) {
+        if (pthread_create(&threads[t], NULL, worker_main, &pool) != 0) {
+            fprintf(stderr, "warning: could not start worker thread, continuing with %d\n", started + 1);
+            break;
+        }
+        started++;
+    }
+    worker_main(&pool);
+    for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
+    free(threads);
+}
+
+int work_pool_default_jobs(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
@@ -0,0 +1,13 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+// Runs task(data, i) for every i in [0, count) on up to `jobs` threads.
+// Indices are handed out in increasing order; tasks must only write state
+// owned by their index. With jobs <= 1 (or a single task) everything runs
+// on the calling thread, in order.
+void work_pool_run(int count, int jobs, void (*task)(void* data, int index), void* data);
+
+// Number of online processors, at least 1. Used for `-j0`.
+int work_pool_default_jobs(void);
+
+#endif // WORK_POOL_H
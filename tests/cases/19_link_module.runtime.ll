@@ -0,0 +1,14 @@
+; Precompiled "runtime" module linked into 19_link_module by the test flags.
+; Its constructor runs before the program's main. Written with typed
+; pointers, which every supported LLVM reads (15 and later as `ptr`).
+
+@banner = private unnamed_addr constant [13 x i8] c"runtime pret\00"
+
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @rt_init, i8* null }]
+
+declare i32 @puts(i8*)
+
+define internal void @rt_init() {
+  %1 = call i32 @puts(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @banner, i64 0, i64 0))
+  ret void
+}
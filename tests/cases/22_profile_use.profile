@@ -0,0 +1,7 @@
+# cyplang profile
+fonction pas 19 0 1
+0 0
+fonction main 47 1 3
+200 1
+8418 200
+5659 2759
@@ -5,6 +5,20 @@
 #   ./tests/run.sh              run all tests, exit 1 on first failure
 #   UPDATE=1 ./tests/run.sh     regenerate all .expected files (USE WITH CARE)
 #   ./tests/run.sh foo bar      run only tests matching "foo" or "bar"
+#
+# A case may carry extra command-line flags in NAME.flags (e.g. "-O1").
+# When the first flag is "run", the case is interpreted with `cyplang run`
+# and the rest of the flags follow the file name; "compile" likewise runs
+# `cyplang compile`. When it is "exe", the case is compiled with
+# `cyplang compile --emit=exe` and the executable's output is compared
+# instead. Each line of NAME.flags is one run; the outputs of the runs are
+# compared, one after the other, against NAME.expected.
+#
+# The reference .expected files come from an LLVM with opaque pointers
+# (15 and later). When cyplang is built against one that still prints typed
+# pointers (LLVM 14), a NAME.typed.expected next to the case is used
+# instead, if there is one; UPDATE=1 then writes that file, only for the
+# cases whose output differs from NAME.expected.
 
 set -u
 
@@ -24,6 +38,53 @@ if [ ! -d "$CASES_DIR" ]; then
     exit 2
 fi
 
+# Typed pointers: the IR of a string print spells `i8*`.
+typed=0
+probe_dir="$(mktemp -d)"
+printf 'afficher("%%s", "x")\n' > "$probe_dir/probe.cyp"
+if "$CYPLANG" compile "$probe_dir/probe.cyp" --emit=llvm -o - 2>/dev/null | grep -q 'i8\*'; then
+    typed=1
+fi
+rm -rf "$probe_dir"
+
+# Runs the case `$1` (a file of $CASES_DIR) with the flags that follow, as
+# one line of its .flags file reads, and prints everything it prints.
+run_flags() {
+    local bn="$1"
+    shift
+    local flags=("$@")
+    local args=("$bn" ${flags[@]+"${flags[@]}"})
+    if [ ${#flags[@]} -gt 0 ] && { [ "${flags[0]}" = "run" ] || [ "${flags[0]}" = "compile" ]; }; then
+        args=("${flags[0]}" "$bn" "${flags[@]:1}")
+    fi
+    local exe=""
+    if [ ${#flags[@]} -gt 0 ] && [ "${flags[0]}" = "exe" ]; then
+        exe="$(mktemp)"
+        args=(compile "$bn" --emit=exe -o "$exe" "${flags[@]:1}")
+    fi
+    (cd "$CASES_DIR" && "$CYPLANG" "${args[@]}" 2>&1 && { [ -z "$exe" ] || "$exe" 2>&1; } || true)
+    [ -n "$exe" ] && rm -f "$exe"
+}
+
+# Every run of the case `$1`.
+run_case() {
+    local cyp="$1"
+    local lines=("")
+    if [ -f "${cyp%.cyp}.flags" ]; then
+        mapfile -t lines < "${cyp%.cyp}.flags"
+    fi
+    local line flags
+    for line in "${lines[@]}"; do
+        read -r -a flags <<< "$line"
+        if [ ${#lines[@]} -eq 1 ]; then
+            run_flags "$(basename "$cyp")" ${flags[@]+"${flags[@]}"}
+        else
+            # Several runs: each one's output on lines of its own.
+            printf '%s\n' "$(run_flags "$(basename "$cyp")" ${flags[@]+"${flags[@]}"})"
+        fi
+    done
+}
+
 shopt -s nullglob
 cases=("$CASES_DIR"/*.cyp)
 if [ ${#cases[@]} -eq 0 ]; then
@@ -49,12 +110,18 @@ for cyp in "${cases[@]}"; do
     fi
 
     expected="${cyp%.cyp}.expected"
-
-    # Run from cases dir so the source path printed is just the basename (portable).
-    bn=$(basename "$cyp")
+    typed_expected="${cyp%.cyp}.typed.expected"
+    if [ $typed -eq 1 ] && [ -f "$typed_expected" ]; then
+        expected="$typed_expected"
+    fi
 
     if [ "${UPDATE:-0}" = "1" ]; then
-        (cd "$CASES_DIR" && "$CYPLANG" "$bn") > "$expected" 2>&1 || true
+        target="${cyp%.cyp}.expected"
+        [ $typed -eq 1 ] && target="$typed_expected"
+        run_case "$cyp" > "$target"
+        if [ $typed -eq 1 ] && cmp -s "$target" "${cyp%.cyp}.expected"; then
+            rm -f "$target"    # same as the reference: no variant needed
+        fi
         echo "  UPDATED  $name"
         continue
     fi
@@ -65,7 +132,8 @@ for cyp in "${cases[@]}"; do
         continue
     fi
 
-    actual=$(cd "$CASES_DIR" && "$CYPLANG" "$bn" 2>&1 || true)
+    # Run from cases dir so the source path printed is just the basename (portable).
+    actual=$(run_case "$cyp")
     expected_content=$(cat "$expected")
 
     if [ "$actual" = "$expected_content" ]; then